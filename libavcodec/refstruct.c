@@ -180,6 +180,11 @@ int ff_refstruct_exclusive(const void *obj)
     return atomic_load_explicit((atomic_uintptr_t*)&ref->refcount, memory_order_acquire) == 1;
 }
 
+/**
+ * Number of lock-free slots for available entries in each pool.
+ */
+#define POOL_CACHE_SIZE 16
+
 struct FFRefStructPool {
     size_t size;
     FFRefStructOpaque opaque;
@@ -188,7 +193,7 @@ struct FFRefStructPool {
     void (*free_entry_cb)(FFRefStructOpaque opaque, void *obj);
     void (*free_cb)(FFRefStructOpaque opaque);
 
-    int uninited;
+    atomic_int uninited;
     unsigned entry_flags;
     unsigned pool_flags;
 
@@ -203,10 +208,50 @@ struct FFRefStructPool {
      */
     RefCount *available_entries;
     AVMutex mutex;
+    /**
+     * Available entries (RefCount pointers, 0 for an empty slot) which can
+     * be taken and returned without locking the mutex. They are only
+     * used as long as the pool has not been uninited.
+     */
+    atomic_uintptr_t cache[POOL_CACHE_SIZE];
 };
 
+static RefCount *pool_cache_get(FFRefStructPool *pool)
+{
+    for (int i = 0; i < POOL_CACHE_SIZE; i++) {
+        if (atomic_load_explicit(&pool->cache[i], memory_order_relaxed)) {
+            uintptr_t ref = atomic_exchange_explicit(&pool->cache[i], 0,
+                                                     memory_order_acquire);
+            if (ref)
+                return (RefCount *)ref;
+        }
+    }
+    return NULL;
+}
+
+static int pool_cache_put(FFRefStructPool *pool, RefCount *ref)
+{
+    for (int i = 0; i < POOL_CACHE_SIZE; i++) {
+        uintptr_t empty = 0;
+        if (atomic_compare_exchange_strong_explicit(&pool->cache[i], &empty,
+                                                    (uintptr_t)ref,
+                                                    memory_order_release,
+                                                    memory_order_relaxed))
+            return 1;
+    }
+    return 0;
+}
+
+static void pool_free_entry(FFRefStructPool *pool, RefCount *ref);
+
 static void pool_free(FFRefStructPool *pool)
 {
+    RefCount *ref;
+
+    /* entries returned while the pool was being uninited */
+    while ((ref = pool_cache_get(pool)))
+        pool_free_entry(pool, ref);
+
     ff_mutex_destroy(&pool->mutex);
     if (pool->free_cb)
         pool->free_cb(pool->opaque);
@@ -225,13 +270,18 @@ static void pool_return_entry(void *ref_)
     RefCount *ref = ref_;
     FFRefStructPool *pool = ref->opaque.nc;
 
-    ff_mutex_lock(&pool->mutex);
-    if (!pool->uninited) {
-        ref->opaque.nc = pool->available_entries;
-        pool->available_entries = ref;
+    if (!atomic_load_explicit(&pool->uninited, memory_order_relaxed) &&
+        pool_cache_put(pool, ref)) {
         ref = NULL;
+    } else {
+        ff_mutex_lock(&pool->mutex);
+        if (!pool->uninited) {
+            ref->opaque.nc = pool->available_entries;
+            pool->available_entries = ref;
+            ref = NULL;
+        }
+        ff_mutex_unlock(&pool->mutex);
     }
-    ff_mutex_unlock(&pool->mutex);
 
     if (ref)
         pool_free_entry(pool, ref);
@@ -250,22 +300,26 @@ static void pool_reset_entry(FFRefStructOpaque opaque, void *entry)
 static int refstruct_pool_get_ext(void *datap, FFRefStructPool *pool)
 {
     void *ret = NULL;
+    RefCount *ref;
 
     memcpy(datap, &(void *){ NULL }, sizeof(void*));
 
-    ff_mutex_lock(&pool->mutex);
     ff_assert(!pool->uninited);
-    if (pool->available_entries) {
-        RefCount *ref = pool->available_entries;
+    ref = pool_cache_get(pool);
+    if (!ref) {
+        ff_mutex_lock(&pool->mutex);
+        ref = pool->available_entries;
+        if (ref)
+            pool->available_entries = ref->opaque.nc;
+        ff_mutex_unlock(&pool->mutex);
+    }
+    if (ref) {
         ret = get_userdata(ref);
-        pool->available_entries = ref->opaque.nc;
         ref->opaque.nc = pool;
         atomic_init(&ref->refcount, 1);
     }
-    ff_mutex_unlock(&pool->mutex);
 
     if (!ret) {
-        RefCount *ref;
         ret = ff_refstruct_alloc_ext(pool->size, pool->entry_flags, pool,
                                      pool->reset_cb ? pool_reset_entry : NULL);
         if (!ret)
@@ -320,7 +374,7 @@ static void refstruct_pool_uninit(FFRefStructOpaque unused, void *obj)
 
     ff_mutex_lock(&pool->mutex);
     ff_assert(!pool->uninited);
-    pool->uninited = 1;
+    atomic_store_explicit(&pool->uninited, 1, memory_order_relaxed);
     entry = pool->available_entries;
     pool->available_entries = NULL;
     ff_mutex_unlock(&pool->mutex);
@@ -330,6 +384,8 @@ static void refstruct_pool_uninit(FFRefStructOpaque unused, void *obj)
         pool_free_entry(pool, entry);
         entry = next;
     }
+    while ((entry = pool_cache_get(pool)))
+        pool_free_entry(pool, entry);
 }
 
 FFRefStructPool *ff_refstruct_pool_alloc(size_t size, unsigned flags)
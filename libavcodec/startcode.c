@@ -56,3 +56,33 @@ int ff_startcode_find_candidate_c(const uint8_t *buf, int size)
             break;
     return i;
 }
+
+int ff_startcode_find_escape(const uint8_t *buf, int size)
+{
+    int i = 0;
+
+    while (i + 2 < size) {
+        /* every sequence we look for starts with a zero byte */
+#if HAVE_FAST_UNALIGNED
+#if HAVE_FAST_64BIT
+        while (i + 8 <= size &&
+               !((~AV_RN64(buf + i) &
+                  (AV_RN64(buf + i) - 0x0101010101010101ULL)) &
+                 0x8080808080808080ULL))
+            i += 8;
+#else
+        while (i + 4 <= size &&
+               !((~AV_RN32(buf + i) &
+                  (AV_RN32(buf + i) - 0x01010101U)) &
+                 0x80808080U))
+            i += 4;
+#endif
+#endif
+        if (i + 2 >= size)
+            break;
+        if (!buf[i] && !buf[i + 1] && buf[i + 2] <= 3)
+            return i;
+        i++;
+    }
+    return size;
+}
@@ -33,4 +33,12 @@ const uint8_t *avpriv_find_start_code(const uint8_t *p,
 
 int ff_startcode_find_candidate_c(const uint8_t *buf, int size);
 
+/**
+ * Find the first occurrence of the byte sequence 0x00 0x00 0x0n with n <= 3,
+ * i.e. an H.264/H.265/H.266 start code or emulation prevention candidate.
+ *
+ * @return offset of the sequence in buf, or size if there is none
+ */
+int ff_startcode_find_escape(const uint8_t *buf, int size);
+
 #endif /* AVCODEC_STARTCODE_H */
@@ -0,0 +1,88 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/lfg.h"
+
+#include "libavcodec/defs.h"
+#include "libavcodec/startcode.h"
+
+#define SIZE 320
+
+static int find_escape_ref(const uint8_t *buf, int size)
+{
+    for (int i = 0; i + 2 < size; i++)
+        if (!buf[i] && !buf[i + 1] && buf[i + 2] <= 3)
+            return i;
+    return size;
+}
+
+int main(void)
+{
+    uint8_t buf[SIZE + AV_INPUT_BUFFER_PADDING_SIZE];
+    AVLFG lfg;
+    int ret = 0;
+
+    av_lfg_init(&lfg, 0xdeadbeef);
+
+    for (int i = 0; i < 4096; i++) {
+        /* unaligned start, sizes covering partial words */
+        int offset = av_lfg_get(&lfg) % 32;
+        int size   = av_lfg_get(&lfg) % (SIZE - offset + 1);
+        uint8_t *p = buf + offset;
+        int ref, res;
+
+        /* lots of single zeros and 00 00 xx with xx > 3 to catch false
+         * positives, then escapes at random or edge positions */
+        for (int j = 0; j < SIZE; j++)
+            buf[j] = av_lfg_get(&lfg) & 1 ? av_lfg_get(&lfg) | 4 : 0;
+        for (int j = 0; j + 3 <= SIZE; j += 3 + av_lfg_get(&lfg) % 8) {
+            buf[j] = buf[j + 1] = 0;
+            buf[j + 2] = 4 + av_lfg_get(&lfg) % 252;
+        }
+        memset(buf + SIZE, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+
+        if (i & 1) {
+            int pos;
+            switch ((i >> 1) % 6) {
+            case 0:  pos = 0;                              break;
+            case 1:  pos = size - 3;                       break;
+            case 2:  pos = size - 2;                       break; /* incomplete, must not match */
+            case 3:  pos = 6;                              break; /* straddles a word */
+            case 4:  pos = 7;                              break;
+            default: pos = size ? av_lfg_get(&lfg) % size : 0;
+            }
+            if (pos >= 0 && pos + 3 <= SIZE - offset) {
+                p[pos] = p[pos + 1] = 0;
+                p[pos + 2] = av_lfg_get(&lfg) & 3;
+            }
+        }
+
+        ref = find_escape_ref(p, size);
+        res = ff_startcode_find_escape(p, size);
+        if (ref != res) {
+            fprintf(stderr, "offset %d size %d: %d != %d\n", offset, size, res, ref);
+            ret = 1;
+        }
+    }
+
+    return ret;
+}
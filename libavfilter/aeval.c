@@ -72,6 +72,9 @@ typedef struct EvalContext {
     uint64_t n;
     double var_values[VAR_VARS_NB];
     double *channel_values;
+    int use_val;                ///< an expression uses val(), evaluate sample by sample
+    double *sample_values[VAR_VARS_NB]; ///< per sample values of n and t
+    int nb_sample_values;
 } EvalContext;
 
 static double val(void *priv, double ch)
@@ -109,6 +112,7 @@ static int parse_channel_expressions(AVFilterContext *ctx,
     char *expr, *last_expr = NULL, *buf;
     double (* const *func1)(void *, double) = NULL;
     const char * const *func1_names = NULL;
+    unsigned use_val = 0;
     int i, ret = 0;
 
     if (!args1)
@@ -135,6 +139,9 @@ static int parse_channel_expressions(AVFilterContext *ctx,
                             NULL, NULL, 0, ctx);                        \
         if (ret < 0)                                                    \
             goto end;                                                   \
+        if (func1)                                                      \
+            av_expr_count_func(eval->expr[eval->nb_channels - 1],       \
+                               &use_val, 1, 1);                         \
     } while (0)
 
     /* reset expressions */
@@ -163,6 +170,7 @@ static int parse_channel_expressions(AVFilterContext *ctx,
         ret = AVERROR(EINVAL);
         goto end;
     }
+    eval->use_val = use_val > 0;
 
 end:
     av_free(args1);
@@ -218,9 +226,44 @@ static av_cold void uninit(AVFilterContext *ctx)
     }
     av_freep(&eval->expr);
     av_freep(&eval->channel_values);
+    av_freep(&eval->sample_values[VAR_N]);
+    av_freep(&eval->sample_values[VAR_T]);
     av_channel_layout_uninit(&eval->chlayout);
 }
 
+static int alloc_sample_values(EvalContext *eval, int nb_samples)
+{
+    if (nb_samples <= eval->nb_sample_values)
+        return 0;
+
+    av_freep(&eval->sample_values[VAR_N]);
+    av_freep(&eval->sample_values[VAR_T]);
+    eval->nb_sample_values = 0;
+    eval->sample_values[VAR_N] = av_malloc_array(nb_samples, sizeof(double));
+    eval->sample_values[VAR_T] = av_malloc_array(nb_samples, sizeof(double));
+    if (!eval->sample_values[VAR_N] || !eval->sample_values[VAR_T])
+        return AVERROR(ENOMEM);
+    eval->nb_sample_values = nb_samples;
+    return 0;
+}
+
+/* evaluate the expression of each channel for all the samples at once */
+static int eval_channels(EvalContext *eval, AVFrame *out, int nb_samples, void *opaque)
+{
+    int ret;
+
+    for (int j = 0; j < out->ch_layout.nb_channels; j++) {
+        eval->var_values[VAR_CH] = j;
+        ret = av_expr_eval_batch(eval->expr[j], (double *)out->extended_data[j],
+                                 nb_samples, eval->var_values,
+                                 (const double * const *)eval->sample_values, opaque);
+        if (ret < 0)
+            return ret;
+    }
+    eval->n += nb_samples;
+    return 0;
+}
+
 static int config_props(AVFilterLink *outlink)
 {
     EvalContext *eval = outlink->src->priv;
@@ -266,7 +309,7 @@ static int activate(AVFilterContext *ctx)
     AVFilterLink *outlink = ctx->outputs[0];
     EvalContext *eval = outlink->src->priv;
     AVFrame *samplesref;
-    int i, j;
+    int i, ret;
     int64_t t = av_rescale(eval->n, AV_TIME_BASE, eval->sample_rate);
     int nb_samples;
 
@@ -291,15 +334,17 @@ static int activate(AVFilterContext *ctx)
     if (!samplesref)
         return AVERROR(ENOMEM);
 
-    /* evaluate expression for each single sample and for each channel */
-    for (i = 0; i < nb_samples; i++, eval->n++) {
-        eval->var_values[VAR_N] = eval->n;
-        eval->var_values[VAR_T] = eval->var_values[VAR_N] * (double)1/eval->sample_rate;
-
-        for (j = 0; j < eval->nb_channels; j++) {
-            *((double *) samplesref->extended_data[j] + i) =
-                av_expr_eval(eval->expr[j], eval->var_values, NULL);
-        }
+    if ((ret = alloc_sample_values(eval, nb_samples)) < 0) {
+        av_frame_free(&samplesref);
+        return ret;
+    }
+    for (i = 0; i < nb_samples; i++) {
+        eval->sample_values[VAR_N][i] = eval->n + i;
+        eval->sample_values[VAR_T][i] = eval->sample_values[VAR_N][i] * (double)1/eval->sample_rate;
+    }
+    if ((ret = eval_channels(eval, samplesref, nb_samples, NULL)) < 0) {
+        av_frame_free(&samplesref);
+        return ret;
     }
 
     samplesref->pts = eval->pts;
@@ -415,7 +460,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     int nb_samples        = in->nb_samples;
     AVFrame *out;
     double t0;
-    int i, j;
+    int i, j, ret;
 
     out = ff_get_audio_buffer(outlink, nb_samples);
     if (!out) {
@@ -426,6 +471,19 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 
     t0 = TS2T(in->pts, inlink->time_base);
 
+    if (!eval->use_val) {
+        if ((ret = alloc_sample_values(eval, nb_samples)) < 0)
+            goto fail;
+        for (i = 0; i < nb_samples; i++) {
+            eval->sample_values[VAR_N][i] = eval->n + i;
+            eval->sample_values[VAR_T][i] = t0 + i * (double)1/inlink->sample_rate;
+        }
+        if ((ret = eval_channels(eval, out, nb_samples, eval)) < 0)
+            goto fail;
+        av_frame_free(&in);
+        return ff_filter_frame(outlink, out);
+    }
+
     /* evaluate expression for each single sample and for each channel */
     for (i = 0; i < nb_samples; i++, eval->n++) {
         eval->var_values[VAR_N] = eval->n;
@@ -443,6 +501,10 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 
     av_frame_free(&in);
     return ff_filter_frame(outlink, out);
+fail:
+    av_frame_free(&in);
+    av_frame_free(&out);
+    return ret;
 }
 
 #if CONFIG_AEVAL_FILTER
@@ -20,6 +20,7 @@
 
 /* http://k.ylo.ph/2016/04/04/loudnorm.html */
 
+#include "libavutil/fifo.h"
 #include "libavutil/mem.h"
 #include "libavutil/opt.h"
 #include "avfilter.h"
@@ -33,6 +34,7 @@ enum FrameType {
     INNER_FRAME,
     FINAL_FRAME,
     LINEAR_MODE,
+    LOOKAHEAD_MODE,
     FRAME_NB
 };
 
@@ -64,6 +66,7 @@ typedef struct LoudNormContext {
     int linear;
     int dual_mono;
     enum PrintFormat print_format;
+    int64_t lookahead;
 
     double *buf;
     int buf_size;
@@ -95,6 +98,12 @@ typedef struct LoudNormContext {
 
     FFEBUR128State *r128_in;
     FFEBUR128State *r128_out;
+
+    AVFifo *lookahead_fifo;
+    int64_t lookahead_samples;
+    int nb_measured_frames;
+    int eof;
+    int64_t eof_pts;
 } LoudNormContext;
 
 #define OFFSET(x) offsetof(LoudNormContext, x)
@@ -121,11 +130,29 @@ static const AVOption loudnorm_options[] = {
     {     "none",         0,                                   0,                        AV_OPT_TYPE_CONST,   {.i64 =  NONE},     0,         0,  FLAGS, .unit = "print_format" },
     {     "json",         0,                                   0,                        AV_OPT_TYPE_CONST,   {.i64 =  JSON},     0,         0,  FLAGS, .unit = "print_format" },
     {     "summary",      0,                                   0,                        AV_OPT_TYPE_CONST,   {.i64 =  SUMMARY},  0,         0,  FLAGS, .unit = "print_format" },
+    { "lookahead",        "measure this much input before normalizing linearly", OFFSET(lookahead), AV_OPT_TYPE_DURATION, {.i64 = 0}, 0, 600000000, FLAGS },
     { NULL }
 };
 
 AVFILTER_DEFINE_CLASS(loudnorm);
 
+static double max_peak(FFEBUR128State *st, int channels)
+{
+    int (*get_peak)(FFEBUR128State *st, unsigned int channel, double *out);
+    double peak = 0.;
+
+    get_peak = (st->mode & FF_EBUR128_MODE_TRUE_PEAK) == FF_EBUR128_MODE_TRUE_PEAK ?
+               ff_ebur128_true_peak : ff_ebur128_sample_peak;
+    for (int c = 0; c < channels; c++) {
+        double tmp;
+        get_peak(st, c, &tmp);
+        if (c == 0 || tmp > peak)
+            peak = tmp;
+    }
+
+    return peak;
+}
+
 static inline int frame_size(int sample_rate, int frame_len_msec)
 {
     const int frame_size = round((double)sample_rate * (frame_len_msec / 1000.0));
@@ -441,18 +468,17 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     buf = s->buf;
     limiter_buf = s->limiter_buf;
 
-    ff_ebur128_add_frames_double(s->r128_in, src, in->nb_samples);
+    /* frames from the look-ahead window have been measured already */
+    if (s->nb_measured_frames > 0)
+        s->nb_measured_frames--;
+    else
+        ff_ebur128_add_frames_double(s->r128_in, src, in->nb_samples);
 
     if (s->frame_type == FIRST_FRAME && in->nb_samples < frame_size(inlink->sample_rate, 3000)) {
         double offset, offset_tp, true_peak;
 
         ff_ebur128_loudness_global(s->r128_in, &global);
-        for (c = 0; c < inlink->ch_layout.nb_channels; c++) {
-            double tmp;
-            ff_ebur128_sample_peak(s->r128_in, c, &tmp);
-            if (c == 0 || tmp > true_peak)
-                true_peak = tmp;
-        }
+        true_peak = max_peak(s->r128_in, inlink->ch_layout.nb_channels);
 
         offset    = pow(10., (s->target_i - global) / 20.);
         offset_tp = true_peak * offset;
@@ -675,6 +701,70 @@ static int flush_frame(AVFilterLink *outlink)
     return ret;
 }
 
+static void end_lookahead(AVFilterContext *ctx)
+{
+    LoudNormContext *s = ctx->priv;
+    double global, true_peak, offset = 1.;
+
+    ff_ebur128_loudness_global(s->r128_in, &global);
+    true_peak = max_peak(s->r128_in, s->channels);
+
+    if (global > -70.)
+        offset = pow(10., (s->target_i - global) / 20.);
+    if (true_peak * offset > s->target_tp)
+        offset = s->target_tp / true_peak;
+
+    av_log(ctx, AV_LOG_VERBOSE, "Measured %.2f LUFS, %.2f dBTP over %.2f s, gain %.2f dB\n",
+           global, 20. * log10(true_peak), (double)s->lookahead_samples / ctx->inputs[0]->sample_rate,
+           20. * log10(offset));
+
+    s->offset = offset;
+    s->frame_type = LINEAR_MODE;
+    ff_filter_set_ready(ctx, 100);
+}
+
+static int lookahead(AVFilterContext *ctx)
+{
+    AVFilterLink *inlink = ctx->inputs[0];
+    AVFilterLink *outlink = ctx->outputs[0];
+    LoudNormContext *s = ctx->priv;
+    AVFrame *in;
+    int ret, status;
+    int64_t pts;
+
+    ret = ff_inlink_consume_frame(inlink, &in);
+    if (ret < 0)
+        return ret;
+    if (ret > 0) {
+        ret = av_fifo_write(s->lookahead_fifo, &in, 1);
+        if (ret < 0) {
+            av_frame_free(&in);
+            return ret;
+        }
+
+        ff_ebur128_add_frames_double(s->r128_in, (const double *)in->data[0], in->nb_samples);
+        s->nb_measured_frames++;
+        s->lookahead_samples += in->nb_samples;
+
+        if (av_rescale(s->lookahead_samples, AV_TIME_BASE, inlink->sample_rate) >= s->lookahead)
+            end_lookahead(ctx);
+        else
+            ff_filter_set_ready(ctx, 10);
+        return 0;
+    }
+
+    if (ff_inlink_acknowledge_status(inlink, &status, &pts)) {
+        s->eof = status;
+        s->eof_pts = pts;
+        end_lookahead(ctx);
+        return 0;
+    }
+
+    FF_FILTER_FORWARD_WANTED(outlink, inlink);
+
+    return FFERROR_NOT_READY;
+}
+
 static int activate(AVFilterContext *ctx)
 {
     AVFilterLink *inlink = ctx->inputs[0];
@@ -686,6 +776,23 @@ static int activate(AVFilterContext *ctx)
 
     FF_FILTER_FORWARD_STATUS_BACK(outlink, inlink);
 
+    if (s->frame_type == LOOKAHEAD_MODE)
+        return lookahead(ctx);
+
+    if (s->lookahead_fifo && av_fifo_read(s->lookahead_fifo, &in, 1) >= 0) {
+        s->pts[0] = in->pts;
+        ret = filter_frame(inlink, in);
+        if (ret < 0)
+            return ret;
+        ff_filter_set_ready(ctx, 100);
+        return 0;
+    }
+
+    if (s->eof) {
+        ff_outlink_set_status(outlink, s->eof, s->eof_pts);
+        return 0;
+    }
+
     if (s->frame_type != LINEAR_MODE) {
         int nb_samples;
 
@@ -744,7 +851,7 @@ static int query_formats(AVFilterContext *ctx)
     if (ret < 0)
         return ret;
 
-    if (s->frame_type == LINEAR_MODE) {
+    if (s->frame_type == LINEAR_MODE || s->frame_type == LOOKAHEAD_MODE) {
         return ff_set_common_all_samplerates(ctx);
     } else {
         return ff_set_common_samplerates_from_list(ctx, input_srate);
@@ -755,15 +862,27 @@ static int config_input(AVFilterLink *inlink)
 {
     AVFilterContext *ctx = inlink->dst;
     LoudNormContext *s = ctx->priv;
+    int peak_mode = FF_EBUR128_MODE_SAMPLE_PEAK;
 
-    s->r128_in = ff_ebur128_init(inlink->ch_layout.nb_channels, inlink->sample_rate, 0, FF_EBUR128_MODE_I | FF_EBUR128_MODE_S | FF_EBUR128_MODE_LRA | FF_EBUR128_MODE_SAMPLE_PEAK);
+    if (s->frame_type == LOOKAHEAD_MODE) {
+        s->lookahead_fifo = av_fifo_alloc2(64, sizeof(AVFrame *), AV_FIFO_FLAG_AUTO_GROW);
+        if (!s->lookahead_fifo)
+            return AVERROR(ENOMEM);
+        peak_mode = FF_EBUR128_MODE_TRUE_PEAK;
+    }
+
+    s->r128_in = ff_ebur128_init(inlink->ch_layout.nb_channels, inlink->sample_rate, 0, FF_EBUR128_MODE_I | FF_EBUR128_MODE_S | FF_EBUR128_MODE_LRA | peak_mode);
     if (!s->r128_in)
         return AVERROR(ENOMEM);
 
-    s->r128_out = ff_ebur128_init(inlink->ch_layout.nb_channels, inlink->sample_rate, 0, FF_EBUR128_MODE_I | FF_EBUR128_MODE_S | FF_EBUR128_MODE_LRA | FF_EBUR128_MODE_SAMPLE_PEAK);
+    /* measure the output peak the same way, so the reported values match */
+    s->r128_out = ff_ebur128_init(inlink->ch_layout.nb_channels, inlink->sample_rate, 0, FF_EBUR128_MODE_I | FF_EBUR128_MODE_S | FF_EBUR128_MODE_LRA | peak_mode);
     if (!s->r128_out)
         return AVERROR(ENOMEM);
 
+    ff_ebur128_set_filter_context(s->r128_in,  ctx);
+    ff_ebur128_set_filter_context(s->r128_out, ctx);
+
     if (inlink->ch_layout.nb_channels == 1 && s->dual_mono) {
         ff_ebur128_set_channel(s->r128_in,  0, FF_EBUR128_DUAL_MONO);
         ff_ebur128_set_channel(s->r128_out, 0, FF_EBUR128_DUAL_MONO);
@@ -817,6 +936,9 @@ static av_cold int init(AVFilterContext *ctx)
         }
     }
 
+    if (s->frame_type != LINEAR_MODE && s->lookahead > 0)
+        s->frame_type = LOOKAHEAD_MODE;
+
     return 0;
 }
 
@@ -824,7 +946,6 @@ static av_cold void uninit(AVFilterContext *ctx)
 {
     LoudNormContext *s = ctx->priv;
     double i_in, i_out, lra_in, lra_out, thresh_in, thresh_out, tp_in, tp_out;
-    int c;
 
     if (!s->r128_in || !s->r128_out)
         goto end;
@@ -832,22 +953,12 @@ static av_cold void uninit(AVFilterContext *ctx)
     ff_ebur128_loudness_range(s->r128_in, &lra_in);
     ff_ebur128_loudness_global(s->r128_in, &i_in);
     ff_ebur128_relative_threshold(s->r128_in, &thresh_in);
-    for (c = 0; c < s->channels; c++) {
-        double tmp;
-        ff_ebur128_sample_peak(s->r128_in, c, &tmp);
-        if ((c == 0) || (tmp > tp_in))
-            tp_in = tmp;
-    }
+    tp_in = max_peak(s->r128_in, s->channels);
 
     ff_ebur128_loudness_range(s->r128_out, &lra_out);
     ff_ebur128_loudness_global(s->r128_out, &i_out);
     ff_ebur128_relative_threshold(s->r128_out, &thresh_out);
-    for (c = 0; c < s->channels; c++) {
-        double tmp;
-        ff_ebur128_sample_peak(s->r128_out, c, &tmp);
-        if ((c == 0) || (tmp > tp_out))
-            tp_out = tmp;
-    }
+    tp_out = max_peak(s->r128_out, s->channels);
 
     switch(s->print_format) {
     case NONE:
@@ -910,6 +1021,12 @@ static av_cold void uninit(AVFilterContext *ctx)
     }
 
 end:
+    if (s->lookahead_fifo) {
+        AVFrame *frame;
+        while (av_fifo_read(s->lookahead_fifo, &frame, 1) >= 0)
+            av_frame_free(&frame);
+        av_fifo_freep2(&s->lookahead_fifo);
+    }
     if (s->r128_in)
         ff_ebur128_destroy(&s->r128_in);
     if (s->r128_out)
@@ -938,4 +1055,5 @@ const AVFilter ff_af_loudnorm = {
     FILTER_INPUTS(avfilter_af_loudnorm_inputs),
     FILTER_OUTPUTS(ff_audio_default_filterpad),
     FILTER_QUERY_FUNC(query_formats),
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -52,6 +52,7 @@
 #include "libavutil/mem.h"
 #include "libavutil/mem_internal.h"
 #include "libavutil/thread.h"
+#include "filters.h"
 
 #define CHECK_ERROR(condition, errorcode, goto_point)                          \
     if ((condition)) {                                                         \
@@ -65,6 +66,8 @@
 #define RELATIVE_GATE_FACTOR  pow(10.0, RELATIVE_GATE / 10.0)
 #define MINUS_20DB            pow(10.0, -20.0 / 10.0)
 
+#define TRUE_PEAK_TAPS 49
+
 struct FFEBUR128StateInternal {
     /** Filtered audio data (used as ring buffer). */
     double *audio_data;
@@ -93,6 +96,20 @@ struct FFEBUR128StateInternal {
     size_t short_term_frame_counter;
     /** Maximum sample peak, one per channel */
     double *sample_peak;
+    /** Maximum true peak, one per channel */
+    double *true_peak;
+    /** True peak oversampling factor. */
+    int tp_factor;
+    /** Number of taps of each phase of the true peak interpolator. */
+    int tp_taps;
+    /** Interpolator coefficients, tp_taps for each of the tp_factor phases. */
+    double *tp_coeffs;
+    /** Interpolator input history, 2 * tp_taps per channel. */
+    double *tp_history;
+    /** Position of the newest sample in the interpolator history. */
+    int tp_pos;
+    /** Filter whose slice threads are used for the channels, if any. */
+    AVFilterContext *ctx;
     /** The maximum window duration in ms. */
     unsigned long window;
     /** Data pointer array for interleaved data */
@@ -201,6 +218,45 @@ static int ebur128_init_channel_map(FFEBUR128State * st)
     return 0;
 }
 
+static int ebur128_init_true_peak(FFEBUR128State * st)
+{
+    int factor, taps, j;
+
+    if (st->samplerate < 96000)
+        factor = 4;
+    else if (st->samplerate < 192000)
+        factor = 2;
+    else
+        factor = 1;
+
+    st->d->true_peak = av_calloc(st->channels, sizeof(*st->d->true_peak));
+    if (!st->d->true_peak)
+        return AVERROR(ENOMEM);
+
+    st->d->tp_factor = factor;
+    if (factor == 1)
+        return 0;
+
+    /* polyphase windowed sinc interpolator */
+    st->d->tp_taps = taps = (TRUE_PEAK_TAPS + factor - 1) / factor;
+    st->d->tp_coeffs = av_calloc(factor * taps, sizeof(*st->d->tp_coeffs));
+    st->d->tp_history = av_calloc(st->channels * 2 * taps, sizeof(*st->d->tp_history));
+    if (!st->d->tp_coeffs || !st->d->tp_history)
+        return AVERROR(ENOMEM);
+
+    for (j = 0; j < TRUE_PEAK_TAPS; j++) {
+        double m = j - (TRUE_PEAK_TAPS - 1) / 2.0;
+        double c = 1.0;
+
+        if (fabs(m) > ALMOST_ZERO)
+            c = sin(m * M_PI / factor) / (m * M_PI / factor);
+        c *= 0.5 * (1.0 - cos(2.0 * M_PI * j / (TRUE_PEAK_TAPS - 1)));
+        st->d->tp_coeffs[(j % factor) * taps + j / factor] = c;
+    }
+
+    return 0;
+}
+
 static inline void init_histogram(void)
 {
     int i;
@@ -226,7 +282,7 @@ FFEBUR128State *ff_ebur128_init(unsigned int channels,
     st = (FFEBUR128State *) av_malloc(sizeof(*st));
     CHECK_ERROR(!st, 0, exit)
     st->d = (struct FFEBUR128StateInternal *)
-        av_malloc(sizeof(*st->d));
+        av_mallocz(sizeof(*st->d));
     CHECK_ERROR(!st->d, 0, free_state)
     st->channels = channels;
     errcode = ebur128_init_channel_map(st);
@@ -277,12 +333,20 @@ FFEBUR128State *ff_ebur128_init(unsigned int channels,
     if (ff_thread_once(&histogram_init, &init_histogram) != 0)
         goto free_short_term_block_energy_histogram;
 
+    if ((mode & FF_EBUR128_MODE_TRUE_PEAK) == FF_EBUR128_MODE_TRUE_PEAK) {
+        errcode = ebur128_init_true_peak(st);
+        CHECK_ERROR(errcode, 0, free_true_peak)
+    }
+
     st->d->data_ptrs = av_malloc_array(channels, sizeof(*st->d->data_ptrs));
-    CHECK_ERROR(!st->d->data_ptrs, 0,
-                free_short_term_block_energy_histogram);
+    CHECK_ERROR(!st->d->data_ptrs, 0, free_true_peak);
 
     return st;
 
+free_true_peak:
+    av_free(st->d->true_peak);
+    av_free(st->d->tp_coeffs);
+    av_free(st->d->tp_history);
 free_short_term_block_energy_histogram:
     av_free(st->d->short_term_block_energy_histogram);
 free_block_energy_histogram:
@@ -308,60 +372,111 @@ void ff_ebur128_destroy(FFEBUR128State ** st)
     av_free((*st)->d->audio_data);
     av_free((*st)->d->channel_map);
     av_free((*st)->d->sample_peak);
+    av_free((*st)->d->true_peak);
+    av_free((*st)->d->tp_coeffs);
+    av_free((*st)->d->tp_history);
     av_free((*st)->d->data_ptrs);
     av_free((*st)->d);
     av_free(*st);
     *st = NULL;
 }
 
+typedef struct ThreadData {
+    FFEBUR128State *st;
+    const void **srcs;
+    size_t src_index;
+    size_t frames;
+    int stride;
+} ThreadData;
+
 #define EBUR128_FILTER(type, scaling_factor)                                       \
-static void ebur128_filter_##type(FFEBUR128State* st, const type** srcs,           \
-                                  size_t src_index, size_t frames,                 \
-                                  int stride) {                                    \
+static void ebur128_filter_channel_##type(FFEBUR128State* st, const type* src,     \
+                                          size_t frames, int stride, size_t c) {   \
     double* audio_data = st->d->audio_data + st->d->audio_data_index;              \
-    size_t i, c;                                                                   \
+    const double *a = st->d->a, *b = st->d->b;                                     \
+    double v0, v1, v2, v3, v4;                                                     \
+    size_t i;                                                                      \
+    int ci;                                                                        \
                                                                                    \
     if ((st->mode & FF_EBUR128_MODE_SAMPLE_PEAK) == FF_EBUR128_MODE_SAMPLE_PEAK) { \
-        for (c = 0; c < st->channels; ++c) {                                       \
-            double max = 0.0;                                                      \
-            for (i = 0; i < frames; ++i) {                                         \
-                type v = srcs[c][src_index + i * stride];                          \
-                if (v > max) {                                                     \
-                    max =        v;                                                \
-                } else if (-v > max) {                                             \
-                    max = -1.0 * v;                                                \
-                }                                                                  \
+        double max = 0.0;                                                          \
+        for (i = 0; i < frames; ++i) {                                             \
+            type v = src[i * stride];                                              \
+            if (v > max) {                                                         \
+                max =        v;                                                    \
+            } else if (-v > max) {                                                 \
+                max = -1.0 * v;                                                    \
             }                                                                      \
-            max /= scaling_factor;                                                 \
-            if (max > st->d->sample_peak[c]) st->d->sample_peak[c] = max;          \
         }                                                                          \
+        max /= scaling_factor;                                                     \
+        if (max > st->d->sample_peak[c]) st->d->sample_peak[c] = max;              \
     }                                                                              \
-    for (c = 0; c < st->channels; ++c) {                                           \
-        int ci = st->d->channel_map[c] - 1;                                        \
-        if (ci < 0) continue;                                                      \
-        else if (ci == FF_EBUR128_DUAL_MONO - 1) ci = 0; /*dual mono */            \
+    if (st->d->tp_history) {                                                       \
+        const int taps = st->d->tp_taps;                                           \
+        double *hist = st->d->tp_history + 2 * taps * c;                           \
+        double max = st->d->true_peak[c];                                          \
+        int pos = st->d->tp_pos;                                                   \
         for (i = 0; i < frames; ++i) {                                             \
-            st->d->v[ci][0] = (double) (srcs[c][src_index + i * stride] / scaling_factor) \
-                         - st->d->a[1] * st->d->v[ci][1]                           \
-                         - st->d->a[2] * st->d->v[ci][2]                           \
-                         - st->d->a[3] * st->d->v[ci][3]                           \
-                         - st->d->a[4] * st->d->v[ci][4];                          \
-            audio_data[i * st->channels + c] =                                     \
-                           st->d->b[0] * st->d->v[ci][0]                           \
-                         + st->d->b[1] * st->d->v[ci][1]                           \
-                         + st->d->b[2] * st->d->v[ci][2]                           \
-                         + st->d->b[3] * st->d->v[ci][3]                           \
-                         + st->d->b[4] * st->d->v[ci][4];                          \
-            st->d->v[ci][4] = st->d->v[ci][3];                                     \
-            st->d->v[ci][3] = st->d->v[ci][2];                                     \
-            st->d->v[ci][2] = st->d->v[ci][1];                                     \
-            st->d->v[ci][1] = st->d->v[ci][0];                                     \
+            pos = pos ? pos - 1 : taps - 1;                                        \
+            hist[pos] = hist[pos + taps] = (double) (src[i * stride] / scaling_factor); \
+            for (int f = 0; f < st->d->tp_factor; f++) {                           \
+                const double *coeffs = st->d->tp_coeffs + f * taps;                \
+                double sum = 0.0;                                                  \
+                for (int k = 0; k < taps; k++)                                     \
+                    sum += coeffs[k] * hist[pos + k];                              \
+                max = FFMAX(max, fabs(sum));                                       \
+            }                                                                      \
         }                                                                          \
-        st->d->v[ci][4] = fabs(st->d->v[ci][4]) < DBL_MIN ? 0.0 : st->d->v[ci][4]; \
-        st->d->v[ci][3] = fabs(st->d->v[ci][3]) < DBL_MIN ? 0.0 : st->d->v[ci][3]; \
-        st->d->v[ci][2] = fabs(st->d->v[ci][2]) < DBL_MIN ? 0.0 : st->d->v[ci][2]; \
-        st->d->v[ci][1] = fabs(st->d->v[ci][1]) < DBL_MIN ? 0.0 : st->d->v[ci][1]; \
+        st->d->true_peak[c] = max;                                                 \
     }                                                                              \
+    ci = st->d->channel_map[c] - 1;                                                \
+    if (ci < 0) return;                                                            \
+    else if (ci == FF_EBUR128_DUAL_MONO - 1) ci = 0; /*dual mono */                \
+    v1 = st->d->v[ci][1];                                                          \
+    v2 = st->d->v[ci][2];                                                          \
+    v3 = st->d->v[ci][3];                                                          \
+    v4 = st->d->v[ci][4];                                                          \
+    for (i = 0; i < frames; ++i) {                                                 \
+        v0 = (double) (src[i * stride] / scaling_factor)                           \
+             - a[1] * v1 - a[2] * v2 - a[3] * v3 - a[4] * v4;                      \
+        audio_data[i * st->channels + c] =                                         \
+             b[0] * v0 + b[1] * v1 + b[2] * v2 + b[3] * v3 + b[4] * v4;            \
+        v4 = v3;                                                                   \
+        v3 = v2;                                                                   \
+        v2 = v1;                                                                   \
+        v1 = v0;                                                                   \
+    }                                                                              \
+    st->d->v[ci][0] = v1;                                                          \
+    st->d->v[ci][4] = fabs(v4) < DBL_MIN ? 0.0 : v4;                               \
+    st->d->v[ci][3] = fabs(v3) < DBL_MIN ? 0.0 : v3;                               \
+    st->d->v[ci][2] = fabs(v2) < DBL_MIN ? 0.0 : v2;                               \
+    st->d->v[ci][1] = fabs(v1) < DBL_MIN ? 0.0 : v1;                               \
+}                                                                                  \
+                                                                                   \
+static int ebur128_filter_channels_##type(AVFilterContext *ctx, void *arg,         \
+                                          int jobnr, int nb_jobs) {                \
+    ThreadData *td = arg;                                                          \
+    for (size_t c = jobnr; c < td->st->channels; c += nb_jobs)                     \
+        ebur128_filter_channel_##type(td->st,                                      \
+                                      (const type *) td->srcs[c] + td->src_index,  \
+                                      td->frames, td->stride, c);                  \
+    return 0;                                                                      \
+}                                                                                  \
+                                                                                   \
+static void ebur128_filter_##type(FFEBUR128State* st, const type** srcs,           \
+                                  size_t src_index, size_t frames,                 \
+                                  int stride) {                                    \
+    ThreadData td = { st, (const void **) srcs, src_index, frames, stride };       \
+                                                                                   \
+    if (st->d->ctx)                                                                \
+        ff_filter_execute(st->d->ctx, ebur128_filter_channels_##type, &td, NULL,   \
+                          FFMIN(st->channels,                                      \
+                                ff_filter_get_nb_threads(st->d->ctx)));            \
+    else                                                                           \
+        ebur128_filter_channels_##type(NULL, &td, 0, 1);                           \
+    if (st->d->tp_history)                                                         \
+        st->d->tp_pos = (st->d->tp_pos + st->d->tp_taps -                          \
+                         frames % st->d->tp_taps) % st->d->tp_taps;                \
 }
 EBUR128_FILTER(double, 1.0)
 
@@ -442,6 +557,11 @@ static void ebur128_calc_gating_block(FFEBUR128State * st,
     }
 }
 
+void ff_ebur128_set_filter_context(FFEBUR128State * st, AVFilterContext *ctx)
+{
+    st->d->ctx = ctx;
+}
+
 int ff_ebur128_set_channel(FFEBUR128State * st,
                            unsigned int channel_number, int value)
 {
@@ -723,3 +843,17 @@ int ff_ebur128_sample_peak(FFEBUR128State * st,
     *out = st->d->sample_peak[channel_number];
     return 0;
 }
+
+int ff_ebur128_true_peak(FFEBUR128State * st,
+                         unsigned int channel_number, double *out)
+{
+    if ((st->mode & FF_EBUR128_MODE_TRUE_PEAK) !=
+        FF_EBUR128_MODE_TRUE_PEAK) {
+        return AVERROR(EINVAL);
+    } else if (channel_number >= st->channels) {
+        return AVERROR(EINVAL);
+    }
+    *out = FFMAX(st->d->true_peak[channel_number],
+                 st->d->sample_peak[channel_number]);
+    return 0;
+}
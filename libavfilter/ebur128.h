@@ -91,10 +91,13 @@ enum mode {
     FF_EBUR128_MODE_LRA = (1 << 3) | FF_EBUR128_MODE_S,
   /** can call ff_ebur128_sample_peak */
     FF_EBUR128_MODE_SAMPLE_PEAK = (1 << 4) | FF_EBUR128_MODE_M,
+  /** can call ff_ebur128_true_peak */
+    FF_EBUR128_MODE_TRUE_PEAK = (1 << 5) | FF_EBUR128_MODE_SAMPLE_PEAK,
 };
 
 /** forward declaration of FFEBUR128StateInternal */
 struct FFEBUR128StateInternal;
+struct AVFilterContext;
 
 /** \brief Contains information about the state of a loudness measurement.
  *
@@ -125,6 +128,19 @@ FFEBUR128State *ff_ebur128_init(unsigned int channels,
  */
 void ff_ebur128_destroy(FFEBUR128State ** st);
 
+/** \brief Filter the channels in parallel.
+ *
+ *  Makes ff_ebur128_add_frames_double() run the per-channel filtering and
+ *  peak measurement with the slice threads of the given filter. The results
+ *  are the same as without threading.
+ *
+ *  @param st library state.
+ *  @param ctx filter whose threads are used, or NULL to filter all channels
+ *             in the calling thread.
+ */
+void ff_ebur128_set_filter_context(FFEBUR128State * st,
+                                   struct AVFilterContext *ctx);
+
 /** \brief Set channel type.
  *
  *  The default is:
@@ -216,6 +232,22 @@ int ff_ebur128_loudness_range_multiple(FFEBUR128State ** sts,
 int ff_ebur128_sample_peak(FFEBUR128State * st,
                            unsigned int channel_number, double *out);
 
+/** \brief Get maximum true peak of selected channel in float format.
+ *
+ *  Uses an oversampling factor of 4 for sample rates below 96 kHz, 2 below
+ *  192 kHz and 1 otherwise.
+ *
+ *  @param st library state
+ *  @param channel_number channel to analyse
+ *  @param out maximum true peak in float format (1.0 is 0 dBFS)
+ *  @return
+ *    - 0 on success.
+ *    - AVERROR(EINVAL) if mode "FF_EBUR128_MODE_TRUE_PEAK" has not been set.
+ *    - AVERROR(EINVAL) if invalid channel index.
+ */
+int ff_ebur128_true_peak(FFEBUR128State * st,
+                         unsigned int channel_number, double *out);
+
 /** \brief Get relative threshold in LUFS.
  *
  *  @param st library state
@@ -0,0 +1,112 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <math.h>
+#include <stdio.h>
+
+#include "libavutil/error.h"
+#include "libavutil/macros.h"
+#include "libavutil/mathematics.h"
+#include "libavutil/mem.h"
+#include "libavfilter/ebur128.h"
+
+#define CHANNELS 2
+
+/* A sine at a quarter of the sample rate with a 45 degree phase offset:
+ * every sample is at +-0.707 of the amplitude, the peaks fall halfway
+ * between samples. The second channel has half the amplitude. */
+static double *gen_signal(int nb_samples)
+{
+    double *buf = av_malloc_array(nb_samples * CHANNELS, sizeof(*buf));
+
+    if (!buf)
+        return NULL;
+    for (int i = 0; i < nb_samples; i++) {
+        double v = sin(M_PI / 2 * i + M_PI / 4);
+        buf[CHANNELS * i]     = v;
+        buf[CHANNELS * i + 1] = v * 0.5;
+    }
+    return buf;
+}
+
+static int test_rate(int rate)
+{
+    static const int chunks[] = { 1, 7, 100, 3, 1024, 13 };
+    FFEBUR128State *whole, *pieces;
+    const int nb_samples = rate;
+    double *buf = gen_signal(nb_samples);
+    int ret = 0;
+
+    whole  = ff_ebur128_init(CHANNELS, rate, 0, FF_EBUR128_MODE_TRUE_PEAK);
+    pieces = ff_ebur128_init(CHANNELS, rate, 0, FF_EBUR128_MODE_TRUE_PEAK);
+    if (!buf || !whole || !pieces) {
+        ret = 1;
+        goto end;
+    }
+
+    ff_ebur128_add_frames_double(whole, buf, nb_samples);
+    /* the interpolator history must carry over between calls */
+    for (int i = 0, n = 0; i < nb_samples; i += n, n++) {
+        n = FFMIN(chunks[n % FF_ARRAY_ELEMS(chunks)], nb_samples - i);
+        ff_ebur128_add_frames_double(pieces, buf + CHANNELS * i, n);
+    }
+
+    for (int c = 0; c < CHANNELS; c++) {
+        double sp, tp, tp2;
+
+        ff_ebur128_sample_peak(whole, c, &sp);
+        ff_ebur128_true_peak(whole, c, &tp);
+        ff_ebur128_true_peak(pieces, c, &tp2);
+        printf("rate %6d channel %d: sample peak %+.1f dBFS, true peak %+.1f dBTP\n",
+               rate, c, 20 * log10(sp), 20 * log10(tp));
+        if (tp != tp2) {
+            printf("true peak differs when fed in pieces: %f != %f\n", tp2, tp);
+            ret = 1;
+        }
+    }
+
+end:
+    if (whole)
+        ff_ebur128_destroy(&whole);
+    if (pieces)
+        ff_ebur128_destroy(&pieces);
+    av_free(buf);
+    return ret;
+}
+
+int main(void)
+{
+    FFEBUR128State *st;
+    double peak;
+    int ret = 0;
+
+    ret |= test_rate(48000);
+    ret |= test_rate(96000);
+    ret |= test_rate(192000);
+
+    st = ff_ebur128_init(1, 48000, 0, FF_EBUR128_MODE_SAMPLE_PEAK);
+    if (!st)
+        return 1;
+    if (ff_ebur128_true_peak(st, 0, &peak) != AVERROR(EINVAL)) {
+        printf("true peak available without FF_EBUR128_MODE_TRUE_PEAK\n");
+        ret = 1;
+    }
+    ff_ebur128_destroy(&st);
+
+    return ret;
+}
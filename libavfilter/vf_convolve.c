@@ -39,9 +39,13 @@ typedef struct ConvolveContext {
 
     AVTXContext *fft[4][MAX_THREADS];
     AVTXContext *ifft[4][MAX_THREADS];
+    AVTXContext *vfft[4][MAX_THREADS];
+    AVTXContext *ivfft[4][MAX_THREADS];
 
     av_tx_fn tx_fn[4];
     av_tx_fn itx_fn[4];
+    av_tx_batch_fn vtx_fn[4];
+    av_tx_batch_fn ivtx_fn[4];
 
     int fft_len[4];
     int planewidth[4];
@@ -54,11 +58,9 @@ typedef struct ConvolveContext {
     int secondaryheight[4];
 
     AVComplexFloat *fft_hdata_in[4];
-    AVComplexFloat *fft_vdata_in[4];
     AVComplexFloat *fft_hdata_out[4];
     AVComplexFloat *fft_vdata_out[4];
     AVComplexFloat *fft_hdata_impulse_in[4];
-    AVComplexFloat *fft_vdata_impulse_in[4];
     AVComplexFloat *fft_hdata_impulse_out[4];
     AVComplexFloat *fft_vdata_impulse_out[4];
 
@@ -140,18 +142,12 @@ static int config_input(AVFilterLink *inlink)
         if (!(s->fft_hdata_out[i] = av_calloc(s->fft_len[i], s->fft_len[i] * sizeof(AVComplexFloat))))
             return AVERROR(ENOMEM);
 
-        if (!(s->fft_vdata_in[i] = av_calloc(s->fft_len[i], s->fft_len[i] * sizeof(AVComplexFloat))))
-            return AVERROR(ENOMEM);
-
         if (!(s->fft_vdata_out[i] = av_calloc(s->fft_len[i], s->fft_len[i] * sizeof(AVComplexFloat))))
             return AVERROR(ENOMEM);
 
         if (!(s->fft_hdata_impulse_in[i] = av_calloc(s->fft_len[i], s->fft_len[i] * sizeof(AVComplexFloat))))
             return AVERROR(ENOMEM);
 
-        if (!(s->fft_vdata_impulse_in[i] = av_calloc(s->fft_len[i], s->fft_len[i] * sizeof(AVComplexFloat))))
-            return AVERROR(ENOMEM);
-
         if (!(s->fft_hdata_impulse_out[i] = av_calloc(s->fft_len[i], s->fft_len[i] * sizeof(AVComplexFloat))))
             return AVERROR(ENOMEM);
 
@@ -372,22 +368,17 @@ static int fft_vertical(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
     ConvolveContext *s = ctx->priv;
     ThreadData *td = arg;
     AVComplexFloat *hdata = td->hdata_out;
-    AVComplexFloat *vdata_in = td->vdata_in;
     AVComplexFloat *vdata_out = td->vdata_out;
     const int plane = td->plane;
     const int n = td->n;
     int start = (n * jobnr) / nb_jobs;
     int end = (n * (jobnr+1)) / nb_jobs;
-    int y, x;
 
-    for (y = start; y < end; y++) {
-        for (x = 0; x < n; x++) {
-            vdata_in[y * n + x].re = hdata[x * n + y].re;
-            vdata_in[y * n + x].im = hdata[x * n + y].im;
-        }
-
-        s->tx_fn[plane](s->fft[plane][jobnr], vdata_out + y * n, vdata_in + y * n, sizeof(AVComplexFloat));
-    }
+    /* transform the columns of hdata into the rows of vdata_out */
+    s->vtx_fn[plane](s->vfft[plane][jobnr],
+                     vdata_out + start * n, sizeof(AVComplexFloat), n * sizeof(AVComplexFloat),
+                     hdata + start, n * sizeof(AVComplexFloat), sizeof(AVComplexFloat),
+                     end - start);
 
     return 0;
 }
@@ -397,22 +388,17 @@ static int ifft_vertical(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs
     ConvolveContext *s = ctx->priv;
     ThreadData *td = arg;
     AVComplexFloat *hdata = td->hdata_out;
-    AVComplexFloat *vdata_out = td->vdata_out;
     AVComplexFloat *vdata_in = td->vdata_in;
     const int plane = td->plane;
     const int n = td->n;
     int start = (n * jobnr) / nb_jobs;
     int end = (n * (jobnr+1)) / nb_jobs;
-    int y, x;
 
-    for (y = start; y < end; y++) {
-        s->itx_fn[plane](s->ifft[plane][jobnr], vdata_out + y * n, vdata_in + y * n, sizeof(AVComplexFloat));
-
-        for (x = 0; x < n; x++) {
-            hdata[x * n + y].re = vdata_out[y * n + x].re;
-            hdata[x * n + y].im = vdata_out[y * n + x].im;
-        }
-    }
+    /* transform the rows of vdata_in into the columns of hdata */
+    s->ivtx_fn[plane](s->ivfft[plane][jobnr],
+                      hdata + start, n * sizeof(AVComplexFloat), sizeof(AVComplexFloat),
+                      vdata_in + start * n, sizeof(AVComplexFloat), n * sizeof(AVComplexFloat),
+                      end - start);
 
     return 0;
 }
@@ -633,7 +619,6 @@ static void prepare_impulse(AVFilterContext *ctx, AVFrame *impulsepic, int plane
     td.n = n;
     td.plane = plane;
     td.hdata_in  = s->fft_hdata_impulse_in[plane];
-    td.vdata_in  = s->fft_vdata_impulse_in[plane];
     td.hdata_out = s->fft_hdata_impulse_out[plane];
     td.vdata_out = s->fft_vdata_impulse_out[plane];
 
@@ -659,7 +644,6 @@ static void prepare_secondary(AVFilterContext *ctx, AVFrame *secondary, int plan
     td.n = n;
     td.plane = plane;
     td.hdata_in  = s->fft_hdata_impulse_in[plane];
-    td.vdata_in  = s->fft_vdata_impulse_in[plane];
     td.hdata_out = s->fft_hdata_impulse_out[plane];
     td.vdata_out = s->fft_vdata_impulse_out[plane];
 
@@ -703,7 +687,6 @@ static int do_convolve(FFFrameSync *fs)
         s->get_input(s, s->fft_hdata_in[plane], mainpic, w, h, n, plane, 1.f);
 
         td.hdata_in  = s->fft_hdata_in[plane];
-        td.vdata_in  = s->fft_vdata_in[plane];
         td.hdata_out = s->fft_hdata_out[plane];
         td.vdata_out = s->fft_vdata_out[plane];
 
@@ -722,10 +705,8 @@ static int do_convolve(FFFrameSync *fs)
         ff_filter_execute(ctx, s->filter, &td, NULL,
                           FFMIN3(MAX_THREADS, n, ff_filter_get_nb_threads(ctx)));
 
-        td.hdata_in  = s->fft_hdata_out[plane];
         td.vdata_in  = s->fft_vdata_out[plane];
         td.hdata_out = s->fft_hdata_in[plane];
-        td.vdata_out = s->fft_vdata_in[plane];
 
         ff_filter_execute(ctx, ifft_vertical, &td, NULL,
                           FFMIN3(MAX_THREADS, n, ff_filter_get_nb_threads(ctx)));
@@ -786,6 +767,12 @@ static int config_output(AVFilterLink *outlink)
             ret = av_tx_init(&s->ifft[i][j], &s->itx_fn[i], AV_TX_FLOAT_FFT, 1, s->fft_len[i], &scale, 0);
             if (ret < 0)
                 return ret;
+            ret = av_tx_init_batch(&s->vfft[i][j], &s->vtx_fn[i], AV_TX_FLOAT_FFT, 0, s->fft_len[i], &scale, 0);
+            if (ret < 0)
+                return ret;
+            ret = av_tx_init_batch(&s->ivfft[i][j], &s->ivtx_fn[i], AV_TX_FLOAT_FFT, 1, s->fft_len[i], &scale, 0);
+            if (ret < 0)
+                return ret;
         }
     }
 
@@ -831,17 +818,17 @@ static av_cold void uninit(AVFilterContext *ctx)
 
     for (i = 0; i < 4; i++) {
         av_freep(&s->fft_hdata_in[i]);
-        av_freep(&s->fft_vdata_in[i]);
         av_freep(&s->fft_hdata_out[i]);
         av_freep(&s->fft_vdata_out[i]);
         av_freep(&s->fft_hdata_impulse_in[i]);
-        av_freep(&s->fft_vdata_impulse_in[i]);
         av_freep(&s->fft_hdata_impulse_out[i]);
         av_freep(&s->fft_vdata_impulse_out[i]);
 
         for (j = 0; j < MAX_THREADS; j++) {
             av_tx_uninit(&s->fft[i][j]);
             av_tx_uninit(&s->ifft[i][j]);
+            av_tx_uninit(&s->vfft[i][j]);
+            av_tx_uninit(&s->ivfft[i][j]);
         }
     }
 
@@ -194,6 +194,7 @@ typedef struct GlyphInfo {
     int y;                          ///< the y position of the glyph
     int shift_x64;                  ///< the horizontal shift of the glyph in 26.6 units
     int shift_y64;                  ///< the vertical shift of the glyph in 26.6 units
+    struct Glyph *glyph;            ///< the cached glyph
 } GlyphInfo;
 
 /** Information about a single line of text */
@@ -327,6 +328,11 @@ typedef struct DrawTextContext {
     int tab_count;                  ///< the number of tab characters
     int blank_advance64;            ///< the size of the space character
     int tab_warning_printed;        ///< ensure the tab warning to be printed only once
+
+    char *layout_text;              ///< expanded text the cached lines were measured for
+    unsigned int layout_fontsize;   ///< font size the cached lines were measured for
+    TextMetrics layout_metrics;     ///< metrics of the cached lines
+    int layout_x64, layout_y64;     ///< position the cached glyph positions were computed for
 } DrawTextContext;
 
 #define OFFSET(x) offsetof(DrawTextContext, x)
@@ -800,6 +806,12 @@ static int load_glyph(AVFilterContext *ctx, Glyph **glyph_ptr, uint32_t code, in
                 ret = AVERROR_EXTERNAL;
                 goto error;
             }
+            // Glyphs of bitmap fonts are returned as is, keep a copy of them
+            // so that they are not freed twice
+            if (tmp_glyph == glyph->glyph && FT_Glyph_Copy(glyph->glyph, &tmp_glyph)) {
+                ret = AVERROR(ENOMEM);
+                goto error;
+            }
             glyph->bglyph[idx] = (FT_BitmapGlyph)tmp_glyph;
             if (glyph->bglyph[idx]->bitmap.pixel_mode == FT_PIXEL_MODE_MONO) {
                 av_log(ctx, AV_LOG_ERROR, "Monocromatic (1bpp) fonts are not supported.\n");
@@ -1117,10 +1129,14 @@ static int glyph_enu_free(void *opaque, void *elem)
     return 0;
 }
 
+static void free_layout(DrawTextContext *s);
+
 static av_cold void uninit(AVFilterContext *ctx)
 {
     DrawTextContext *s = ctx->priv;
 
+    free_layout(s);
+
     av_expr_free(s->x_pexpr);
     av_expr_free(s->y_pexpr);
     av_expr_free(s->a_pexpr);
@@ -1226,6 +1242,8 @@ static int command(AVFilterContext *ctx, const char *cmd, const char *arg, char
         if ((ret = ff_filter_process_command(ctx, cmd, arg, res, res_len, flags)) < 0) {
             return ret;
         }
+        /* Options such as the border width or line spacing change the layout */
+        free_layout(old);
         if (old->borderw != old_borderw) {
             FT_Stroker_Set(old->stroker, old->borderw << 6, FT_STROKER_LINECAP_ROUND,
                         FT_STROKER_LINEJOIN_ROUND, 0);
@@ -1267,20 +1285,21 @@ static void update_alpha(DrawTextContext *s)
         s->alpha = 256 * alpha;
 }
 
-static int draw_glyphs(DrawTextContext *s, AVFrame *frame,
-                       FFDrawColor *color,
-                       TextMetrics *metrics,
-                       int x, int y, int borderw)
+/* Draw the glyphs which overlap the rows [slice_start, slice_end) */
+static void draw_glyphs(DrawTextContext *s, AVFrame *frame,
+                        FFDrawColor *color,
+                        TextMetrics *metrics,
+                        int x, int y, int borderw,
+                        int slice_start, int slice_end)
 {
     int g, l, x1, y1, w1, h1, idx;
     int dx = 0, dy = 0, pdx = 0;
     GlyphInfo *info;
-    Glyph dummy = { 0 }, *glyph;
     FT_Bitmap bitmap;
     FT_BitmapGlyph b_glyph;
     uint8_t j_left = 0, j_right = 0, j_top = 0, j_bottom = 0;
     int line_w, offset_y = 0;
-    int clip_x = 0, clip_y = 0;
+    int clip_x = 0, clip_y = 0, clip_top;
 
     j_left = !!(s->text_align & TA_LEFT);
     j_right = !!(s->text_align & TA_RIGHT);
@@ -1293,28 +1312,17 @@ static int draw_glyphs(DrawTextContext *s, AVFrame *frame,
         offset_y = s->box_height - metrics->height;
     }
 
-    if ((!j_left || j_right) && !s->tab_warning_printed && s->tab_count > 0) {
-        s->tab_warning_printed = 1;
-        av_log(s, AV_LOG_WARNING, "Tab characters are only supported with left horizontal alignment\n");
-    }
-
     clip_x = FFMIN(metrics->rect_x + s->box_width + s->bb_right, frame->width);
-    clip_y = FFMIN(metrics->rect_y + s->box_height + s->bb_bottom, frame->height);
+    clip_y = FFMIN3(metrics->rect_y + s->box_height + s->bb_bottom, frame->height, slice_end);
+    clip_top = FFMAX(metrics->rect_y - s->bb_top, slice_start);
 
     for (l = 0; l < s->line_count; ++l) {
         TextLine *line = &s->lines[l];
         line_w = POS_CEIL(line->width64, 64);
         for (g = 0; g < line->hb_data.glyph_count; ++g) {
             info = &line->glyphs[g];
-            dummy.fontsize = s->fontsize;
-            dummy.code = info->code;
-            glyph = av_tree_find(s->glyphs, &dummy, glyph_cmp, NULL);
-            if (!glyph) {
-                return AVERROR(EINVAL);
-            }
-
             idx = get_subpixel_idx(info->shift_x64, info->shift_y64);
-            b_glyph = borderw ? glyph->border_bglyph[idx] : glyph->bglyph[idx];
+            b_glyph = borderw ? info->glyph->border_bglyph[idx] : info->glyph->bglyph[idx];
             bitmap = b_glyph->bitmap;
             x1 = x + info->x + b_glyph->left;
             y1 = y + info->y - b_glyph->top + offset_y;
@@ -1333,9 +1341,9 @@ static int draw_glyphs(DrawTextContext *s, AVFrame *frame,
                 dx = metrics->rect_x - s->bb_left - x1;
                 x1 = metrics->rect_x - s->bb_left;
             }
-            if (y1 < metrics->rect_y - s->bb_top) {
-                dy = metrics->rect_y - s->bb_top - y1;
-                y1 = metrics->rect_y - s->bb_top;
+            if (y1 < clip_top) {
+                dy = clip_top - y1;
+                y1 = clip_top;
             }
 
             // check if the glyph is empty or out of the clipping region
@@ -1351,8 +1359,6 @@ static int draw_glyphs(DrawTextContext *s, AVFrame *frame,
                 bitmap.buffer + pdx, bitmap.pitch, w1, h1, 3, 0, x1, y1);
         }
     }
-
-    return 0;
 }
 
 // Shapes a line of text using libharfbuzz
@@ -1389,6 +1395,64 @@ static void hb_destroy(HarfbuzzData *hb)
     hb->glyph_pos = NULL;
 }
 
+static void free_layout(DrawTextContext *s)
+{
+    for (int l = 0; s->lines && l < s->line_count; ++l) {
+        TextLine *line = &s->lines[l];
+        av_freep(&line->glyphs);
+        hb_destroy(&line->hb_data);
+    }
+    av_freep(&s->lines);
+    av_freep(&s->tab_clusters);
+    av_freep(&s->layout_text);
+}
+
+typedef struct ThreadData {
+    AVFrame *frame;
+    TextMetrics *metrics;
+    FFDrawColor *fontcolor, *shadowcolor, *bordercolor, *boxcolor;
+    int top, bottom;                ///< rows to draw, in units of chroma rows
+} ThreadData;
+
+static int draw_text_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    DrawTextContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *frame = td->frame;
+    TextMetrics *metrics = td->metrics;
+    const int rows = td->bottom - td->top;
+    /* Slices start on chroma rows, so that no chroma sample is shared
+     * between two slices */
+    const int slice_start = (td->top + rows *  jobnr     / nb_jobs) << s->dc.vsub_max;
+    const int slice_end   = (td->top + rows * (jobnr + 1) / nb_jobs) << s->dc.vsub_max;
+
+    if (s->draw_box) {
+        int rec_y = metrics->rect_y - s->bb_top;
+        int rec_height = s->box_height + s->bb_bottom + s->bb_top;
+        int y0 = FFMAX(rec_y, slice_start);
+        int y1 = FFMIN(rec_y + rec_height, slice_end);
+
+        if (y1 > y0)
+            ff_blend_rectangle(&s->dc, td->boxcolor,
+                frame->data, frame->linesize, frame->width, frame->height,
+                metrics->rect_x - s->bb_left, y0,
+                s->box_width + s->bb_right + s->bb_left, y1 - y0);
+    }
+
+    if (s->shadowx || s->shadowy)
+        draw_glyphs(s, frame, td->shadowcolor, metrics,
+                    s->shadowx, s->shadowy, s->borderw, slice_start, slice_end);
+
+    if (s->borderw)
+        draw_glyphs(s, frame, td->bordercolor, metrics,
+                    0, 0, s->borderw, slice_start, slice_end);
+
+    draw_glyphs(s, frame, td->fontcolor, metrics,
+                0, 0, 0, slice_start, slice_end);
+
+    return 0;
+}
+
 static int measure_text(AVFilterContext *ctx, TextMetrics *metrics)
 {
     DrawTextContext *s = ctx->priv;
@@ -1570,9 +1634,9 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame)
 
     int width = frame->width;
     int height = frame->height;
-    int rec_x = 0, rec_y = 0, rec_width = 0, rec_height = 0;
     int is_outside = 0;
     int last_tab_idx = 0;
+    int layout_changed;
 
     TextMetrics metrics;
 
@@ -1623,9 +1687,21 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame)
         return ret;
     }
 
-    if ((ret = measure_text(ctx, &metrics)) < 0) {
-        return ret;
+    /* Shaping and measuring only depend on the text and the font size, so
+     * the lines are kept until either changes */
+    layout_changed = !s->layout_text || s->layout_fontsize != s->fontsize ||
+                     strcmp(s->layout_text, bp->str);
+    if (layout_changed) {
+        free_layout(s);
+        if ((ret = measure_text(ctx, &s->layout_metrics)) < 0) {
+            return ret;
+        }
+        if (!(s->layout_text = av_strdup(bp->str))) {
+            return AVERROR(ENOMEM);
+        }
+        s->layout_fontsize = s->fontsize;
     }
+    metrics = s->layout_metrics;
 
     s->max_glyph_h = POS_CEIL(metrics.max_y64 - metrics.min_y64, 64);
     s->max_glyph_w = POS_CEIL(metrics.max_x64 - metrics.min_x64, 64);
@@ -1716,45 +1792,60 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame)
         y64 = (int)(s->y * 64. + metrics.offset_top64);
     }
 
-    for (int l = 0; l < s->line_count; ++l) {
-        TextLine *line = &s->lines[l];
-        HarfbuzzData *hb = &line->hb_data;
-        line->glyphs = av_mallocz(hb->glyph_count * sizeof(GlyphInfo));
-
-        for (int t = 0; t < hb->glyph_count; ++t) {
-            GlyphInfo *g_info = &line->glyphs[t];
-            uint8_t is_tab = last_tab_idx < s->tab_count &&
-                hb->glyph_info[t].cluster == s->tab_clusters[last_tab_idx] - line->cluster_offset;
-            int true_x, true_y;
-            if (is_tab) {
-                ++last_tab_idx;
-            }
-            true_x = x + hb->glyph_pos[t].x_offset;
-            true_y = y + hb->glyph_pos[t].y_offset;
-            shift_x64 = (((x64 + true_x) >> 4) & 0b0011) << 4;
-            shift_y64 = ((4 - (((y64 + true_y) >> 4) & 0b0011)) & 0b0011) << 4;
+    /* The glyph positions and subpixel bitmaps only need updating when the
+     * text moves */
+    if (layout_changed || x64 != s->layout_x64 || y64 != s->layout_y64) {
+        for (int l = 0; l < s->line_count; ++l) {
+            TextLine *line = &s->lines[l];
+            HarfbuzzData *hb = &line->hb_data;
 
-            ret = load_glyph(ctx, &glyph, hb->glyph_info[t].codepoint, shift_x64, shift_y64);
-            if (ret != 0) {
-                return ret;
+            if (!line->glyphs) {
+                line->glyphs = av_mallocz(hb->glyph_count * sizeof(GlyphInfo));
+                if (!line->glyphs) {
+                    free_layout(s);
+                    return AVERROR(ENOMEM);
+                }
             }
-            g_info->code = hb->glyph_info[t].codepoint;
-            g_info->x = (x64 + true_x) >> 6;
-            g_info->y = ((y64 + true_y) >> 6) + (shift_y64 > 0 ? 1 : 0);
-            g_info->shift_x64 = shift_x64;
-            g_info->shift_y64 = shift_y64;
-
-            if (!is_tab) {
-                x += hb->glyph_pos[t].x_advance;
-            } else {
-                int size = s->blank_advance64 * s->tabsize;
-                x = (x / size + 1) * size;
+
+            for (int t = 0; t < hb->glyph_count; ++t) {
+                GlyphInfo *g_info = &line->glyphs[t];
+                uint8_t is_tab = last_tab_idx < s->tab_count &&
+                    hb->glyph_info[t].cluster == s->tab_clusters[last_tab_idx] - line->cluster_offset;
+                int true_x, true_y;
+                if (is_tab) {
+                    ++last_tab_idx;
+                }
+                true_x = x + hb->glyph_pos[t].x_offset;
+                true_y = y + hb->glyph_pos[t].y_offset;
+                shift_x64 = (((x64 + true_x) >> 4) & 0b0011) << 4;
+                shift_y64 = ((4 - (((y64 + true_y) >> 4) & 0b0011)) & 0b0011) << 4;
+
+                ret = load_glyph(ctx, &glyph, hb->glyph_info[t].codepoint, shift_x64, shift_y64);
+                if (ret != 0) {
+                    free_layout(s);
+                    return ret;
+                }
+                g_info->glyph = glyph;
+                g_info->code = hb->glyph_info[t].codepoint;
+                g_info->x = (x64 + true_x) >> 6;
+                g_info->y = ((y64 + true_y) >> 6) + (shift_y64 > 0 ? 1 : 0);
+                g_info->shift_x64 = shift_x64;
+                g_info->shift_y64 = shift_y64;
+
+                if (!is_tab) {
+                    x += hb->glyph_pos[t].x_advance;
+                } else {
+                    int size = s->blank_advance64 * s->tabsize;
+                    x = (x / size + 1) * size;
+                }
+                y += hb->glyph_pos[t].y_advance;
             }
-            y += hb->glyph_pos[t].y_advance;
-        }
 
-        y += metrics.line_height64 + s->line_spacing * 64;
-        x = 0;
+            y += metrics.line_height64 + s->line_spacing * 64;
+            x = 0;
+        }
+        s->layout_x64 = x64;
+        s->layout_y64 = y64;
     }
 
     metrics.rect_x = s->x;
@@ -1784,45 +1875,29 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame)
                     metrics.rect_y + s->box_height + s->bb_bottom <= 0;
 
     if (!is_outside) {
-        /* draw box */
-        if (s->draw_box) {
-            rec_x = metrics.rect_x - s->bb_left;
-            rec_y = metrics.rect_y - s->bb_top;
-            rec_width = s->box_width + s->bb_right + s->bb_left;
-            rec_height = s->box_height + s->bb_bottom + s->bb_top;
-            ff_blend_rectangle(&s->dc, &boxcolor,
-                frame->data, frame->linesize, width, height,
-                rec_x, rec_y, rec_width, rec_height);
+        ThreadData td = {
+            .frame       = frame,
+            .metrics     = &metrics,
+            .fontcolor   = &fontcolor,
+            .shadowcolor = &shadowcolor,
+            .bordercolor = &bordercolor,
+            .boxcolor    = &boxcolor,
+        };
+        const int vsub = s->dc.vsub_max;
+
+        if ((!(s->text_align & TA_LEFT) || (s->text_align & TA_RIGHT)) &&
+            !s->tab_warning_printed && s->tab_count > 0) {
+            s->tab_warning_printed = 1;
+            av_log(s, AV_LOG_WARNING, "Tab characters are only supported with left horizontal alignment\n");
         }
 
-        if (s->shadowx || s->shadowy) {
-            if ((ret = draw_glyphs(s, frame, &shadowcolor, &metrics,
-                    s->shadowx, s->shadowy, s->borderw)) < 0) {
-                return ret;
-            }
-        }
-
-        if (s->borderw) {
-            if ((ret = draw_glyphs(s, frame, &bordercolor, &metrics,
-                    0, 0, s->borderw)) < 0) {
-                return ret;
-            }
-        }
-
-        if ((ret = draw_glyphs(s, frame, &fontcolor, &metrics, 0,
-                0, 0)) < 0) {
-            return ret;
-        }
-    }
-
-    // FREE data structures
-    for (int l = 0; l < s->line_count; ++l) {
-        TextLine *line = &s->lines[l];
-        av_freep(&line->glyphs);
-        hb_destroy(&line->hb_data);
+        td.top    = FFMAX(metrics.rect_y - s->bb_top, 0) >> vsub;
+        td.bottom = AV_CEIL_RSHIFT(FFMIN(metrics.rect_y + s->box_height + s->bb_bottom,
+                                         height), vsub);
+        if (td.bottom > td.top)
+            ff_filter_execute(ctx, draw_text_slice, &td, NULL,
+                              FFMIN(td.bottom - td.top, ff_filter_get_nb_threads(ctx)));
     }
-    av_freep(&s->lines);
-    av_freep(&s->tab_clusters);
 
     return 0;
 }
@@ -1917,5 +1992,5 @@ const AVFilter ff_vf_drawtext = {
     FILTER_OUTPUTS(ff_video_default_filterpad),
     FILTER_QUERY_FUNC(query_formats),
     .process_command = command,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -59,7 +59,7 @@ typedef struct FFTFILTContext {
     AVTXContext *ivrdft[MAX_THREADS][MAX_PLANES];
 
     av_tx_fn htx_fn, ihtx_fn;
-    av_tx_fn vtx_fn, ivtx_fn;
+    av_tx_batch_fn vtx_fn, ivtx_fn;
 
     int rdft_hbits[MAX_PLANES];
     int rdft_vbits[MAX_PLANES];
@@ -68,7 +68,6 @@ typedef struct FFTFILTContext {
     size_t rdft_hlen[MAX_PLANES];
     size_t rdft_vlen[MAX_PLANES];
     float *rdft_hdata_in[MAX_PLANES];
-    float *rdft_vdata_in[MAX_PLANES];
     float *rdft_hdata_out[MAX_PLANES];
     float *rdft_vdata_out[MAX_PLANES];
 
@@ -328,12 +327,6 @@ static int config_props(AVFilterLink *inlink)
         s->rdft_hlen[i] = 1 << (32 - ff_clz(w));
         s->rdft_hstride[i] = FFALIGN(s->rdft_hlen[i] + 2, av_cpu_max_align());
         s->rdft_hbits[i] = av_log2(s->rdft_hlen[i]);
-        if (!(s->rdft_hdata_in[i] = av_calloc(h, s->rdft_hstride[i] * sizeof(float))))
-            return AVERROR(ENOMEM);
-
-        if (!(s->rdft_hdata_out[i] = av_calloc(h, s->rdft_hstride[i] * sizeof(float))))
-            return AVERROR(ENOMEM);
-
         for (int j = 0; j < s->nb_threads; j++) {
             float scale = 1.f, iscale = 1.f;
 
@@ -351,7 +344,12 @@ static int config_props(AVFilterLink *inlink)
         s->rdft_vlen[i] = 1 << (32 - ff_clz(h));
         s->rdft_vstride[i] = FFALIGN(s->rdft_vlen[i] + 2, av_cpu_max_align());
         s->rdft_vbits[i] = av_log2(s->rdft_vlen[i]);
-        if (!(s->rdft_vdata_in[i] = av_calloc(s->rdft_hstride[i], s->rdft_vstride[i] * sizeof(float))))
+        /* the vertical transforms read and write the columns in place, so
+         * the horizontal arrays have room for the padded column length */
+        if (!(s->rdft_hdata_in[i] = av_calloc(s->rdft_vlen[i], s->rdft_hstride[i] * sizeof(float))))
+            return AVERROR(ENOMEM);
+
+        if (!(s->rdft_hdata_out[i] = av_calloc(s->rdft_vlen[i], s->rdft_hstride[i] * sizeof(float))))
             return AVERROR(ENOMEM);
 
         if (!(s->rdft_vdata_out[i] = av_calloc(s->rdft_hstride[i], s->rdft_vstride[i] * sizeof(float))))
@@ -360,12 +358,12 @@ static int config_props(AVFilterLink *inlink)
         for (int j = 0; j < s->nb_threads; j++) {
             float scale = 1.f, iscale = 1.f;
 
-            ret = av_tx_init(&s->vrdft[j][i], &s->vtx_fn, AV_TX_FLOAT_RDFT,
-                             0, 1 << s->rdft_vbits[i], &scale, 0);
+            ret = av_tx_init_batch(&s->vrdft[j][i], &s->vtx_fn, AV_TX_FLOAT_RDFT,
+                                   0, 1 << s->rdft_vbits[i], &scale, 0);
             if (ret < 0)
                 return ret;
-            ret = av_tx_init(&s->ivrdft[j][i], &s->ivtx_fn, AV_TX_FLOAT_RDFT,
-                             1, 1 << s->rdft_vbits[i], &iscale, 0);
+            ret = av_tx_init_batch(&s->ivrdft[j][i], &s->ivtx_fn, AV_TX_FLOAT_RDFT,
+                                   1, 1 << s->rdft_vbits[i], &iscale, 0);
             if (ret < 0)
                 return ret;
         }
@@ -411,7 +409,7 @@ static int multiply_data(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs
     return 0;
 }
 
-static int copy_vertical(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+static int rdft_vertical(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
     FFTFILTContext *s = ctx->priv;
 
@@ -424,32 +422,23 @@ static int copy_vertical(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs
         const int slice_end = (hlen * (jobnr+1)) / nb_jobs;
         const int h = s->planeheight[plane];
         float *hdata = s->rdft_hdata_out[plane];
-        float *vdata = s->rdft_vdata_in[plane];
-
-        for (int i = slice_start; i < slice_end; i++) {
-            for (int j = 0; j < h; j++)
-                vdata[i * vstride + j] = hdata[j * hstride + i];
-            copy_rev(vdata + i * vstride, h, vlen);
-        }
-    }
-
-    return 0;
-}
-
-static int rdft_vertical(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
-{
-    FFTFILTContext *s = ctx->priv;
-
-    for (int plane = 0; plane < s->nb_planes; plane++) {
-        const int height = s->rdft_hlen[plane];
-        const int slice_start = (height * jobnr) / nb_jobs;
-        const int slice_end = (height * (jobnr+1)) / nb_jobs;
-
-        for (int i = slice_start; i < slice_end; i++)
-            s->vtx_fn(s->vrdft[jobnr][plane],
-                      s->rdft_vdata_out[plane] + i * s->rdft_vstride[plane],
-                      s->rdft_vdata_in[plane] + i * s->rdft_vstride[plane],
-                      sizeof(float));
+        int i;
+
+        /* pad the columns the same way as copy_rev() */
+        for (i = h; i < h + (vlen - h) / 2; i++)
+            memcpy(hdata + i * hstride + slice_start,
+                   hdata + (2 * h - i - 1) * hstride + slice_start,
+                   (slice_end - slice_start) * sizeof(float));
+        for (; i < vlen; i++)
+            memcpy(hdata + i * hstride + slice_start,
+                   hdata + (vlen - i) * hstride + slice_start,
+                   (slice_end - slice_start) * sizeof(float));
+
+        s->vtx_fn(s->vrdft[jobnr][plane],
+                  s->rdft_vdata_out[plane] + slice_start * vstride,
+                  sizeof(AVComplexFloat), vstride * sizeof(float),
+                  hdata + slice_start, hstride * sizeof(float), sizeof(float),
+                  slice_end - slice_start);
     }
 
     return 0;
@@ -459,38 +448,19 @@ static int irdft_vertical(AVFilterContext *ctx, void *arg, int jobnr, int nb_job
 {
     FFTFILTContext *s = ctx->priv;
 
-    for (int plane = 0; plane < s->nb_planes; plane++) {
-        const int height = s->rdft_hlen[plane];
-        const int slice_start = (height * jobnr) / nb_jobs;
-        const int slice_end = (height * (jobnr+1)) / nb_jobs;
-
-        for (int i = slice_start; i < slice_end; i++)
-            s->ivtx_fn(s->ivrdft[jobnr][plane],
-                       s->rdft_vdata_in[plane] + i * s->rdft_vstride[plane],
-                       s->rdft_vdata_out[plane] + i * s->rdft_vstride[plane],
-                       sizeof(AVComplexFloat));
-    }
-
-    return 0;
-}
-
-static int copy_horizontal(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
-{
-    FFTFILTContext *s = ctx->priv;
-
     for (int plane = 0; plane < s->nb_planes; plane++) {
         const int hlen = s->rdft_hlen[plane];
         const int hstride = s->rdft_hstride[plane];
         const int vstride = s->rdft_vstride[plane];
         const int slice_start = (hlen * jobnr) / nb_jobs;
         const int slice_end = (hlen * (jobnr+1)) / nb_jobs;
-        const int h = s->planeheight[plane];
-        float *hdata = s->rdft_hdata_in[plane];
-        float *vdata = s->rdft_vdata_in[plane];
 
-        for (int i = slice_start; i < slice_end; i++)
-            for (int j = 0; j < h; j++)
-                hdata[j * hstride + i] = vdata[i * vstride + j];
+        s->ivtx_fn(s->ivrdft[jobnr][plane],
+                   s->rdft_hdata_in[plane] + slice_start,
+                   hstride * sizeof(float), sizeof(float),
+                   s->rdft_vdata_out[plane] + slice_start * vstride,
+                   sizeof(AVComplexFloat), vstride * sizeof(float),
+                   slice_end - slice_start);
     }
 
     return 0;
@@ -514,9 +484,6 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     ff_filter_execute(ctx, s->rdft_horizontal, in, NULL,
                       FFMIN(s->planeheight[1], s->nb_threads));
 
-    ff_filter_execute(ctx, copy_vertical, NULL, NULL,
-                      FFMIN(s->planeheight[1], s->nb_threads));
-
     ff_filter_execute(ctx, rdft_vertical, NULL, NULL,
                       FFMIN(s->planeheight[1], s->nb_threads));
 
@@ -534,9 +501,6 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     ff_filter_execute(ctx, irdft_vertical, NULL, NULL,
                       FFMIN(s->planeheight[1], s->nb_threads));
 
-    ff_filter_execute(ctx, copy_horizontal, NULL, NULL,
-                      FFMIN(s->planeheight[1], s->nb_threads));
-
     ff_filter_execute(ctx, s->irdft_horizontal, out, NULL,
                       FFMIN(s->planeheight[1], s->nb_threads));
 
@@ -550,7 +514,6 @@ static av_cold void uninit(AVFilterContext *ctx)
 
     for (int i = 0; i < MAX_PLANES; i++) {
         av_freep(&s->rdft_hdata_in[i]);
-        av_freep(&s->rdft_vdata_in[i]);
         av_freep(&s->rdft_hdata_out[i]);
         av_freep(&s->rdft_vdata_out[i]);
         av_expr_free(s->weight_expr[i]);
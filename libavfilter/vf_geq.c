@@ -66,6 +66,10 @@ typedef struct GEQContext {
 
     double *pixel_sums[NB_PLANES];
     int needs_sum[NB_PLANES];
+
+    double *x_values;           ///< X for each column of a row
+    double *row_values;         ///< evaluated row for each thread
+    int row_size;
 } GEQContext;
 
 enum { Y = 0, U, V, A, G, B, R };
@@ -385,6 +389,16 @@ static int geq_config_props(AVFilterLink *inlink)
     geq->vsub = desc->log2_chroma_h;
     geq->bps = desc->comp[0].depth;
     geq->planes = desc->nb_components;
+
+    av_freep(&geq->x_values);
+    av_freep(&geq->row_values);
+    geq->row_size   = inlink->w;
+    geq->x_values   = av_malloc_array(geq->row_size, sizeof(*geq->x_values));
+    geq->row_values = av_malloc_array(geq->row_size, MAX_NB_THREADS * sizeof(*geq->row_values));
+    if (!geq->x_values || !geq->row_values)
+        return AVERROR(ENOMEM);
+    for (int x = 0; x < geq->row_size; x++)
+        geq->x_values[x] = x;
     return 0;
 }
 
@@ -405,9 +419,12 @@ static int slice_geq_filter(AVFilterContext *ctx, void *arg, int jobnr, int nb_j
     const int linesize = td->linesize;
     const int slice_start = (height *  jobnr) / nb_jobs;
     const int slice_end = (height * (jobnr+1)) / nb_jobs;
-    int x, y;
+    const double *const_arrays[VAR_VARS_NB] = { [VAR_X] = geq->x_values };
+    double *row = geq->row_values + jobnr * geq->row_size;
+    int x, y, ret;
 
     double values[VAR_VARS_NB];
+    values[VAR_X] = 0;
     values[VAR_W] = geq->values[VAR_W];
     values[VAR_H] = geq->values[VAR_H];
     values[VAR_N] = geq->values[VAR_N];
@@ -415,36 +432,26 @@ static int slice_geq_filter(AVFilterContext *ctx, void *arg, int jobnr, int nb_j
     values[VAR_SH] = geq->values[VAR_SH];
     values[VAR_T] = geq->values[VAR_T];
 
-    if (geq->bps == 8) {
-        uint8_t *ptr = geq->dst + linesize * slice_start;
-        for (y = slice_start; y < slice_end; y++) {
-            values[VAR_Y] = y;
-
-            for (x = 0; x < width; x++) {
-                values[VAR_X] = x;
-                ptr[x] = av_expr_eval(geq->e[plane][jobnr], values, geq);
-            }
-            ptr += linesize;
-        }
-    } else if (geq->bps <= 16) {
-        uint16_t *ptr16 = geq->dst16 + (linesize/2) * slice_start;
-        for (y = slice_start; y < slice_end; y++) {
-            values[VAR_Y] = y;
-            for (x = 0; x < width; x++) {
-                values[VAR_X] = x;
-                ptr16[x] = av_expr_eval(geq->e[plane][jobnr], values, geq);
-            }
-            ptr16 += linesize/2;
-        }
-    } else {
-        float *ptr32 = geq->dst32 + (linesize/4) * slice_start;
-        for (y = slice_start; y < slice_end; y++) {
-            values[VAR_Y] = y;
-            for (x = 0; x < width; x++) {
-                values[VAR_X] = x;
-                ptr32[x] = av_expr_eval(geq->e[plane][jobnr], values, geq);
-            }
-            ptr32 += linesize/4;
+    for (y = slice_start; y < slice_end; y++) {
+        values[VAR_Y] = y;
+
+        ret = av_expr_eval_batch(geq->e[plane][jobnr], row, width,
+                                 values, const_arrays, geq);
+        if (ret < 0)
+            return ret;
+
+        if (geq->bps == 8) {
+            uint8_t *ptr = geq->dst + linesize * y;
+            for (x = 0; x < width; x++)
+                ptr[x] = row[x];
+        } else if (geq->bps <= 16) {
+            uint16_t *ptr16 = geq->dst16 + (linesize/2) * y;
+            for (x = 0; x < width; x++)
+                ptr16[x] = row[x];
+        } else {
+            float *ptr32 = geq->dst32 + (linesize/4) * y;
+            for (x = 0; x < width; x++)
+                ptr32[x] = row[x];
         }
     }
 
@@ -513,6 +520,8 @@ static av_cold void geq_uninit(AVFilterContext *ctx)
             av_expr_free(geq->e[i][j]);
     for (i = 0; i < NB_PLANES; i++)
         av_freep(&geq->pixel_sums);
+    av_freep(&geq->x_values);
+    av_freep(&geq->row_values);
 }
 
 static const AVFilterPad geq_inputs[] = {
@@ -83,6 +83,9 @@ typedef struct PaletteGenContext {
     int nb_boxes;                           // number of boxes (increase will segmenting them)
     int palette_pushed;                     // if the palette frame is pushed into the outlink or not
     uint8_t transparency_color[4];          // background color for transparency
+    struct hist_node (*thread_hist)[HIST_SIZE]; // per thread histograms of the current frame
+    int *thread_ret;                            // per thread return values
+    int nb_threads;
 } PaletteGenContext;
 
 #define OFFSET(x) offsetof(PaletteGenContext, x)
@@ -416,15 +419,40 @@ static int color_inc(struct hist_node *hist, uint32_t color)
     return 1;
 }
 
+/**
+ * Add a color reference of another histogram to the hash table.
+ */
+static int color_merge(struct hist_node *hist, const struct color_ref *ref)
+{
+    const uint32_t hash = ff_lowbias32(ref->color) & (HIST_SIZE - 1);
+    struct hist_node *node = &hist[hash];
+    struct color_ref *e;
+
+    for (int i = 0; i < node->nb_entries; i++) {
+        e = &node->entries[i];
+        if (e->color == ref->color) {
+            e->count += ref->count;
+            return 0;
+        }
+    }
+
+    e = av_dynarray2_add((void**)&node->entries, &node->nb_entries,
+                         sizeof(*node->entries), (const uint8_t *)ref);
+    if (!e)
+        return AVERROR(ENOMEM);
+    return 1;
+}
+
 /**
  * Update histogram when pixels differ from previous frame.
  */
 static int update_histogram_diff(struct hist_node *hist,
-                                 const AVFrame *f1, const AVFrame *f2)
+                                 const AVFrame *f1, const AVFrame *f2,
+                                 int slice_start, int slice_end)
 {
     int x, y, ret, nb_diff_colors = 0;
 
-    for (y = 0; y < f1->height; y++) {
+    for (y = slice_start; y < slice_end; y++) {
         const uint32_t *p = (const uint32_t *)(f1->data[0] + y*f1->linesize[0]);
         const uint32_t *q = (const uint32_t *)(f2->data[0] + y*f2->linesize[0]);
 
@@ -443,11 +471,12 @@ static int update_histogram_diff(struct hist_node *hist,
 /**
  * Simple histogram of the frame.
  */
-static int update_histogram_frame(struct hist_node *hist, const AVFrame *f)
+static int update_histogram_frame(struct hist_node *hist, const AVFrame *f,
+                                  int slice_start, int slice_end)
 {
     int x, y, ret, nb_diff_colors = 0;
 
-    for (y = 0; y < f->height; y++) {
+    for (y = slice_start; y < slice_end; y++) {
         const uint32_t *p = (const uint32_t *)(f->data[0] + y*f->linesize[0]);
 
         for (x = 0; x < f->width; x++) {
@@ -460,6 +489,67 @@ static int update_histogram_frame(struct hist_node *hist, const AVFrame *f)
     return nb_diff_colors;
 }
 
+typedef struct ThreadData {
+    const AVFrame *in, *prev;
+} ThreadData;
+
+static int update_histogram_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    PaletteGenContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const int slice_start = (td->in->height *  jobnr     ) / nb_jobs;
+    const int slice_end   = (td->in->height * (jobnr + 1)) / nb_jobs;
+    int ret;
+
+    ret = td->prev ? update_histogram_diff(s->thread_hist[jobnr], td->prev, td->in, slice_start, slice_end)
+                   : update_histogram_frame(s->thread_hist[jobnr], td->in, slice_start, slice_end);
+    return FFMIN(ret, 0);
+}
+
+/**
+ * Build one histogram per slice of the frame, and merge them in the order of
+ * the slices, which keeps the colors in the order of their first occurrence.
+ */
+static int update_histogram_threaded(AVFilterContext *ctx, const AVFrame *in, const AVFrame *prev)
+{
+    PaletteGenContext *s = ctx->priv;
+    ThreadData td = { .in = in, .prev = prev };
+    const int nb_jobs = FFMIN(in->height, s->nb_threads);
+    int ret = 0, nb_diff_colors = 0;
+
+    if (!s->thread_hist) {
+        s->thread_hist = av_calloc(s->nb_threads, sizeof(*s->thread_hist));
+        if (!s->thread_hist)
+            return AVERROR(ENOMEM);
+    }
+    if (!s->thread_ret) {
+        s->thread_ret = av_calloc(s->nb_threads, sizeof(*s->thread_ret));
+        if (!s->thread_ret)
+            return AVERROR(ENOMEM);
+    }
+
+    ff_filter_execute(ctx, update_histogram_slice, &td, s->thread_ret, nb_jobs);
+
+    /* do not merge an incomplete histogram */
+    for (int j = 0; ret >= 0 && j < nb_jobs; j++)
+        ret = s->thread_ret[j];
+
+    for (int j = 0; j < nb_jobs; j++) {
+        for (int i = 0; i < HIST_SIZE; i++) {
+            struct hist_node *node = &s->thread_hist[j][i];
+
+            for (int k = 0; ret >= 0 && k < node->nb_entries; k++) {
+                ret = color_merge(s->histogram, &node->entries[k]);
+                if (ret > 0)
+                    nb_diff_colors += ret;
+            }
+            av_freep(&node->entries);
+            node->nb_entries = 0;
+        }
+    }
+    return ret < 0 ? ret : nb_diff_colors;
+}
+
 /**
  * Update the histogram for each passing frame. No frame will be pushed here.
  */
@@ -472,8 +562,11 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     if (in->color_trc != AVCOL_TRC_UNSPECIFIED && in->color_trc != AVCOL_TRC_IEC61966_2_1)
         av_log(ctx, AV_LOG_WARNING, "The input frame is not in sRGB, colors may be off\n");
 
-    ret = s->prev_frame ? update_histogram_diff(s->histogram, s->prev_frame, in)
-                        : update_histogram_frame(s->histogram, in);
+    if (s->nb_threads > 1)
+        ret = update_histogram_threaded(ctx, in, s->prev_frame);
+    else
+        ret = s->prev_frame ? update_histogram_diff(s->histogram, s->prev_frame, in, 0, in->height)
+                            : update_histogram_frame(s->histogram, in, 0, in->height);
     if (ret > 0)
         s->nb_refs += ret;
 
@@ -526,6 +619,10 @@ static int request_frame(AVFilterLink *outlink)
  */
 static int config_output(AVFilterLink *outlink)
 {
+    AVFilterContext *ctx = outlink->src;
+    PaletteGenContext *s = ctx->priv;
+
+    s->nb_threads = ff_filter_get_nb_threads(ctx);
     outlink->w = outlink->h = 16;
     outlink->sample_aspect_ratio = av_make_q(1, 1);
     return 0;
@@ -552,6 +649,11 @@ static av_cold void uninit(AVFilterContext *ctx)
         av_freep(&s->histogram[i].entries);
     av_freep(&s->refs);
     av_frame_free(&s->prev_frame);
+    for (i = 0; s->thread_hist && i < s->nb_threads; i++)
+        for (int j = 0; j < HIST_SIZE; j++)
+            av_freep(&s->thread_hist[i][j].entries);
+    av_freep(&s->thread_hist);
+    av_freep(&s->thread_ret);
 }
 
 static const AVFilterPad palettegen_inputs[] = {
@@ -581,4 +683,5 @@ const AVFilter ff_vf_palettegen = {
     FILTER_OUTPUTS(palettegen_outputs),
     FILTER_QUERY_FUNC(query_formats),
     .priv_class    = &palettegen_class,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -80,10 +80,30 @@ struct cache_node {
     int nb_entries;
 };
 
+/* Part of the processing window handled by one set_frame() call, relative to
+ * the window origin. Each row is shifted left by skew pixels relative to the
+ * previous one, so that error diffusion can run on a wavefront: a pixel only
+ * depends on the pixels of the same tile and of the tiles above and to the
+ * left of it. */
+struct slice {
+    int x, y, w, h;
+    int skew;
+};
+
+/* Size of the tiles and row skew of the error diffusion wavefront. With a
+ * skew of 5 pixels, the kernels (at most 2 pixels wide on each side) of two
+ * tiles processed at the same time never touch the same pixel, and every
+ * pixel receives its errors in the same order as in a raster scan. */
+#define WAVEFRONT_TILE_W 128
+#define WAVEFRONT_TILE_H 32
+#define WAVEFRONT_SKEW   5
+
 struct PaletteUseContext;
 
-typedef int (*set_frame_func)(struct PaletteUseContext *s, AVFrame *out, AVFrame *in,
-                              int x_start, int y_start, int width, int height);
+typedef int (*set_frame_func)(struct PaletteUseContext *s, struct cache_node *cache,
+                              AVFrame *out, AVFrame *in,
+                              int x_start, int y_start, int width, int height,
+                              const struct slice *sl);
 
 typedef struct PaletteUseContext {
     const AVClass *class;
@@ -102,6 +122,9 @@ typedef struct PaletteUseContext {
     int diff_mode;
     AVFrame *last_in;
     AVFrame *last_out;
+    struct cache_node (*thread_cache)[CACHE_SIZE]; /* lookup caches of the threads other than the first one */
+    int nb_threads;
+    int *job_ret;
 
     /* debug options */
     char *dot_filename;
@@ -136,6 +159,20 @@ AVFILTER_DEFINE_CLASS(paletteuse);
 
 static int load_apply_palette(FFFrameSync *fs);
 
+static void reset_cache(struct cache_node *cache)
+{
+    for (int i = 0; i < CACHE_SIZE; i++)
+        av_freep(&cache[i].entries);
+    memset(cache, 0, sizeof(*cache) * CACHE_SIZE);
+}
+
+static void reset_caches(PaletteUseContext *s)
+{
+    reset_cache(s->cache);
+    for (int i = 0; s->thread_cache && i < s->nb_threads - 1; i++)
+        reset_cache(s->thread_cache[i]);
+}
+
 static int query_formats(AVFilterContext *ctx)
 {
     static const enum AVPixelFormat in_fmts[]    = {AV_PIX_FMT_RGB32, AV_PIX_FMT_NONE};
@@ -237,11 +274,12 @@ struct stack_node {
  * Check if the requested color is in the cache already. If not, find it in the
  * color tree and cache it.
  */
-static av_always_inline int color_get(PaletteUseContext *s, uint32_t color)
+static av_always_inline int color_get(PaletteUseContext *s, struct cache_node *cache,
+                                      uint32_t color)
 {
     struct color_info clrinfo;
     const uint32_t hash = ff_lowbias32(color) & (CACHE_SIZE - 1);
-    struct cache_node *node = &s->cache[hash];
+    struct cache_node *node = &cache[hash];
     struct cached_color *e;
 
     // first, check for transparency
@@ -266,11 +304,11 @@ static av_always_inline int color_get(PaletteUseContext *s, uint32_t color)
     return e->pal_entry;
 }
 
-static av_always_inline int get_dst_color_err(PaletteUseContext *s,
+static av_always_inline int get_dst_color_err(PaletteUseContext *s, struct cache_node *cache,
                                               uint32_t c, int *er, int *eg, int *eb)
 {
     uint32_t dstc;
-    const int dstx = color_get(s, c);
+    const int dstx = color_get(s, cache, c);
     if (dstx < 0)
         return dstx;
     dstc = s->palette[dstx];
@@ -287,20 +325,26 @@ static av_always_inline int get_dst_color_err(PaletteUseContext *s,
     return dstx;
 }
 
-static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFrame *in,
+static av_always_inline int set_frame(PaletteUseContext *s, struct cache_node *cache,
+                                      AVFrame *out, AVFrame *in,
                                       int x_start, int y_start, int w, int h,
+                                      const struct slice *sl,
                                       enum dithering_mode dither)
 {
     const int src_linesize = in ->linesize[0] >> 2;
     const int dst_linesize = out->linesize[0];
-    uint32_t *src = ((uint32_t *)in ->data[0]) + y_start*src_linesize;
-    uint8_t  *dst =              out->data[0]  + y_start*dst_linesize;
+    uint32_t *src = ((uint32_t *)in ->data[0]) + (y_start + sl->y)*src_linesize;
+    uint8_t  *dst =              out->data[0]  + (y_start + sl->y)*dst_linesize;
 
     w += x_start;
     h += y_start;
 
-    for (int y = y_start; y < h; y++) {
-        for (int x = x_start; x < w; x++) {
+    for (int y = y_start + sl->y; y < y_start + sl->y + sl->h; y++) {
+        const int shift = sl->skew * (y - y_start);
+        const int slice_start = FFMAX(x_start + sl->x - shift, x_start);
+        const int slice_end   = FFMIN(x_start + sl->x + sl->w - shift, w);
+
+        for (int x = slice_start; x < slice_end; x++) {
             int er, eg, eb;
 
             if (dither == DITHERING_BAYER) {
@@ -313,7 +357,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
                 const uint8_t g = av_clip_uint8(g8 + d);
                 const uint8_t b = av_clip_uint8(b8 + d);
                 const uint32_t color_new = (unsigned)(a8) << 24 | r << 16 | g << 8 | b;
-                const int color = color_get(s, color_new);
+                const int color = color_get(s, cache, color_new);
 
                 if (color < 0)
                     return color;
@@ -321,7 +365,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
 
             } else if (dither == DITHERING_HECKBERT) {
                 const int right = x < w - 1, down = y < h - 1;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb);
 
                 if (color < 0)
                     return color;
@@ -333,7 +377,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
 
             } else if (dither == DITHERING_FLOYD_STEINBERG) {
                 const int right = x < w - 1, down = y < h - 1, left = x > x_start;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb);
 
                 if (color < 0)
                     return color;
@@ -347,7 +391,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
             } else if (dither == DITHERING_SIERRA2) {
                 const int right  = x < w - 1, down  = y < h - 1, left  = x > x_start;
                 const int right2 = x < w - 2,                    left2 = x > x_start + 1;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb);
 
                 if (color < 0)
                     return color;
@@ -366,7 +410,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
 
             } else if (dither == DITHERING_SIERRA2_4A) {
                 const int right = x < w - 1, down = y < h - 1, left = x > x_start;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb);
 
                 if (color < 0)
                     return color;
@@ -379,7 +423,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
             } else if (dither == DITHERING_SIERRA3) {
                 const int right  = x < w - 1, down  = y < h - 1, left  = x > x_start;
                 const int right2 = x < w - 2, down2 = y < h - 2, left2 = x > x_start + 1;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb);
 
                 if (color < 0)
                     return color;
@@ -405,7 +449,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
             } else if (dither == DITHERING_BURKES) {
                 const int right  = x < w - 1, down  = y < h - 1, left  = x > x_start;
                 const int right2 = x < w - 2,                    left2 = x > x_start + 1;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb);
 
                 if (color < 0)
                     return color;
@@ -425,7 +469,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
             } else if (dither == DITHERING_ATKINSON) {
                 const int right  = x < w - 1, down  = y < h - 1, left = x > x_start;
                 const int right2 = x < w - 2, down2 = y < h - 2;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb);
 
                 if (color < 0)
                     return color;
@@ -442,7 +486,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
                 }
 
             } else {
-                const int color = color_get(s, src[x]);
+                const int color = color_get(s, cache, src[x]);
 
                 if (color < 0)
                     return color;
@@ -765,6 +809,115 @@ static void set_processing_window(enum diff_mode diff_mode,
     *hp = height;
 }
 
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    int x, y, w, h;
+    int wave;
+    int nb_bands;
+} ThreadData;
+
+static struct cache_node *get_thread_cache(PaletteUseContext *s, int jobnr)
+{
+    return jobnr ? s->thread_cache[jobnr - 1] : s->cache;
+}
+
+static int set_frame_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    PaletteUseContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const int slice_start = (td->h *  jobnr     ) / nb_jobs;
+    const int slice_end   = (td->h * (jobnr + 1)) / nb_jobs;
+    const struct slice sl = { 0, slice_start, td->w, slice_end - slice_start, 0 };
+
+    return s->set_frame(s, get_thread_cache(s, jobnr), td->out, td->in,
+                        td->x, td->y, td->w, td->h, &sl);
+}
+
+/* Range of the tile columns of a band of the error diffusion wavefront */
+static void get_band_tiles(const ThreadData *td, int band, int *first, int *last)
+{
+    const int y0 = band * WAVEFRONT_TILE_H;
+    const int y1 = FFMIN(y0 + WAVEFRONT_TILE_H, td->h) - 1;
+
+    *first =  WAVEFRONT_SKEW * y0              / WAVEFRONT_TILE_W;
+    *last  = (WAVEFRONT_SKEW * y1 + td->w - 1) / WAVEFRONT_TILE_W;
+}
+
+/* Process the tiles (band, wave - band) of the current wave */
+static int set_frame_wave(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    PaletteUseContext *s = ctx->priv;
+    ThreadData *td = arg;
+    struct cache_node *cache = get_thread_cache(s, jobnr);
+    int tile = 0;
+
+    for (int band = 0; band < td->nb_bands; band++) {
+        const int col = td->wave - band;
+        int first, last, ret;
+        struct slice sl;
+
+        get_band_tiles(td, band, &first, &last);
+        if (col < first || col > last || tile++ % nb_jobs != jobnr)
+            continue;
+
+        sl.x    = col * WAVEFRONT_TILE_W;
+        sl.y    = band * WAVEFRONT_TILE_H;
+        sl.w    = WAVEFRONT_TILE_W;
+        sl.h    = FFMIN(WAVEFRONT_TILE_H, td->h - sl.y);
+        sl.skew = WAVEFRONT_SKEW;
+        ret = s->set_frame(s, cache, td->out, td->in,
+                           td->x, td->y, td->w, td->h, &sl);
+        if (ret < 0)
+            return ret;
+    }
+    return 0;
+}
+
+static int run_set_frame(AVFilterContext *ctx, AVFrame *out, AVFrame *in,
+                         int x, int y, int w, int h)
+{
+    PaletteUseContext *s = ctx->priv;
+    ThreadData td = { .in = in, .out = out, .x = x, .y = y, .w = w, .h = h };
+    int first, last, nb_waves, ret = 0;
+
+    if (s->nb_threads == 1) {
+        const struct slice sl = { 0, 0, w, h, 0 };
+        return s->set_frame(s, s->cache, out, in, x, y, w, h, &sl);
+    }
+
+    if (s->dither == DITHERING_NONE || s->dither == DITHERING_BAYER) {
+        const int nb_jobs = FFMIN(h, s->nb_threads);
+
+        ff_filter_execute(ctx, set_frame_slice, &td, s->job_ret, nb_jobs);
+        for (int i = 0; i < nb_jobs; i++)
+            ret = FFMIN(ret, s->job_ret[i]);
+        return ret;
+    }
+
+    /* Error diffusion: wave n is made of the tiles (band, n - band), which
+     * only depend on the tiles of the previous waves */
+    td.nb_bands = (h + WAVEFRONT_TILE_H - 1) / WAVEFRONT_TILE_H;
+    get_band_tiles(&td, td.nb_bands - 1, &first, &last);
+    nb_waves = last + td.nb_bands;
+
+    for (td.wave = 0; td.wave < nb_waves; td.wave++) {
+        int nb_jobs = 0;
+
+        for (int band = 0; band < td.nb_bands; band++) {
+            get_band_tiles(&td, band, &first, &last);
+            nb_jobs += td.wave - band >= first && td.wave - band <= last;
+        }
+        if (!nb_jobs)
+            continue;
+
+        nb_jobs = FFMIN(nb_jobs, s->nb_threads);
+        ff_filter_execute(ctx, set_frame_wave, &td, s->job_ret, nb_jobs);
+        for (int i = 0; i < nb_jobs; i++)
+            ret = FFMIN(ret, s->job_ret[i]);
+    }
+    return ret;
+}
+
 static int apply_palette(AVFilterLink *inlink, AVFrame *in, AVFrame **outf)
 {
     int x, y, w, h, ret;
@@ -793,7 +946,7 @@ static int apply_palette(AVFilterLink *inlink, AVFrame *in, AVFrame **outf)
     ff_dlog(ctx, "%dx%d rect: (%d;%d) -> (%d,%d) [area:%dx%d]\n",
             w, h, x, y, x+w, y+h, in->width, in->height);
 
-    ret = s->set_frame(s, out, in, x, y, w, h);
+    ret = run_set_frame(ctx, out, in, x, y, w, h);
     if (ret < 0) {
         av_frame_free(&out);
         *outf = NULL;
@@ -823,6 +976,19 @@ static int config_output(AVFilterLink *outlink)
     outlink->time_base = ctx->inputs[0]->time_base;
     if ((ret = ff_framesync_configure(&s->fs)) < 0)
         return ret;
+
+    reset_caches(s);
+    av_freep(&s->thread_cache);
+    av_freep(&s->job_ret);
+    s->nb_threads = ff_filter_get_nb_threads(ctx);
+    s->job_ret = av_calloc(s->nb_threads, sizeof(*s->job_ret));
+    if (!s->job_ret)
+        return AVERROR(ENOMEM);
+    if (s->nb_threads > 1) {
+        s->thread_cache = av_calloc(s->nb_threads - 1, sizeof(*s->thread_cache));
+        if (!s->thread_cache)
+            return AVERROR(ENOMEM);
+    }
     return 0;
 }
 
@@ -852,9 +1018,7 @@ static void load_palette(PaletteUseContext *s, const AVFrame *palette_frame)
     if (s->new) {
         memset(s->palette, 0, sizeof(s->palette));
         memset(s->map, 0, sizeof(s->map));
-        for (i = 0; i < CACHE_SIZE; i++)
-            av_freep(&s->cache[i].entries);
-        memset(s->cache, 0, sizeof(s->cache));
+        reset_caches(s);
     }
 
     i = 0;
@@ -902,10 +1066,12 @@ static int load_apply_palette(FFFrameSync *fs)
 }
 
 #define DEFINE_SET_FRAME(name, value)                                           \
-static int set_frame_##name(PaletteUseContext *s, AVFrame *out, AVFrame *in,    \
-                            int x_start, int y_start, int w, int h)             \
+static int set_frame_##name(PaletteUseContext *s, struct cache_node *cache,     \
+                            AVFrame *out, AVFrame *in,                          \
+                            int x_start, int y_start, int w, int h,             \
+                            const struct slice *sl)                             \
 {                                                                               \
-    return set_frame(s, out, in, x_start, y_start, w, h, value);                \
+    return set_frame(s, cache, out, in, x_start, y_start, w, h, sl, value);     \
 }
 
 DEFINE_SET_FRAME(none,            DITHERING_NONE)
@@ -970,8 +1136,9 @@ static av_cold void uninit(AVFilterContext *ctx)
     PaletteUseContext *s = ctx->priv;
 
     ff_framesync_uninit(&s->fs);
-    for (int i = 0; i < CACHE_SIZE; i++)
-        av_freep(&s->cache[i].entries);
+    reset_caches(s);
+    av_freep(&s->thread_cache);
+    av_freep(&s->job_ret);
     av_frame_free(&s->last_in);
     av_frame_free(&s->last_out);
 }
@@ -1006,4 +1173,5 @@ const AVFilter ff_vf_paletteuse = {
     FILTER_OUTPUTS(paletteuse_outputs),
     FILTER_QUERY_FUNC(query_formats),
     .priv_class    = &paletteuse_class,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -0,0 +1,324 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * scale one video input to several output sizes at once
+ */
+
+#include "libavutil/avstring.h"
+#include "libavutil/mem.h"
+#include "libavutil/opt.h"
+#include "libavutil/parseutils.h"
+#include "libavutil/pixdesc.h"
+#include "libswscale/swscale.h"
+
+#include "avfilter.h"
+#include "filters.h"
+#include "formats.h"
+#include "video.h"
+
+typedef struct ScaleMultiContext {
+    const AVClass *class;
+
+    char *sizes_str;
+    char *flags_str;
+    int cascade;
+
+    int nb_sizes;
+    int *w, *h;
+    /* index of the output each output is scaled from, -1 for the input */
+    int *src_idx;
+
+    struct SwsContext **sws;
+    AVFrame **frames;
+} ScaleMultiContext;
+
+static int config_output(AVFilterLink *outlink);
+
+static int output_level(const ScaleMultiContext *s, int i)
+{
+    int level = 0;
+
+    for (int idx = s->src_idx[i]; idx >= 0; idx = s->src_idx[idx])
+        level++;
+    return level;
+}
+
+/* number of outputs scaled concurrently with output i, including itself */
+static int nb_concurrent_outputs(const ScaleMultiContext *s, int i)
+{
+    int level = output_level(s, i), nb = 0;
+
+    for (int j = 0; j < s->nb_sizes; j++)
+        nb += output_level(s, j) == level;
+    return nb;
+}
+
+static av_cold int init(AVFilterContext *ctx)
+{
+    ScaleMultiContext *s = ctx->priv;
+    char *sizes, *size, *saveptr = NULL;
+    int ret = 0;
+
+    if (!s->sizes_str || !*s->sizes_str) {
+        av_log(ctx, AV_LOG_ERROR, "No output sizes specified\n");
+        return AVERROR(EINVAL);
+    }
+
+    sizes = av_strdup(s->sizes_str);
+    if (!sizes)
+        return AVERROR(ENOMEM);
+
+    for (size = av_strtok(sizes, "|", &saveptr); size;
+         size = av_strtok(NULL, "|", &saveptr)) {
+        AVFilterPad pad = { 0 };
+        int w, h;
+
+        if ((ret = av_parse_video_size(&w, &h, size)) < 0) {
+            av_log(ctx, AV_LOG_ERROR, "Invalid size '%s'\n", size);
+            goto end;
+        }
+
+        if ((ret = av_reallocp_array(&s->w, s->nb_sizes + 1, sizeof(*s->w))) < 0 ||
+            (ret = av_reallocp_array(&s->h, s->nb_sizes + 1, sizeof(*s->h))) < 0 ||
+            (ret = av_reallocp_array(&s->src_idx, s->nb_sizes + 1, sizeof(*s->src_idx))) < 0)
+            goto end;
+        s->w[s->nb_sizes] = w;
+        s->h[s->nb_sizes] = h;
+        s->src_idx[s->nb_sizes] = -1;
+
+        /* scale from the smallest earlier output which is at least twice as
+         * large in both dimensions, if any */
+        for (int j = 0; s->cascade && j < s->nb_sizes; j++) {
+            int cur = s->src_idx[s->nb_sizes];
+            if (s->w[j] >= 2 * w && s->h[j] >= 2 * h &&
+                (cur < 0 || (int64_t)s->w[j] * s->h[j] < (int64_t)s->w[cur] * s->h[cur]))
+                s->src_idx[s->nb_sizes] = j;
+        }
+        s->nb_sizes++;
+
+        pad.type         = AVMEDIA_TYPE_VIDEO;
+        pad.config_props = config_output;
+        pad.name = av_asprintf("output%d", ctx->nb_outputs);
+        if (!pad.name) {
+            ret = AVERROR(ENOMEM);
+            goto end;
+        }
+        if ((ret = ff_append_outpad_free_name(ctx, &pad)) < 0)
+            goto end;
+    }
+
+    s->sws    = av_calloc(s->nb_sizes, sizeof(*s->sws));
+    s->frames = av_calloc(s->nb_sizes, sizeof(*s->frames));
+    if (!s->sws || !s->frames)
+        ret = AVERROR(ENOMEM);
+
+end:
+    av_free(sizes);
+    return ret;
+}
+
+static av_cold void uninit(AVFilterContext *ctx)
+{
+    ScaleMultiContext *s = ctx->priv;
+
+    for (int i = 0; s->sws && i < s->nb_sizes; i++)
+        sws_freeContext(s->sws[i]);
+    av_freep(&s->sws);
+    av_freep(&s->frames);
+    av_freep(&s->w);
+    av_freep(&s->h);
+    av_freep(&s->src_idx);
+}
+
+static int query_formats(AVFilterContext *ctx)
+{
+    const AVPixFmtDescriptor *desc = NULL;
+    AVFilterFormats *formats = NULL;
+    int ret;
+
+    /* all outputs use the input format */
+    while ((desc = av_pix_fmt_desc_next(desc))) {
+        enum AVPixelFormat pix_fmt = av_pix_fmt_desc_get_id(desc);
+        if (sws_isSupportedInput(pix_fmt) && sws_isSupportedOutput(pix_fmt) &&
+            (ret = ff_add_format(&formats, pix_fmt)) < 0)
+            return ret;
+    }
+
+    return ff_set_common_formats(ctx, formats);
+}
+
+static int config_output(AVFilterLink *outlink)
+{
+    AVFilterContext *ctx = outlink->src;
+    ScaleMultiContext *s = ctx->priv;
+    AVFilterLink *inlink = ctx->inputs[0];
+    int i = FF_OUTLINK_IDX(outlink);
+    int idx = s->src_idx[i];
+    int full_range = inlink->color_range == AVCOL_RANGE_JPEG;
+    struct SwsContext *sws;
+    int ret;
+
+    outlink->w = s->w[i];
+    outlink->h = s->h[i];
+    if (inlink->sample_aspect_ratio.num)
+        outlink->sample_aspect_ratio = av_mul_q((AVRational){ outlink->h * inlink->w,
+                                                              outlink->w * inlink->h },
+                                                inlink->sample_aspect_ratio);
+    else
+        outlink->sample_aspect_ratio = inlink->sample_aspect_ratio;
+
+    sws_freeContext(s->sws[i]);
+    s->sws[i] = sws = sws_alloc_context();
+    if (!sws)
+        return AVERROR(ENOMEM);
+
+    av_opt_set_int(sws, "srcw", idx < 0 ? inlink->w : s->w[idx], 0);
+    av_opt_set_int(sws, "srch", idx < 0 ? inlink->h : s->h[idx], 0);
+    av_opt_set_int(sws, "src_format", inlink->format, 0);
+    av_opt_set_int(sws, "dstw", outlink->w, 0);
+    av_opt_set_int(sws, "dsth", outlink->h, 0);
+    av_opt_set_int(sws, "dst_format", outlink->format, 0);
+    av_opt_set_int(sws, "src_range", full_range, 0);
+    av_opt_set_int(sws, "dst_range", full_range, 0);
+    /* the first context sets the number of outputs scaled concurrently,
+     * which are then scaled on a single thread each */
+    av_opt_set_int(sws, "threads", !i || nb_concurrent_outputs(s, i) == 1 ?
+                   ff_filter_get_nb_threads(ctx) : 1, 0);
+    if (*s->flags_str &&
+        (ret = av_opt_set(sws, "sws_flags", s->flags_str, 0)) < 0)
+        return ret;
+
+    if ((ret = sws_init_context(sws, NULL, NULL)) < 0)
+        return ret;
+
+    av_log(ctx, AV_LOG_VERBOSE, "output%d: %dx%d from %s\n", i,
+           outlink->w, outlink->h, idx < 0 ? "input" : "earlier output");
+
+    return 0;
+}
+
+static int scale_frame(AVFilterContext *ctx, AVFrame *in)
+{
+    ScaleMultiContext *s = ctx->priv;
+    int ret = 0;
+
+    for (int i = 0; i < s->nb_sizes; i++) {
+        AVFilterLink *outlink = ctx->outputs[i];
+
+        s->frames[i] = ff_get_video_buffer(outlink, outlink->w, outlink->h);
+        if (!s->frames[i]) {
+            ret = AVERROR(ENOMEM);
+            goto fail;
+        }
+        av_frame_copy_props(s->frames[i], in);
+        s->frames[i]->sample_aspect_ratio = outlink->sample_aspect_ratio;
+    }
+
+    ret = sws_scale_frame_multi(s->sws, s->frames, s->src_idx, s->nb_sizes, in);
+    if (ret < 0)
+        goto fail;
+
+    for (int i = 0; i < s->nb_sizes; i++) {
+        AVFrame *out = s->frames[i];
+
+        s->frames[i] = NULL;
+        if (ff_outlink_get_status(ctx->outputs[i])) {
+            av_frame_free(&out);
+            continue;
+        }
+        if ((ret = ff_filter_frame(ctx->outputs[i], out)) < 0)
+            goto fail;
+    }
+
+fail:
+    for (int i = 0; i < s->nb_sizes; i++)
+        av_frame_free(&s->frames[i]);
+    av_frame_free(&in);
+    return ret;
+}
+
+static int activate(AVFilterContext *ctx)
+{
+    AVFilterLink *inlink = ctx->inputs[0];
+    AVFrame *in;
+    int status, ret, nb_eofs = 0;
+    int64_t pts;
+
+    for (int i = 0; i < ctx->nb_outputs; i++)
+        nb_eofs += ff_outlink_get_status(ctx->outputs[i]) == AVERROR_EOF;
+
+    if (nb_eofs == ctx->nb_outputs) {
+        ff_inlink_set_status(inlink, AVERROR_EOF);
+        return 0;
+    }
+
+    ret = ff_inlink_consume_frame(inlink, &in);
+    if (ret < 0)
+        return ret;
+    if (ret > 0)
+        return scale_frame(ctx, in);
+
+    if (ff_inlink_acknowledge_status(inlink, &status, &pts)) {
+        for (int i = 0; i < ctx->nb_outputs; i++) {
+            if (ff_outlink_get_status(ctx->outputs[i]))
+                continue;
+            ff_outlink_set_status(ctx->outputs[i], status, pts);
+        }
+        return 0;
+    }
+
+    for (int i = 0; i < ctx->nb_outputs; i++) {
+        if (ff_outlink_get_status(ctx->outputs[i]))
+            continue;
+
+        if (ff_outlink_frame_wanted(ctx->outputs[i])) {
+            ff_inlink_request_frame(inlink);
+            return 0;
+        }
+    }
+
+    return FFERROR_NOT_READY;
+}
+
+#define OFFSET(x) offsetof(ScaleMultiContext, x)
+#define FLAGS AV_OPT_FLAG_VIDEO_PARAM|AV_OPT_FLAG_FILTERING_PARAM
+
+static const AVOption scale_multi_options[] = {
+    { "sizes",   "set the '|'-separated list of output sizes", OFFSET(sizes_str), AV_OPT_TYPE_STRING, { .str = NULL }, .flags = FLAGS },
+    { "flags",   "set libswscale flags",                      OFFSET(flags_str), AV_OPT_TYPE_STRING, { .str = "" },   .flags = FLAGS },
+    { "cascade", "scale outputs from larger earlier outputs", OFFSET(cascade),   AV_OPT_TYPE_BOOL,   { .i64 = 0 }, 0, 1, FLAGS },
+    { NULL }
+};
+
+AVFILTER_DEFINE_CLASS(scale_multi);
+
+const AVFilter ff_vf_scale_multi = {
+    .name          = "scale_multi",
+    .description   = NULL_IF_CONFIG_SMALL("Scale the input video to several sizes."),
+    .priv_size     = sizeof(ScaleMultiContext),
+    .priv_class    = &scale_multi_class,
+    .init          = init,
+    .uninit        = uninit,
+    .activate      = activate,
+    FILTER_INPUTS(ff_video_default_filterpad),
+    .outputs       = NULL,
+    FILTER_QUERY_FUNC(query_formats),
+    .flags         = AVFILTER_FLAG_DYNAMIC_OUTPUTS,
+};
@@ -205,6 +205,11 @@ retry:
     return ret;
 }
 
+/* ADTS syncword */
+static const FFProbePairRange adts_aac_probe_pairs[] = {
+    { 0xFFF0, 0xFFFF }, { 0 }
+};
+
 const FFInputFormat ff_aac_demuxer = {
     .p.name       = "aac",
     .p.long_name  = NULL_IF_CONFIG_SMALL("raw ADTS AAC (Advanced Audio Coding)"),
@@ -212,6 +217,7 @@ const FFInputFormat ff_aac_demuxer = {
     .p.extensions = "aac",
     .p.mime_type  = "audio/aac,audio/aacp,audio/x-aac",
     .read_probe   = adts_aac_probe,
+    .probe_pairs  = adts_aac_probe_pairs,
     .read_header  = adts_aac_read_header,
     .read_packet  = adts_aac_read_packet,
     .raw_codec_id = AV_CODEC_ID_AAC,
@@ -99,6 +99,11 @@ static int ac3_eac3_probe(const AVProbeData *p, enum AVCodecID expected_codec_id
     else                   return 0;
 }
 
+/* sync word, either byte order */
+static const FFProbePairRange ac3_probe_pairs[] = {
+    { 0x0B77, 0x0B77 }, { 0x770B, 0x770B }, { 0 }
+};
+
 #if CONFIG_AC3_DEMUXER
 static int ac3_probe(const AVProbeData *p)
 {
@@ -112,6 +117,7 @@ const FFInputFormat ff_ac3_demuxer = {
     .p.extensions   = "ac3",
     .p.priv_class   = &ff_raw_demuxer_class,
     .read_probe     = ac3_probe,
+    .probe_pairs    = ac3_probe_pairs,
     .read_header    = ff_raw_audio_read_header,
     .read_packet    = ff_raw_read_partial_packet,
     .raw_codec_id   = AV_CODEC_ID_AC3,
@@ -132,6 +138,7 @@ const FFInputFormat ff_eac3_demuxer = {
     .p.extensions   = "eac3,ec3",
     .p.priv_class   = &ff_raw_demuxer_class,
     .read_probe     = eac3_probe,
+    .probe_pairs    = ac3_probe_pairs,
     .read_header    = ff_raw_audio_read_header,
     .read_packet    = ff_raw_read_partial_packet,
     .raw_codec_id   = AV_CODEC_ID_EAC3,
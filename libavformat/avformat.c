@@ -64,7 +64,9 @@ FF_ENABLE_DEPRECATION_WARNINGS
     avcodec_free_context(&sti->avctx);
     av_bsf_free(&sti->bsfc);
     av_freep(&sti->index_entries);
+    av_freep(&sti->seek_points);
     av_freep(&sti->probe_data.buf);
+    avpriv_packet_list_free(&sti->interleave_queue);
 
     av_bsf_free(&sti->extract_extradata.bsf);
 
@@ -182,6 +184,7 @@ void avformat_free_context(AVFormatContext *s)
     av_packet_free(&si->parse_pkt);
     av_freep(&s->streams);
     av_freep(&s->stream_groups);
+    av_freep(&si->interleave_heap);
     ff_flush_packet_queue(s);
     av_freep(&s->url);
     av_free(s);
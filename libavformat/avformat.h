@@ -1887,6 +1887,14 @@ typedef struct AVFormatContext {
      * @see skip_estimate_duration_from_pts
      */
     int64_t duration_probesize;
+
+    /**
+     * Number of threads used to decode frames of different streams in
+     * parallel in avformat_find_stream_info(). 0 selects the number of
+     * CPUs, 1 decodes all streams in the calling thread.
+     * Demuxing only, set by the caller before avformat_find_stream_info().
+     */
+    int analyze_threads;
 } AVFormatContext;
 
 /**
@@ -30,6 +30,7 @@
 #include <stdio.h>
 
 #include "libavutil/attributes.h"
+#include "libavutil/buffer.h"
 #include "libavutil/dict.h"
 #include "libavutil/log.h"
 
@@ -555,6 +556,18 @@ void avio_flush(AVIOContext *s);
  */
 int avio_read(AVIOContext *s, unsigned char *buf, int size);
 
+/**
+ * Read size bytes from AVIOContext into a newly allocated reference-counted
+ * buffer. Large reads bypass the internal buffer and go directly into the
+ * returned one. The data is followed by AV_INPUT_BUFFER_PADDING_SIZE zeroed
+ * bytes, so the buffer can be used as packet data. On a short read, the
+ * size of the buffer is the number of bytes read plus the padding.
+ *
+ * @param pbuf set to the new buffer on success, NULL on failure
+ * @return number of bytes read or AVERROR
+ */
+int avio_read_to_buffer(AVIOContext *s, AVBufferRef **pbuf, int size);
+
 /**
  * Read size bytes from AVIOContext into buf. Unlike avio_read(), this is allowed
  * to read fewer bytes than requested. The missing bytes can be read in the next
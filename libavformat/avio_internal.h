@@ -71,6 +71,17 @@ typedef struct FFIOContext {
      */
     int orig_buffer_size;
 
+    /**
+     * Buffer size before it was grown for sequential reads, 0 if it was not
+     * grown; restored on seeks
+     */
+    int adaptive_base_size;
+
+    /**
+     * Number of consecutive refills that followed a fully consumed buffer
+     */
+    int sequential_fills;
+
     /**
      * Written output size
      * is updated each time a successful writeout ends up further position-wise
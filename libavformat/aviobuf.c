@@ -42,6 +42,13 @@
  */
 #define SHORT_SEEK_THRESHOLD 32768
 
+/**
+ * Double the read size after this many consecutive refills consumed a
+ * full buffer without seeking, up to MAX_ADAPTIVE_BUFFER_SIZE.
+ */
+#define ADAPTIVE_FILLS 4
+#define MAX_ADAPTIVE_BUFFER_SIZE (IO_BUFFER_SIZE * 8)
+
 static void fill_buffer(AVIOContext *s);
 static int url_resetbuf(AVIOContext *s, int flags);
 /** @warning must be called before any I/O */
@@ -306,8 +313,15 @@ int64_t avio_seek(AVIOContext *s, int64_t offset, int whence)
         if ((res = s->seek(s->opaque, offset, SEEK_SET)) < 0)
             return res;
         ctx->seek_count++;
-        if (!s->write_flag)
+        if (!s->write_flag) {
             s->buf_end = s->buffer;
+            /* random access, go back to the initial read size */
+            ctx->sequential_fills = 0;
+            if (ctx->adaptive_base_size) {
+                ctx->orig_buffer_size   = ctx->adaptive_base_size;
+                ctx->adaptive_base_size = 0;
+            }
+        }
         s->buf_ptr = s->buf_ptr_max = s->buffer;
         s->pos = offset;
     }
@@ -532,6 +546,26 @@ static void fill_buffer(AVIOContext *s)
         s->checksum_ptr = s->buffer;
     }
 
+    /* grow the buffer while the data is consumed sequentially */
+    if (s->read_packet && !s->max_packet_size && !s->direct &&
+        dst == s->buffer && s->buf_ptr >= s->buf_end &&
+        s->buf_end - s->buffer == s->buffer_size &&
+        s->buffer_size == ctx->orig_buffer_size) {
+        if (++ctx->sequential_fills >= ADAPTIVE_FILLS &&
+            s->buffer_size <= MAX_ADAPTIVE_BUFFER_SIZE / 2) {
+            int base = ctx->adaptive_base_size ? ctx->adaptive_base_size
+                                               : s->buffer_size;
+            if (set_buf_size(s, s->buffer_size * 2) >= 0) {
+                ctx->adaptive_base_size = base;
+                s->checksum_ptr = dst = s->buffer;
+                len = s->buffer_size;
+            }
+            ctx->sequential_fills = 0;
+        }
+    } else if (dst == s->buffer) {
+        ctx->sequential_fills = 0;
+    }
+
     /* make buffer smaller in case it ended up large after probing */
     if (s->read_packet && ctx->orig_buffer_size &&
         s->buffer_size > ctx->orig_buffer_size  && len >= ctx->orig_buffer_size) {
@@ -611,13 +645,19 @@ int avio_r8(AVIOContext *s)
 
 int avio_read(AVIOContext *s, unsigned char *buf, int size)
 {
+    FFIOContext *const ctx = ffiocontext(s);
     int len, size1;
+    /* reads larger than the initial buffer size always go directly into
+     * the destination, even if the buffer has grown for sequential reads */
+    int direct_size = s->buffer_size;
+    if (ctx->adaptive_base_size && s->buffer_size == ctx->orig_buffer_size)
+        direct_size = ctx->adaptive_base_size;
 
     size1 = size;
     while (size > 0) {
         len = FFMIN(s->buf_end - s->buf_ptr, size);
         if (len == 0 || s->write_flag) {
-            if((s->direct || size > s->buffer_size) && !s->update_checksum && s->read_packet) {
+            if((s->direct || size > direct_size) && !s->update_checksum && s->read_packet) {
                 // bypass the buffer and read data directly into buf
                 len = read_packet_wrapper(s, buf, size);
                 if (len == AVERROR_EOF) {
@@ -659,6 +699,33 @@ int avio_read(AVIOContext *s, unsigned char *buf, int size)
     return size1 - size;
 }
 
+int avio_read_to_buffer(AVIOContext *s, AVBufferRef **pbuf, int size)
+{
+    AVBufferRef *buf;
+    int ret;
+
+    *pbuf = NULL;
+    if (size < 0 || size > INT_MAX - AV_INPUT_BUFFER_PADDING_SIZE)
+        return AVERROR(EINVAL);
+
+    buf = av_buffer_alloc(size + AV_INPUT_BUFFER_PADDING_SIZE);
+    if (!buf)
+        return AVERROR(ENOMEM);
+
+    ret = avio_read(s, buf->data, size);
+    if (ret < 0) {
+        av_buffer_unref(&buf);
+        return ret;
+    }
+    memset(buf->data + ret, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+    /* on a short read, only cover the data actually read and its padding,
+     * like av_get_packet() shrinks the packet */
+    buf->size = ret + AV_INPUT_BUFFER_PADDING_SIZE;
+
+    *pbuf = buf;
+    return ret;
+}
+
 int ffio_read_size(AVIOContext *s, unsigned char *buf, int size)
 {
     int ret = avio_read(s, buf, size);
@@ -1121,6 +1188,7 @@ int ffio_realloc_buf(AVIOContext *s, int buf_size)
     av_free(s->buffer);
     s->buffer = buffer;
     ffiocontext(s)->orig_buffer_size = buf_size;
+    ffiocontext(s)->adaptive_base_size = 0;
     s->buffer_size = buf_size;
     s->buf_ptr = s->write_flag ? (s->buffer + data_size) : s->buffer;
     if (s->write_flag)
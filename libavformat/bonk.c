@@ -103,6 +103,11 @@ static int bonk_read_header(AVFormatContext *s)
     return 0;
 }
 
+/* "BO" of the BONK tag */
+static const FFProbePairRange bonk_probe_pairs[] = {
+    { 0x424F, 0x424F }, { 0 }
+};
+
 const FFInputFormat ff_bonk_demuxer = {
     .p.name         = "bonk",
     .p.long_name    = NULL_IF_CONFIG_SMALL("raw Bonk"),
@@ -110,6 +115,7 @@ const FFInputFormat ff_bonk_demuxer = {
     .p.flags        = AVFMT_NOBINSEARCH | AVFMT_NOGENSEARCH | AVFMT_NO_BYTE_SEEK | AVFMT_NOTIMESTAMPS,
     .p.priv_class   = &ff_raw_demuxer_class,
     .read_probe     = bonk_probe,
+    .probe_pairs    = bonk_probe_pairs,
     .read_header    = bonk_read_header,
     .read_packet    = ff_raw_read_partial_packet,
     .raw_codec_id   = AV_CODEC_ID_BONK,
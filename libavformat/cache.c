@@ -23,7 +23,6 @@
 
 /**
  * @TODO
- *      support keeping files
  *      support filling with a background thread
  */
 
@@ -32,8 +31,11 @@
 #include "libavutil/file_open.h"
 #include "libavutil/mem.h"
 #include "libavutil/opt.h"
+#include "libavutil/random_seed.h"
+#include "libavutil/sha.h"
 #include "libavutil/tree.h"
 #include "avio.h"
+#include "internal.h"
 #include <fcntl.h>
 #if HAVE_IO_H
 #include <io.h>
@@ -46,6 +48,13 @@
 #include "os_support.h"
 #include "url.h"
 
+#ifndef O_BINARY
+#   define O_BINARY 0
+#endif
+
+/* Length of the hexadecimal SHA-256 digest naming the files of a resource */
+#define KEY_LEN 64
+
 typedef struct CacheEntry {
     int64_t logical_pos;
     int64_t physical_pos;
@@ -65,6 +74,15 @@ typedef struct CacheContext {
     URLContext *inner;
     int64_t cache_hit, cache_miss;
     int read_ahead_limit;
+
+    char *cache_dir;
+    int64_t cache_max_size;
+    int block_size;
+    char *key;           ///< name of the files of the resource in cache_dir, if kept there
+    uint8_t *block_buf;  ///< block at buf_block
+    int64_t buf_block;
+    int buf_len;
+    int64_t written;     ///< bytes added to cache_dir since the last eviction
 } CacheContext;
 
 static int cmp(const void *key, const void *node)
@@ -72,6 +90,239 @@ static int cmp(const void *key, const void *node)
     return FFDIFFSIGN(*(const int64_t *)key, ((const CacheEntry *) node)->logical_pos);
 }
 
+/*
+ * Resources are kept in cache_dir as one file per block, named after the
+ * key and the block number. Blocks are written to a temporary file renamed
+ * once complete, so that the processes sharing the directory only ever see
+ * complete blocks. A file named after the key alone is rewritten on each
+ * open, its modification time telling when the resource was last used.
+ */
+
+typedef struct CacheDirFile {
+    char *name;
+    int64_t size;
+    int64_t mtime;
+} CacheDirFile;
+
+typedef struct CacheDirKey {
+    const CacheDirFile *files;
+    int nb_files;
+    int64_t size;
+    int64_t last_used;
+} CacheDirKey;
+
+static int cmp_file_name(const void *a, const void *b)
+{
+    return strcmp(((const CacheDirFile *)a)->name, ((const CacheDirFile *)b)->name);
+}
+
+static int cmp_last_used(const void *a, const void *b)
+{
+    return FFDIFFSIGN(((const CacheDirKey *)a)->last_used,
+                      ((const CacheDirKey *)b)->last_used);
+}
+
+static int is_cache_file(const char *name)
+{
+    int i;
+
+    for (i = 0; i < KEY_LEN; i++)
+        if (!name[i] || !strchr("0123456789abcdef", name[i]))
+            return 0;
+    return !name[KEY_LEN] || name[KEY_LEN] == '-';
+}
+
+/**
+ * Delete the least recently used resources of cache_dir until it is
+ * smaller than cache_max_size.
+ */
+static void evict(URLContext *h)
+{
+    CacheContext *c = h->priv_data;
+    AVIODirContext *dir = NULL;
+    AVIODirEntry *entry;
+    CacheDirFile *files = NULL;
+    CacheDirKey *keys = NULL;
+    int nb_files = 0, nb_keys = 0, i, j, ret;
+    int64_t total = 0;
+
+    c->written = 0;
+    if (!c->cache_max_size)
+        return;
+
+    ret = avio_open_dir(&dir, c->cache_dir, NULL);
+    if (ret < 0) {
+        av_log(h, AV_LOG_WARNING, "Cannot list %s to limit its size\n", c->cache_dir);
+        return;
+    }
+    while ((ret = avio_read_dir(dir, &entry)) >= 0 && entry) {
+        if (entry->type == AVIO_ENTRY_FILE && is_cache_file(entry->name)) {
+            CacheDirFile file = { entry->name, FFMAX(entry->size, 0),
+                                  entry->modification_timestamp };
+            entry->name = NULL;
+            if (!av_dynarray2_add((void **)&files, &nb_files, sizeof(file),
+                                  (const uint8_t *)&file)) {
+                av_free(file.name);
+                avio_free_directory_entry(&entry);
+                ret = AVERROR(ENOMEM);
+                break;
+            }
+            total += file.size;
+        }
+        avio_free_directory_entry(&entry);
+    }
+    avio_close_dir(&dir);
+    if (ret < 0 || total <= c->cache_max_size)
+        goto end;
+
+    /* Group the files by resource */
+    qsort(files, nb_files, sizeof(*files), cmp_file_name);
+    for (i = 0; i < nb_files; i = j) {
+        CacheDirKey key = { &files[i] };
+
+        for (j = i; j < nb_files && !strncmp(files[i].name, files[j].name, KEY_LEN); j++) {
+            key.size += files[j].size;
+            if (!files[j].name[KEY_LEN])
+                key.last_used = files[j].mtime;
+            else if (files[i].name[KEY_LEN])
+                key.last_used = FFMAX(key.last_used, files[j].mtime);
+        }
+        key.nb_files = j - i;
+        if (!av_dynarray2_add((void **)&keys, &nb_keys, sizeof(key), (const uint8_t *)&key))
+            goto end;
+    }
+
+    qsort(keys, nb_keys, sizeof(*keys), cmp_last_used);
+    for (i = 0; i < nb_keys && total > c->cache_max_size; i++) {
+        for (j = 0; j < keys[i].nb_files; j++) {
+            char *path = av_asprintf("%s/%s", c->cache_dir, keys[i].files[j].name);
+            if (path && unlink(path) < 0)
+                av_log(h, AV_LOG_DEBUG, "Could not delete %s.\n", path);
+            av_free(path);
+        }
+        total -= keys[i].size;
+        av_log(h, AV_LOG_VERBOSE, "Evicted %.*s (%"PRId64" bytes) from %s\n",
+               KEY_LEN, keys[i].files[0].name, keys[i].size, c->cache_dir);
+    }
+
+end:
+    for (i = 0; i < nb_files; i++)
+        av_free(files[i].name);
+    av_free(files);
+    av_free(keys);
+}
+
+static int write_file(URLContext *h, const char *path, const uint8_t *buf, int size)
+{
+    char *tmp = av_asprintf("%s.%08"PRIx32".tmp", path, av_get_random_seed());
+    int fd, ret = 0;
+
+    if (!tmp)
+        return AVERROR(ENOMEM);
+
+    fd = avpriv_open(tmp, O_WRONLY | O_CREAT | O_EXCL | O_BINARY, 0666);
+    if (fd < 0) {
+        ret = AVERROR(errno);
+        goto end;
+    }
+    while (size > 0) {
+        int r = write(fd, buf, size);
+        if (r < 0) {
+            ret = AVERROR(errno);
+            break;
+        }
+        buf  += r;
+        size -= r;
+    }
+    close(fd);
+    /* Another process may have written the same file meanwhile */
+    if (ret < 0 || rename(tmp, path) < 0) {
+        ret = ret < 0 ? ret : AVERROR(errno);
+        unlink(tmp);
+    }
+end:
+    if (ret < 0)
+        av_log(h, AV_LOG_WARNING, "Could not write %s to the cache\n", path);
+    av_free(tmp);
+    return ret;
+}
+
+static void sha_update_str(struct AVSHA *sha, const char *str)
+{
+    str = str ? str : "";
+    av_sha_update(sha, (const uint8_t *)str, strlen(str) + 1);
+}
+
+static int disk_cache_open(URLContext *h, const char *url)
+{
+    CacheContext *c = h->priv_data;
+    uint8_t *etag = NULL, *last_modified = NULL;
+    uint8_t digest[32];
+    char size_str[32], block_size_str[32];
+    struct AVSHA *sha = NULL;
+    char *path = NULL;
+    int64_t size;
+    int ret = 0;
+
+    /* Only resources which can be told apart from a changed version are kept */
+    av_opt_get(c->inner, "etag", AV_OPT_SEARCH_CHILDREN, &etag);
+    av_opt_get(c->inner, "last_modified", AV_OPT_SEARCH_CHILDREN, &last_modified);
+    if ((!etag || !*etag) && (!last_modified || !*last_modified)) {
+        av_log(h, AV_LOG_VERBOSE, "No ETag or Last-Modified date, not keeping the data in %s\n",
+               c->cache_dir);
+        goto end;
+    }
+
+    size = ffurl_seek(c->inner, 0, AVSEEK_SIZE);
+    snprintf(size_str, sizeof(size_str), "%"PRId64, size);
+    /* blocks are only valid for the block size they were written with */
+    snprintf(block_size_str, sizeof(block_size_str), "%d", c->block_size);
+
+    sha = av_sha_alloc();
+    if (!sha) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    av_sha_init(sha, 256);
+    sha_update_str(sha, url);
+    sha_update_str(sha, (const char *)etag);
+    sha_update_str(sha, (const char *)last_modified);
+    sha_update_str(sha, size_str);
+    sha_update_str(sha, block_size_str);
+    av_sha_final(sha, digest);
+
+    c->key       = av_malloc(KEY_LEN + 1);
+    c->block_buf = av_malloc(c->block_size);
+    if (!c->key || !c->block_buf) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    ff_data_to_hex(c->key, digest, sizeof(digest), 1);
+    c->key[KEY_LEN] = 0;
+    c->buf_block    = -1;
+
+    path = av_asprintf("%s/%s", c->cache_dir, c->key);
+    if (!path) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    if (size > 0) {
+        c->end         = size;
+        c->is_true_eof = 1;
+    }
+
+    /* Mark the resource as used */
+    write_file(h, path, (const uint8_t *)size_str, strlen(size_str));
+    av_log(h, AV_LOG_VERBOSE, "Keeping the data of %s in %s as %s\n", url, c->cache_dir, c->key);
+
+end:
+    av_free(etag);
+    av_free(last_modified);
+    av_free(sha);
+    av_free(path);
+    return ret;
+}
+
 static int cache_open(URLContext *h, const char *arg, int flags, AVDictionary **options)
 {
     CacheContext *c = h->priv_data;
@@ -80,10 +331,24 @@ static int cache_open(URLContext *h, const char *arg, int flags, AVDictionary **
 
     av_strstart(arg, "cache:", &arg);
 
+    c->fd = -1;
+    ret = ffurl_open_whitelist(&c->inner, arg, flags, &h->interrupt_callback,
+                               options, h->protocol_whitelist, h->protocol_blacklist, h);
+    if (ret < 0)
+        return ret;
+
+    if (c->cache_dir) {
+        if ((ret = disk_cache_open(h, arg)) < 0)
+            goto fail;
+        if (c->key)
+            return 0;
+    }
+
     c->fd = avpriv_tempfile("ffcache", &buffername, 0, h);
     if (c->fd < 0){
         av_log(h, AV_LOG_ERROR, "Failed to create tempfile\n");
-        return c->fd;
+        ret = c->fd;
+        goto fail;
     }
 
     ret = unlink(buffername);
@@ -93,8 +358,12 @@ static int cache_open(URLContext *h, const char *arg, int flags, AVDictionary **
     else
         c->filename = buffername;
 
-    return ffurl_open_whitelist(&c->inner, arg, flags, &h->interrupt_callback,
-                                options, h->protocol_whitelist, h->protocol_blacklist, h);
+    return 0;
+fail:
+    av_freep(&c->key);
+    av_freep(&c->block_buf);
+    ffurl_closep(&c->inner);
+    return ret;
 }
 
 static int add_entry(URLContext *h, const unsigned char *buf, int size)
@@ -160,12 +429,129 @@ fail:
     return ret;
 }
 
+/**
+ * Load a block from cache_dir.
+ */
+static int read_block(URLContext *h, int64_t block)
+{
+    CacheContext *c = h->priv_data;
+    char *path = av_asprintf("%s/%s-%"PRId64, c->cache_dir, c->key, block);
+    int64_t end = (block + 1) * c->block_size;
+    int fd, len = 0, r = 0;
+    uint8_t extra;
+
+    if (!path)
+        return AVERROR(ENOMEM);
+    fd = avpriv_open(path, O_RDONLY | O_BINARY);
+    av_free(path);
+    if (fd < 0)
+        return AVERROR(errno);
+
+    while (len < c->block_size && (r = read(fd, c->block_buf + len, c->block_size - len)) > 0)
+        len += r;
+    /* A longer file was not written with this block size */
+    if (len == c->block_size && read(fd, &extra, 1))
+        r = -1;
+    close(fd);
+
+    /* Only the last block may be shorter */
+    if (r < 0 || !len || len < c->block_size && (!c->is_true_eof || end - c->block_size + len != c->end))
+        return AVERROR_INVALIDDATA;
+
+    c->buf_block = block;
+    c->buf_len   = len;
+    return 0;
+}
+
+/**
+ * Read a block from the inner protocol and store it in cache_dir.
+ */
+static int fetch_block(URLContext *h, int64_t block)
+{
+    CacheContext *c = h->priv_data;
+    int64_t pos = block * c->block_size;
+    int len = 0, r = 0;
+    char *path;
+
+    c->buf_block = -1;
+    if (c->inner_pos != pos) {
+        int64_t ret = ffurl_seek(c->inner, pos, SEEK_SET);
+        if (ret < 0) {
+            av_log(h, AV_LOG_ERROR, "Failed to perform internal seek\n");
+            return ret;
+        }
+        c->inner_pos = ret;
+    }
+
+    while (len < c->block_size) {
+        r = ffurl_read(c->inner, c->block_buf + len, c->block_size - len);
+        if (r == AVERROR_EOF || !r)
+            break;
+        if (r < 0)
+            return r;
+        len          += r;
+        c->inner_pos += r;
+    }
+    if (r == AVERROR_EOF || !r) {
+        c->is_true_eof = 1;
+        c->end         = pos + len;
+    }
+    c->end = FFMAX(c->end, pos + len);
+    if (!len)
+        return AVERROR_EOF;
+
+    c->buf_block = block;
+    c->buf_len   = len;
+
+    path = av_asprintf("%s/%s-%"PRId64, c->cache_dir, c->key, block);
+    if (!path)
+        return AVERROR(ENOMEM);
+    if (write_file(h, path, c->block_buf, len) >= 0)
+        c->written += len;
+    av_free(path);
+
+    if (c->cache_max_size && c->written >= c->cache_max_size / 4)
+        evict(h);
+    return 0;
+}
+
+static int disk_cache_read(URLContext *h, unsigned char *buf, int size)
+{
+    CacheContext *c = h->priv_data;
+    int64_t block = c->logical_pos / c->block_size;
+    int offset    = c->logical_pos % c->block_size;
+    int ret;
+
+    if (c->is_true_eof && c->logical_pos >= c->end)
+        return AVERROR_EOF;
+
+    if (block != c->buf_block) {
+        if (read_block(h, block) >= 0) {
+            c->cache_hit++;
+        } else {
+            if ((ret = fetch_block(h, block)) < 0)
+                return ret;
+            c->cache_miss++;
+        }
+    }
+    if (offset >= c->buf_len)
+        return AVERROR_EOF;
+
+    size = FFMIN(size, c->buf_len - offset);
+    memcpy(buf, c->block_buf + offset, size);
+    c->logical_pos += size;
+    return size;
+}
+
 static int cache_read(URLContext *h, unsigned char *buf, int size)
 {
     CacheContext *c = h->priv_data;
     CacheEntry *entry, *next[2] = {NULL, NULL};
     int64_t r;
 
+    if (c->key)
+        return disk_cache_read(h, buf, size);
+
     entry = av_tree_find(c->root, &c->logical_pos, cmp, (void**)next);
 
     if (!entry)
@@ -284,6 +670,7 @@ resolve_eof:
 
     if (ret >= 0) {
         c->logical_pos = ret;
+        c->inner_pos = ret;
         c->end = FFMAX(c->end, ret);
     }
 
@@ -304,7 +691,14 @@ static int cache_close(URLContext *h)
     av_log(h, AV_LOG_INFO, "Statistics, cache hits:%"PRId64" cache misses:%"PRId64"\n",
            c->cache_hit, c->cache_miss);
 
-    close(c->fd);
+    if (c->key) {
+        evict(h);
+        av_freep(&c->key);
+        av_freep(&c->block_buf);
+    }
+
+    if (c->fd >= 0)
+        close(c->fd);
     if (c->filename) {
         ret = unlink(c->filename);
         if (ret < 0)
@@ -323,6 +717,9 @@ static int cache_close(URLContext *h)
 
 static const AVOption options[] = {
     { "read_ahead_limit", "Amount in bytes that may be read ahead when seeking isn't supported, -1 for unlimited", OFFSET(read_ahead_limit), AV_OPT_TYPE_INT, { .i64 = 65536 }, -1, INT_MAX, D },
+    { "cache_dir", "Directory keeping the data of resources with an ETag or Last-Modified date across opens and processes", OFFSET(cache_dir), AV_OPT_TYPE_STRING, { .str = NULL }, 0, 0, D },
+    { "cache_max_size", "Maximum size of cache_dir, the least recently used resources are evicted first, 0 for unlimited", OFFSET(cache_max_size), AV_OPT_TYPE_INT64, { .i64 = 1LL << 30 }, 0, INT64_MAX, D },
+    { "cache_block_size", "Size of the blocks stored in cache_dir", OFFSET(block_size), AV_OPT_TYPE_INT, { .i64 = 1 << 20 }, 4096, 1 << 30, D },
     {NULL},
 };
 
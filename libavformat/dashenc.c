@@ -55,6 +55,7 @@
 #include "mux.h"
 #include "os_support.h"
 #include "url.h"
+#include "writer_pool.h"
 #include "vpcc.h"
 #include "dash.h"
 
@@ -204,6 +205,10 @@ typedef struct DASHContext {
     AVRational min_playback_rate;
     AVRational max_playback_rate;
     int64_t update_period;
+    int async_io;
+    int async_io_queue_size;
+    FFWriterPool *writer_pool; // writes the files in the background with async_io
+    int async_io_error;        // first error writing a file in the background
 } DASHContext;
 
 static const struct codec_string {
@@ -223,6 +228,8 @@ static int dashenc_io_open(AVFormatContext *s, AVIOContext **pb, char *filename,
     DASHContext *c = s->priv_data;
     int http_base_proto = filename ? ff_is_http_proto(filename) : 0;
     int err = AVERROR_MUXER_NOT_FOUND;
+    if (c->writer_pool)
+        return ff_writer_pool_open(c->writer_pool, pb, filename, options ? *options : NULL);
     if (!*pb || !http_base_proto || !c->http_persistent) {
         err = s->io_open(s, pb, filename, AVIO_FLAG_WRITE, options);
 #if CONFIG_HTTP_PROTOCOL
@@ -244,6 +251,10 @@ static void dashenc_io_close(AVFormatContext *s, AVIOContext **pb, char *filenam
     if (!*pb)
         return;
 
+    if (c->writer_pool) {
+        ff_writer_pool_close(c->writer_pool, pb, NULL, NULL);
+        return;
+    }
     if (!http_base_proto || !c->http_persistent) {
         ff_format_io_close(s, pb);
 #if CONFIG_HTTP_PROTOCOL
@@ -256,6 +267,26 @@ static void dashenc_io_close(AVFormatContext *s, AVIOContext **pb, char *filenam
     }
 }
 
+static int dashenc_rename(AVFormatContext *s, const char *url_src, const char *url_dst,
+                          void *logctx)
+{
+    DASHContext *c = s->priv_data;
+
+    if (c->writer_pool)
+        return ff_writer_pool_rename(c->writer_pool, url_src, url_dst);
+    return ff_rename(url_src, url_dst, logctx);
+}
+
+/* Called by the writer pool for each file written in the background. */
+static int dashenc_async_io_done(AVFormatContext *s, void *opaque, int ret)
+{
+    DASHContext *c = s->priv_data;
+
+    if (ret < 0 && !c->ignore_io_errors && !c->async_io_error)
+        c->async_io_error = ret;
+    return 0;
+}
+
 static const char *get_format_str(SegmentType segment_type)
 {
     switch (segment_type) {
@@ -576,7 +607,7 @@ static void write_hls_media_playlist(OutputStream *os, AVFormatContext *s,
     dashenc_io_close(s, &c->m3u8_out, temp_filename_hls);
 
     if (use_rename)
-        ff_rename(temp_filename_hls, filename_hls, os->ctx);
+        dashenc_rename(s, temp_filename_hls, filename_hls, os->ctx);
 }
 
 static int flush_init_segment(AVFormatContext *s, OutputStream *os)
@@ -621,6 +652,8 @@ static void dash_free(AVFormatContext *s)
             else
                 avio_close(os->ctx->pb);
         }
+        if (c->writer_pool)
+            ff_writer_pool_discard(c->writer_pool, &os->out);
         ff_format_io_close(s, &os->out);
         avformat_free_context(os->ctx);
         avcodec_free_context(&os->parser_avctx);
@@ -634,6 +667,12 @@ static void dash_free(AVFormatContext *s)
     }
     av_freep(&c->streams);
 
+    if (c->writer_pool) {
+        ff_writer_pool_discard(c->writer_pool, &c->mpd_out);
+        ff_writer_pool_discard(c->writer_pool, &c->m3u8_out);
+        ff_writer_pool_discard(c->writer_pool, &c->http_delete);
+        ff_writer_pool_free(&c->writer_pool);
+    }
     ff_format_io_close(s, &c->mpd_out);
     ff_format_io_close(s, &c->m3u8_out);
     ff_format_io_close(s, &c->http_delete);
@@ -1240,7 +1279,7 @@ static int write_manifest(AVFormatContext *s, int final)
     dashenc_io_close(s, &c->mpd_out, temp_filename);
 
     if (use_rename) {
-        if ((ret = ff_rename(temp_filename, s->url, s)) < 0)
+        if ((ret = dashenc_rename(s, temp_filename, s->url, s)) < 0)
             return ret;
     }
 
@@ -1356,7 +1395,7 @@ static int write_manifest(AVFormatContext *s, int final)
 
         dashenc_io_close(s, &c->m3u8_out, temp_filename);
         if (use_rename)
-            if ((ret = ff_rename(temp_filename, filename_hls, s)) < 0)
+            if ((ret = dashenc_rename(s, temp_filename, filename_hls, s)) < 0)
                 return ret;
         c->master_playlist_created = 1;
     }
@@ -1415,6 +1454,20 @@ static int dash_init(AVFormatContext *s)
         c->target_latency = 0;
     }
 
+    if (c->async_io) {
+        if (c->single_file || c->streaming) {
+            av_log(s, AV_LOG_ERROR, "async_io is not supported with single_file or streaming\n");
+            return AVERROR(EINVAL);
+        }
+        if (c->http_persistent)
+            av_log(s, AV_LOG_WARNING, "http_persistent is ignored with async_io\n");
+        // a single thread keeps segments, manifests and deletions in order
+        ret = ff_writer_pool_alloc(&c->writer_pool, s, 1, c->async_io_queue_size,
+                                   FF_WRITER_POOL_FLAG_IGNORE_OPTIONS, dashenc_async_io_done);
+        if (ret < 0)
+            return ret;
+    }
+
     if (c->global_sidx && !c->single_file) {
         av_log(s, AV_LOG_WARNING, "Global SIDX option will be ignored as single_file is not enabled\n");
         c->global_sidx = 0;
@@ -1583,7 +1636,7 @@ static int dash_init(AVFormatContext *s)
         if (!c->single_file) {
             if ((ret = avio_open_dyn_buf(&ctx->pb)) < 0)
                 return ret;
-            ret = s->io_open(s, &os->out, filename, AVIO_FLAG_WRITE, &opts);
+            ret = dashenc_io_open(s, &os->out, filename, &opts);
         } else {
             ctx->url = av_strdup(filename);
             ret = avio_open2(&ctx->pb, filename, AVIO_FLAG_WRITE, NULL, &opts);
@@ -1862,6 +1915,8 @@ static void dashenc_delete_file(AVFormatContext *s, char *filename) {
 
         //Nothing to write
         dashenc_io_close(s, &c->http_delete, filename);
+    } else if (c->writer_pool) {
+        ff_writer_pool_delete(c->writer_pool, filename);
     } else {
         int res = ffurl_delete(filename);
         if (res < 0) {
@@ -1967,7 +2022,7 @@ static int dash_flush(AVFormatContext *s, int final, int stream)
             dashenc_io_close(s, &os->out, os->temp_path);
 
             if (use_rename) {
-                ret = ff_rename(os->temp_path, os->full_path, os->ctx);
+                ret = dashenc_rename(s, os->temp_path, os->full_path, os->ctx);
                 if (ret < 0)
                     break;
             }
@@ -2074,6 +2129,9 @@ static int dash_write_packet(AVFormatContext *s, AVPacket *pkt)
     int64_t seg_end_duration, elapsed_duration;
     int ret;
 
+    if (c->async_io_error < 0)
+        return c->async_io_error;
+
     ret = update_stream_extradata(s, os, pkt, &st->avg_frame_rate);
     if (ret < 0)
         return ret;
@@ -2330,6 +2388,10 @@ static int dash_write_trailer(AVFormatContext *s)
         }
     }
 
+    if (c->writer_pool) {
+        ff_writer_pool_flush(c->writer_pool, 1);
+        return c->async_io_error;
+    }
     return 0;
 }
 
@@ -2358,6 +2420,8 @@ static int dash_check_bitstream(AVFormatContext *s, AVStream *st,
 #define E AV_OPT_FLAG_ENCODING_PARAM
 static const AVOption options[] = {
     { "adaptation_sets", "Adaptation sets. Syntax: id=0,streams=0,1,2 id=1,streams=3,4 and so on", OFFSET(adaptation_sets), AV_OPT_TYPE_STRING, { 0 }, 0, 0, AV_OPT_FLAG_ENCODING_PARAM },
+    { "async_io", "Write segments and manifests in a background thread", OFFSET(async_io), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
+    { "async_io_queue_size", "Maximum number of files waiting to be written with async_io", OFFSET(async_io_queue_size), AV_OPT_TYPE_INT, { .i64 = 16 }, 1, 1024, E },
     { "dash_segment_type", "set dash segment files type", OFFSET(segment_type_option), AV_OPT_TYPE_INT, {.i64 = SEGMENT_TYPE_AUTO }, 0, SEGMENT_TYPE_NB - 1, E, .unit = "segment_type"},
         { "auto", "select segment file format based on codec", 0, AV_OPT_TYPE_CONST, {.i64 = SEGMENT_TYPE_AUTO }, 0, UINT_MAX,   E, .unit = "segment_type"},
         { "mp4", "make segment file in ISOBMFF format", 0, AV_OPT_TYPE_CONST, {.i64 = SEGMENT_TYPE_MP4 }, 0, UINT_MAX,   E, .unit = "segment_type"},
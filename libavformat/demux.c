@@ -25,6 +25,7 @@
 
 #include "libavutil/avassert.h"
 #include "libavutil/avstring.h"
+#include "libavutil/cpu.h"
 #include "libavutil/dict.h"
 #include "libavutil/internal.h"
 #include "libavutil/intreadwrite.h"
@@ -32,6 +33,7 @@
 #include "libavutil/mem.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixfmt.h"
+#include "libavutil/slicethread.h"
 #include "libavutil/time.h"
 #include "libavutil/timestamp.h"
 
@@ -2084,6 +2086,19 @@ static int has_codec_parameters(const AVStream *st, const char **errmsg_ptr)
     return 1;
 }
 
+/**
+ * Whether decoding more frames may still provide missing stream parameters.
+ * Must only be called once the decoder is open.
+ */
+static int decode_needed(AVStream *st)
+{
+    const FFStream *const sti = cffstream(st);
+
+    return !has_codec_parameters(st, NULL) || !has_decode_delay_been_guessed(st) ||
+           (!sti->codec_info_nb_frames &&
+            (sti->avctx->codec->capabilities & AV_CODEC_CAP_CHANNEL_CONF));
+}
+
 /* returns 1 or 0 if or if not decoded data was returned, or a negative error */
 static int try_decode_frame(AVFormatContext *s, AVStream *st,
                             const AVPacket *pkt, AVDictionary **options)
@@ -2146,10 +2161,7 @@ static int try_decode_frame(AVFormatContext *s, AVStream *st,
     }
 
     while ((pkt_to_send || (!pkt->data && got_picture)) &&
-           ret >= 0 &&
-           (!has_codec_parameters(st, NULL) || !has_decode_delay_been_guessed(st) ||
-            (!sti->codec_info_nb_frames &&
-             (avctx->codec->capabilities & AV_CODEC_CAP_CHANNEL_CONF)))) {
+           ret >= 0 && decode_needed(st)) {
         got_picture = 0;
         if (avctx->codec_type == AVMEDIA_TYPE_VIDEO ||
             avctx->codec_type == AVMEDIA_TYPE_AUDIO) {
@@ -2187,6 +2199,143 @@ fail:
     return ret;
 }
 
+typedef struct DecodeThreadContext {
+    AVFormatContext *ic;
+    AVDictionary **options;
+    unsigned orig_nb_streams;
+
+    AVSliceThread *thread;
+    int nb_threads;
+
+    /* indices of the streams to decode in the next batch */
+    unsigned *jobs;
+    unsigned jobs_size;
+    int nb_queued_streams;
+    int nb_queued_packets;
+
+    /* if set, drain the decoders with this empty packet */
+    const AVPacket *flush_pkt;
+} DecodeThreadContext;
+
+static void decode_thread_worker(void *priv, int jobnr, int threadnr,
+                                 int nb_jobs, int nb_threads)
+{
+    DecodeThreadContext *const dt = priv;
+    AVFormatContext *const ic = dt->ic;
+    const unsigned i = dt->jobs[jobnr];
+    AVStream *const st  = ic->streams[i];
+    FFStream *const sti = ffstream(st);
+    AVDictionary **const options = dt->options && i < dt->orig_nb_streams ?
+                                   &dt->options[i] : NULL;
+    int nb_frames;
+
+    if (dt->flush_pkt) {
+        if (try_decode_frame(ic, st, dt->flush_pkt, options) < 0)
+            av_log(ic, AV_LOG_INFO, "decoding for stream %d failed\n", st->index);
+        return;
+    }
+
+    /* The main thread is waiting for us, so the frame counter of the stream
+     * can temporarily be rewound to what it was when each packet was read. */
+    nb_frames = sti->codec_info_nb_frames;
+    sti->codec_info_nb_frames = sti->info->decode_queue_nb_frames;
+    for (const PacketListEntry *pktl = sti->info->decode_queue.head;
+         pktl; pktl = pktl->next) {
+        try_decode_frame(ic, st, &pktl->pkt, options);
+        sti->codec_info_nb_frames++;
+    }
+    sti->codec_info_nb_frames = nb_frames;
+    avpriv_packet_list_free(&sti->info->decode_queue);
+}
+
+static int decode_thread_init(DecodeThreadContext *dt, AVFormatContext *ic,
+                              AVDictionary **options, unsigned orig_nb_streams)
+{
+    int nb_threads = ic->analyze_threads ? ic->analyze_threads : av_cpu_count();
+
+    memset(dt, 0, sizeof(*dt));
+    dt->ic              = ic;
+    dt->options         = options;
+    dt->orig_nb_streams = orig_nb_streams;
+
+    if (nb_threads <= 1)
+        return 0;
+
+    nb_threads = avpriv_slicethread_create(&dt->thread, dt, decode_thread_worker,
+                                           NULL, nb_threads);
+    if (nb_threads == AVERROR(ENOSYS))
+        return 0;
+    if (nb_threads < 0)
+        return nb_threads;
+    dt->nb_threads = nb_threads;
+
+    return 0;
+}
+
+/**
+ * Decode all queued packets, or drain all decoders if flush_pkt is set,
+ * running one job per stream.
+ */
+static int decode_thread_run(DecodeThreadContext *dt, const AVPacket *flush_pkt)
+{
+    AVFormatContext *const ic = dt->ic;
+    int nb_jobs = 0;
+
+    if (!dt->thread || (!flush_pkt && !dt->nb_queued_streams))
+        return 0;
+
+    av_fast_malloc(&dt->jobs, &dt->jobs_size, ic->nb_streams * sizeof(*dt->jobs));
+    if (!dt->jobs)
+        return AVERROR(ENOMEM);
+
+    for (unsigned i = 0; i < ic->nb_streams; i++) {
+        const FFStream *const sti = ffstream(ic->streams[i]);
+        if (flush_pkt ? sti->info->found_decoder == 1 : !!sti->info->decode_queue.head)
+            dt->jobs[nb_jobs++] = i;
+    }
+
+    dt->flush_pkt = flush_pkt;
+    if (nb_jobs)
+        avpriv_slicethread_execute(dt->thread, nb_jobs, 0);
+    dt->flush_pkt         = NULL;
+    dt->nb_queued_streams = 0;
+    dt->nb_queued_packets = 0;
+
+    return 0;
+}
+
+/**
+ * Queue a packet for decoding by the worker threads. The queued packets are
+ * decoded once enough streams or packets are waiting.
+ */
+static int decode_thread_queue(DecodeThreadContext *dt, AVStream *st,
+                               const AVPacket *pkt)
+{
+    FFStream *const sti = ffstream(st);
+    int ret;
+
+    if (!sti->info->decode_queue.head) {
+        sti->info->decode_queue_nb_frames = sti->codec_info_nb_frames;
+        dt->nb_queued_streams++;
+    }
+    ret = avpriv_packet_list_put(&sti->info->decode_queue, (AVPacket *)pkt,
+                                 av_packet_ref, 0);
+    if (ret < 0)
+        return ret;
+    dt->nb_queued_packets++;
+
+    if (dt->nb_queued_streams >= dt->nb_threads ||
+        dt->nb_queued_packets >= 8 * dt->nb_threads)
+        return decode_thread_run(dt, NULL);
+    return 0;
+}
+
+static void decode_thread_uninit(DecodeThreadContext *dt)
+{
+    avpriv_slicethread_free(&dt->thread);
+    av_freep(&dt->jobs);
+}
+
 static int chapter_start_cmp(const void *p1, const void *p2)
 {
     const AVChapter *const ch1 = *(AVChapter**)p1;
@@ -2529,9 +2678,14 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
     int64_t probesize = ic->probesize;
     int eof_reached = 0;
     int *missing_streams = av_opt_ptr(ic->iformat->priv_class, ic->priv_data, "missing_streams");
+    DecodeThreadContext dt;
 
     flush_codecs = probesize > 0;
 
+    ret = decode_thread_init(&dt, ic, options, orig_nb_streams);
+    if (ret < 0)
+        return ret;
+
     av_opt_set_int(ic, "skip_clear", 1, AV_OPT_SEARCH_CHILDREN);
 
     max_stream_analyze_duration = max_analyze_duration;
@@ -2837,8 +2991,17 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
          * least one frame of codec data, this makes sure the codec initializes
          * the channel configuration and does not only trust the values from
          * the container. */
-        try_decode_frame(ic, st, pkt,
-                         (options && i < orig_nb_streams) ? &options[i] : NULL);
+        if (sti->info->found_decoder <= 0 || sti->info->decode_queue.head ||
+            decode_needed(st)) {
+            if (dt.thread) {
+                ret = decode_thread_queue(&dt, st, pkt);
+                if (ret < 0)
+                    goto unref_then_goto_end;
+            } else {
+                try_decode_frame(ic, st, pkt,
+                                 (options && i < orig_nb_streams) ? &options[i] : NULL);
+            }
+        }
 
         if (ic->flags & AVFMT_FLAG_NOBUFFER)
             av_packet_unref(pkt1);
@@ -2847,6 +3010,12 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
         count++;
     }
 
+    err = decode_thread_run(&dt, NULL);
+    if (err < 0) {
+        ret = err;
+        goto find_stream_info_err;
+    }
+
     if (eof_reached) {
         for (unsigned stream_index = 0; stream_index < ic->nb_streams; stream_index++) {
             AVStream *const st = ic->streams[stream_index];
@@ -2877,7 +3046,15 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
         int err = 0;
         av_packet_unref(empty_pkt);
 
-        for (unsigned i = 0; i < ic->nb_streams; i++) {
+        if (dt.thread) {
+            err = decode_thread_run(&dt, empty_pkt);
+            if (err < 0) {
+                ret = err;
+                goto find_stream_info_err;
+            }
+        }
+
+        for (unsigned i = 0; i < ic->nb_streams && !dt.thread; i++) {
             AVStream *const st  = ic->streams[i];
             FFStream *const sti = ffstream(st);
 
@@ -3098,6 +3275,7 @@ find_stream_info_err:
         int err;
 
         if (sti->info) {
+            avpriv_packet_list_free(&sti->info->decode_queue);
             av_freep(&sti->info->duration_error);
             av_freep(&sti->info);
         }
@@ -3115,6 +3293,7 @@ find_stream_info_err:
         av_log(ic, AV_LOG_DEBUG, "After avformat_find_stream_info() pos: %"PRId64" bytes read:%"PRId64" seeks:%d frames:%d\n",
                avio_tell(ic->pb), ctx->bytes_read, ctx->seek_count, count);
     }
+    decode_thread_uninit(&dt);
     return ret;
 
 unref_then_goto_end:
@@ -24,6 +24,7 @@
 #include <stdint.h>
 #include "libavutil/rational.h"
 #include "libavcodec/packet.h"
+#include "libavcodec/packet_internal.h"
 #include "avformat.h"
 
 struct AVDeviceInfoList;
@@ -34,6 +35,13 @@ struct AVDeviceInfoList;
  */
 #define FF_INFMT_FLAG_INIT_CLEANUP                             (1 << 0)
 
+/**
+ * Inclusive range of two-byte sequences, as big-endian 16-bit values.
+ */
+typedef struct FFProbePairRange {
+    uint16_t first, last;
+} FFProbePairRange;
+
 typedef struct FFInputFormat {
     /**
      * The public AVInputFormat. See avformat.h for it.
@@ -62,6 +70,14 @@ typedef struct FFInputFormat {
      */
     int (*read_probe)(const AVProbeData *);
 
+    /**
+     * Optional list of byte pair ranges, terminated by an entry with
+     * last == 0. read_probe() must return 0 for every buffer (including
+     * its padding) in which none of these pairs occur, so that the probing
+     * code can skip it without scanning the buffer again.
+     */
+    const FFProbePairRange *probe_pairs;
+
     /**
      * Read the format header and initialize the AVFormatContext
      * structure. Return 0 if OK. 'avformat_new_stream' should be
@@ -162,6 +178,14 @@ typedef struct FFStreamInfo {
     int     fps_first_dts_idx;
     int64_t fps_last_dts;
     int     fps_last_dts_idx;
+
+    /**
+     * Packets waiting to be decoded by a worker thread when
+     * AVFormatContext.analyze_threads is used, and the value of
+     * FFStream.codec_info_nb_frames for the first of them.
+     */
+    PacketList decode_queue;
+    int decode_queue_nb_frames;
 } FFStreamInfo;
 
 /**
@@ -711,12 +711,18 @@ static int dv_probe(const AVProbeData *p)
     return 0;
 }
 
+/* DIF section header */
+static const FFProbePairRange dv_probe_pairs[] = {
+    { 0x1F07, 0x1F07 }, { 0xFF3F, 0xFF3F }, { 0 }
+};
+
 const FFInputFormat ff_dv_demuxer = {
     .p.name         = "dv",
     .p.long_name    = NULL_IF_CONFIG_SMALL("DV (Digital Video)"),
     .p.extensions   = "dv,dif",
     .priv_data_size = sizeof(RawDVContext),
     .read_probe     = dv_probe,
+    .probe_pairs    = dv_probe_pairs,
     .read_header    = dv_read_header,
     .read_packet    = dv_read_packet,
     .read_seek      = dv_read_seek,
@@ -22,6 +22,7 @@
 #include "config_components.h"
 
 #include "libavutil/avstring.h"
+#include "libavutil/intreadwrite.h"
 #include "libavutil/mem.h"
 #include "libavutil/opt.h"
 
@@ -151,6 +152,32 @@ const AVInputFormat *av_find_input_format(const char *short_name)
     return NULL;
 }
 
+/**
+ * Mark every two-byte sequence of the probe buffer and its padding in a
+ * 65536 bit map, so that demuxers declaring probe_pairs can be ruled out
+ * without running their read_probe() over the whole buffer.
+ */
+static void probe_pairs_init(uint64_t *map, const AVProbeData *pd)
+{
+    const uint8_t *buf = pd->buf;
+    const uint8_t *end = buf + pd->buf_size + AVPROBE_PADDING_SIZE - 1;
+
+    memset(map, 0, (1 << 16) / 8);
+    for (; buf < end; buf++) {
+        unsigned v = AV_RB16(buf);
+        map[v >> 6] |= UINT64_C(1) << (v & 63);
+    }
+}
+
+static int probe_pairs_match(const uint64_t *map, const FFProbePairRange *r)
+{
+    for (; r->last; r++)
+        for (unsigned v = r->first; v <= r->last; v++)
+            if (map[v >> 6] >> (v & 63) & 1)
+                return 1;
+    return 0;
+}
+
 const AVInputFormat *av_probe_input_format3(const AVProbeData *pd,
                                             int is_opened, int *score_ret)
 {
@@ -160,6 +187,8 @@ const AVInputFormat *av_probe_input_format3(const AVProbeData *pd,
     int score, score_max = 0;
     void *i = 0;
     const static uint8_t zerobuffer[AVPROBE_PADDING_SIZE];
+    uint64_t pairs[(1 << 16) / 64];
+    int pairs_init = 0;
     enum nodat {
         NO_ID3,
         ID3_ALMOST_GREATER_PROBE,
@@ -190,7 +219,11 @@ const AVInputFormat *av_probe_input_format3(const AVProbeData *pd,
             continue;
         score = 0;
         if (ffifmt(fmt1)->read_probe) {
-            score = ffifmt(fmt1)->read_probe(&lpd);
+            if (ffifmt(fmt1)->probe_pairs && !pairs_init++)
+                probe_pairs_init(pairs, &lpd);
+            if (!ffifmt(fmt1)->probe_pairs ||
+                probe_pairs_match(pairs, ffifmt(fmt1)->probe_pairs))
+                score = ffifmt(fmt1)->read_probe(&lpd);
             if (score)
                 av_log(NULL, AV_LOG_TRACE, "Probing %s score:%d size:%d\n", fmt1->name, score, lpd.buf_size);
             if (fmt1->extensions && av_match_ext(lpd.filename, fmt1->extensions)) {
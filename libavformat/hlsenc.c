@@ -54,6 +54,7 @@
 #include "mux.h"
 #include "os_support.h"
 #include "url.h"
+#include "writer_pool.h"
 
 typedef enum {
     HLS_START_SEQUENCE_AS_START_NUMBER = 0,
@@ -74,6 +75,13 @@ typedef enum {
 #define BUFSIZE (16 * 1024)
 #define POSTFIX_PATTERN "_%d"
 
+typedef struct HLSPart {
+    double duration; /* in seconds */
+    int64_t pos;     /* position in the segment file */
+    int64_t size;
+    int independent;
+} HLSPart;
+
 typedef struct HLSSegment {
     char filename[MAX_URL_SIZE];
     char sub_filename[MAX_URL_SIZE];
@@ -90,6 +98,9 @@ typedef struct HLSSegment {
 
     struct HLSSegment *next;
     double discont_program_date_time;
+
+    HLSPart *parts;
+    int nb_parts;
 } HLSSegment;
 
 typedef enum HLSFlags {
@@ -145,6 +156,12 @@ typedef struct VariantStream {
     double duration;      // last segment duration computed so far, in seconds
     int64_t start_pos;    // last segment starting position
     int64_t size;         // last segment size
+    HLSPart *parts;       // parts of the current segment written so far
+    int nb_parts;
+    int64_t part_start_pts;
+    int part_independent; // current part starts with a keyframe
+    int part_written;     // bytes of the segment buffer already written as parts
+    int64_t part_pos;     // position of the current part in the segment file
     int nb_entries;
     int discontinuity_set;
     int discontinuity;
@@ -262,6 +279,13 @@ typedef struct HLSContext {
     char *headers;
     int has_default_key; /* has DEFAULT field of var_stream_map */
     int has_video_m3u8; /* has video stream m3u8 list */
+
+    int async_io;
+    int async_io_queue_size;
+    FFWriterPool *writer_pool; /* writes the files in the background with async_io */
+    int async_io_error; /* first error writing a file in the background */
+    int64_t part_time;  /* duration of the LL-HLS partial segments */
+    int can_block_reload; /* the server answers _HLS_msn/_HLS_part requests */
 } HLSContext;
 
 static int strftime_expand(const char *fmt, char **dest)
@@ -293,6 +317,8 @@ static int hlsenc_io_open(AVFormatContext *s, AVIOContext **pb, const char *file
     HLSContext *hls = s->priv_data;
     int http_base_proto = filename ? ff_is_http_proto(filename) : 0;
     int err = AVERROR_MUXER_NOT_FOUND;
+    if (hls->writer_pool)
+        return ff_writer_pool_open(hls->writer_pool, pb, filename, options ? *options : NULL);
     if (!*pb || !http_base_proto || !hls->http_persistent) {
         err = s->io_open(s, pb, filename, AVIO_FLAG_WRITE, options);
 #if CONFIG_HTTP_PROTOCOL
@@ -315,6 +341,8 @@ static int hlsenc_io_close(AVFormatContext *s, AVIOContext **pb, char *filename)
     int ret = 0;
     if (!*pb)
         return ret;
+    if (hls->writer_pool)
+        return ff_writer_pool_close(hls->writer_pool, pb, NULL, NULL);
     if (!http_base_proto || !hls->http_persistent || hls->key_info_file || hls->encrypt) {
         ff_format_io_close(s, pb);
 #if CONFIG_HTTP_PROTOCOL
@@ -328,6 +356,36 @@ static int hlsenc_io_close(AVFormatContext *s, AVIOContext **pb, char *filename)
     return ret;
 }
 
+/* Close a file, also ending a persistent HTTP connection. */
+static void hlsenc_io_close_final(AVFormatContext *s, AVIOContext **pb, char *filename)
+{
+    HLSContext *hls = s->priv_data;
+
+    if (hls->writer_pool)
+        hlsenc_io_close(s, pb, filename);
+    else
+        ff_format_io_close(s, pb);
+}
+
+static int hlsenc_rename(AVFormatContext *s, const char *url_src, const char *url_dst)
+{
+    HLSContext *hls = s->priv_data;
+
+    if (hls->writer_pool)
+        return ff_writer_pool_rename(hls->writer_pool, url_src, url_dst);
+    return ff_rename(url_src, url_dst, s);
+}
+
+/* Called by the writer pool for each file written in the background. */
+static int hls_async_io_done(AVFormatContext *s, void *opaque, int ret)
+{
+    HLSContext *hls = s->priv_data;
+
+    if (ret < 0 && !hls->ignore_io_errors && !hls->async_io_error)
+        hls->async_io_error = ret;
+    return 0;
+}
+
 static void set_http_options(AVFormatContext *s, AVDictionary **options, HLSContext *c)
 {
     int http_base_proto = ff_is_http_proto(s->url);
@@ -560,10 +618,11 @@ static int flush_dynbuf(VariantStream *vs, int *range_length)
     // flush
     av_write_frame(ctx, NULL);
 
-    // write out to file
+    // write out to file, except what was already written as parts
     *range_length = avio_close_dyn_buf(ctx->pb, &vs->temp_buffer);
     ctx->pb = NULL;
-    avio_write(vs->out, vs->temp_buffer, *range_length);
+    avio_write(vs->out, vs->temp_buffer + vs->part_written,
+               *range_length - vs->part_written);
     avio_flush(vs->out);
 
     // re-open buffer
@@ -593,6 +652,8 @@ static int hls_delete_file(HLSContext *hls, AVFormatContext *avf,
 
         //Nothing to write
         hlsenc_io_close(avf, &hls->http_delete, path);
+    } else if (hls->writer_pool) {
+        return ff_writer_pool_delete(hls->writer_pool, path);
     } else if (unlink(path) < 0) {
         av_log(hls, AV_LOG_ERROR, "failed to delete old segment %s: %s\n",
                path, strerror(errno));
@@ -1050,10 +1111,11 @@ static int sls_flag_check_duration_size(HLSContext *hls, VariantStream *vs)
     return ret;
 }
 
-static void sls_flag_file_rename(HLSContext *hls, VariantStream *vs, char *old_filename) {
+static void sls_flag_file_rename(AVFormatContext *s, VariantStream *vs, char *old_filename) {
+    HLSContext *hls = s->priv_data;
     if ((hls->flags & (HLS_SECOND_LEVEL_SEGMENT_SIZE | HLS_SECOND_LEVEL_SEGMENT_DURATION)) &&
         strlen(vs->current_segment_final_filename_fmt)) {
-        ff_rename(old_filename, vs->avf->url, hls);
+        hlsenc_rename(s, old_filename, vs->avf->url);
     }
 }
 
@@ -1156,6 +1218,10 @@ static int hls_append_segment(struct AVFormatContext *s, HLSContext *hls,
     en->next     = NULL;
     en->discont  = 0;
     en->discont_program_date_time = 0;
+    en->parts    = vs->parts;
+    en->nb_parts = vs->nb_parts;
+    vs->parts    = NULL;
+    vs->nb_parts = 0;
 
     if (vs->discontinuity) {
         en->discont = 1;
@@ -1183,6 +1249,7 @@ static int hls_append_segment(struct AVFormatContext *s, HLSContext *hls,
         if (!en->next->discont_program_date_time && !en->discont_program_date_time)
             vs->initial_prog_date_time += en->duration;
         vs->segments = en->next;
+        av_freep(&en->parts);
         if (en && hls->flags & HLS_DELETE_SEGMENTS &&
                 !(hls->flags & HLS_SINGLE_FILE)) {
             en->next = vs->old_segments;
@@ -1322,6 +1389,7 @@ static void hls_free_segments(HLSSegment *p)
     while (p) {
         en = p;
         p = p->next;
+        av_freep(&en->parts);
         av_freep(&en);
     }
 }
@@ -1335,7 +1403,7 @@ static int hls_rename_temp_file(AVFormatContext *s, AVFormatContext *oc)
     if (!final_filename)
         return AVERROR(ENOMEM);
     final_filename[len-4] = '\0';
-    ret = ff_rename(oc->url, final_filename, s);
+    ret = hlsenc_rename(s, oc->url, final_filename);
     oc->url[len-4] = '\0';
     av_freep(&final_filename);
     return ret;
@@ -1551,7 +1619,7 @@ fail:
         hls->master_m3u8_created = 1;
     hlsenc_io_close(s, &hls->m3u8_out, temp_filename);
     if (use_temp_file)
-        ff_rename(temp_filename, hls->master_m3u8_url, s);
+        hlsenc_rename(s, temp_filename, hls->master_m3u8_url);
 
     return ret;
 }
@@ -1575,6 +1643,10 @@ static int hls_window(AVFormatContext *s, int last, VariantStream *vs)
     double prog_date_time = vs->initial_prog_date_time;
     double *prog_date_time_p = (hls->flags & HLS_PROGRAM_DATE_TIME) ? &prog_date_time : NULL;
     int byterange_mode = (hls->flags & HLS_SINGLE_FILE) || (hls->max_seg_size > 0);
+    /* with parts, vs->out holds the segment being written */
+    AVIOContext **m3u8_out = byterange_mode || hls->part_time > 0 ? &hls->m3u8_out : &vs->out;
+    double part_window = 0;
+    int i;
 
     hls->version = 2;
     if (!(hls->flags & HLS_ROUND_DURATIONS)) {
@@ -1603,7 +1675,7 @@ static int hls_window(AVFormatContext *s, int last, VariantStream *vs)
 
     set_http_options(s, &options, hls);
     snprintf(temp_filename, sizeof(temp_filename), use_temp_file ? "%s.tmp" : "%s", vs->m3u8_name);
-    ret = hlsenc_io_open(s, byterange_mode ? &hls->m3u8_out : &vs->out, temp_filename, &options);
+    ret = hlsenc_io_open(s, m3u8_out, temp_filename, &options);
     av_dict_free(&options);
     if (ret < 0) {
         goto fail;
@@ -1612,36 +1684,53 @@ static int hls_window(AVFormatContext *s, int last, VariantStream *vs)
     for (en = vs->segments; en; en = en->next) {
         if (target_duration <= en->duration)
             target_duration = lrint(en->duration);
+        part_window += en->duration;
+    }
+    if (hls->part_time > 0) {
+        /* The segment in progress is not listed yet */
+        target_duration = FFMAX(target_duration, lrint(hls->time / (double)AV_TIME_BASE));
+        /* Parts are listed for the last three target durations */
+        part_window -= 3 * target_duration;
     }
 
     vs->discontinuity_set = 0;
-    ff_hls_write_playlist_header(byterange_mode ? hls->m3u8_out : vs->out, hls->version, hls->allowcache,
+    ff_hls_write_playlist_header(*m3u8_out, hls->version, hls->allowcache,
                                  target_duration, sequence, hls->pl_type, hls->flags & HLS_I_FRAMES_ONLY);
 
     if ((hls->flags & HLS_DISCONT_START) && sequence==hls->start_sequence && vs->discontinuity_set==0) {
-        avio_printf(byterange_mode ? hls->m3u8_out : vs->out, "#EXT-X-DISCONTINUITY\n");
+        avio_printf(*m3u8_out, "#EXT-X-DISCONTINUITY\n");
         vs->discontinuity_set = 1;
     }
     if (vs->has_video && (hls->flags & HLS_INDEPENDENT_SEGMENTS)) {
-        avio_printf(byterange_mode ? hls->m3u8_out : vs->out, "#EXT-X-INDEPENDENT-SEGMENTS\n");
+        avio_printf(*m3u8_out, "#EXT-X-INDEPENDENT-SEGMENTS\n");
     }
+    if (hls->part_time > 0)
+        ff_hls_write_part_info(*m3u8_out, hls->part_time / (double)AV_TIME_BASE,
+                               hls->can_block_reload);
     for (en = vs->segments; en; en = en->next) {
         if ((hls->encrypt || hls->key_info_file) && (!key_uri || strcmp(en->key_uri, key_uri) ||
                                     av_strcasecmp(en->iv_string, iv_string))) {
-            avio_printf(byterange_mode ? hls->m3u8_out : vs->out, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\"", en->key_uri);
+            avio_printf(*m3u8_out, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\"", en->key_uri);
             if (*en->iv_string)
-                avio_printf(byterange_mode ? hls->m3u8_out : vs->out, ",IV=0x%s", en->iv_string);
-            avio_printf(byterange_mode ? hls->m3u8_out : vs->out, "\n");
+                avio_printf(*m3u8_out, ",IV=0x%s", en->iv_string);
+            avio_printf(*m3u8_out, "\n");
             key_uri = en->key_uri;
             iv_string = en->iv_string;
         }
 
         if ((hls->segment_type == SEGMENT_TYPE_FMP4) && (en == vs->segments)) {
-            ff_hls_write_init_file(byterange_mode ? hls->m3u8_out : vs->out, (hls->flags & HLS_SINGLE_FILE) ? en->filename : vs->fmp4_init_filename,
+            ff_hls_write_init_file(*m3u8_out, (hls->flags & HLS_SINGLE_FILE) ? en->filename : vs->fmp4_init_filename,
                                    hls->flags & HLS_SINGLE_FILE, vs->init_range_length, 0);
         }
 
-        ret = ff_hls_write_file_entry(byterange_mode ? hls->m3u8_out : vs->out, en->discont, byterange_mode,
+        if (part_window < en->duration) {
+            for (i = 0; i < en->nb_parts; i++)
+                ff_hls_write_part(*m3u8_out, en->parts[i].duration, hls->baseurl, en->filename,
+                                  en->parts[i].size, en->parts[i].pos, en->parts[i].independent);
+        }
+        part_window -= en->duration;
+
+        ret = ff_hls_write_file_entry(*m3u8_out, en->discont, byterange_mode,
                                       en->duration, hls->flags & HLS_ROUND_DURATIONS,
                                       en->size, en->pos, hls->baseurl,
                                       en->filename,
@@ -1654,8 +1743,22 @@ static int hls_window(AVFormatContext *s, int last, VariantStream *vs)
         }
     }
 
+    if (hls->part_time > 0 && !last && vs->init_range_length) {
+        const char *filename = hls->use_localtime_mkdir ? vs->avf->url : av_basename(vs->avf->url);
+        int64_t pos = 0;
+
+        if (!vs->segments)
+            ff_hls_write_init_file(*m3u8_out, vs->fmp4_init_filename, 0, vs->init_range_length, 0);
+        for (i = 0; i < vs->nb_parts; i++) {
+            ff_hls_write_part(*m3u8_out, vs->parts[i].duration, hls->baseurl, filename,
+                              vs->parts[i].size, vs->parts[i].pos, vs->parts[i].independent);
+            pos = vs->parts[i].pos + vs->parts[i].size;
+        }
+        ff_hls_write_preload_hint(*m3u8_out, hls->baseurl, filename, pos);
+    }
+
     if (last && (hls->flags & HLS_OMIT_ENDLIST)==0)
-        ff_hls_write_end_list(byterange_mode ? hls->m3u8_out : vs->out);
+        ff_hls_write_end_list(*m3u8_out);
 
     if (vs->vtt_m3u8_name) {
         set_http_options(vs->vtt_avf, &options, hls);
@@ -1683,15 +1786,15 @@ static int hls_window(AVFormatContext *s, int last, VariantStream *vs)
 
 fail:
     av_dict_free(&options);
-    ret = hlsenc_io_close(s, byterange_mode ? &hls->m3u8_out : &vs->out, temp_filename);
+    ret = hlsenc_io_close(s, m3u8_out, temp_filename);
     if (ret < 0) {
         return ret;
     }
     hlsenc_io_close(s, &hls->sub_m3u8_out, vs->vtt_m3u8_name);
     if (use_temp_file) {
-        ff_rename(temp_filename, vs->m3u8_name, s);
+        hlsenc_rename(s, temp_filename, vs->m3u8_name);
         if (vs->vtt_m3u8_name)
-            ff_rename(temp_vtt_filename, vs->vtt_m3u8_name, s);
+            hlsenc_rename(s, temp_vtt_filename, vs->vtt_m3u8_name);
     }
     if (ret >= 0 && hls->master_pl_name)
         if (create_master_playlist(s, vs, last) < 0)
@@ -2432,6 +2535,113 @@ static int64_t append_single_file(AVFormatContext *s, VariantStream *vs)
 
     return ret;
 }
+static int hls_write_init_segment(AVFormatContext *s, VariantStream *vs)
+{
+    HLSContext *hls = s->priv_data;
+    AVFormatContext *oc = vs->avf;
+    int byterange_mode = (hls->flags & HLS_SINGLE_FILE) || (hls->max_seg_size > 0);
+    int range_length;
+
+    range_length = avio_close_dyn_buf(oc->pb, &vs->init_buffer);
+    if (range_length <= 0)
+        return AVERROR(EINVAL);
+    avio_write(vs->out, vs->init_buffer, range_length);
+    if (!hls->resend_init_file)
+        av_freep(&vs->init_buffer);
+    vs->init_range_length = range_length;
+    avio_open_dyn_buf(&oc->pb);
+    vs->start_pos = range_length;
+    if (!byterange_mode) {
+        hlsenc_io_close(s, &vs->out, vs->base_output_dirname);
+    }
+    return 0;
+}
+
+static int hls_append_part(VariantStream *vs, double duration)
+{
+    HLSPart *parts, *part;
+    int64_t pos = avio_tell(vs->out);
+
+    parts = av_realloc_array(vs->parts, vs->nb_parts + 1, sizeof(*parts));
+    if (!parts)
+        return AVERROR(ENOMEM);
+    vs->parts = parts;
+
+    part = &parts[vs->nb_parts];
+    part->pos         = vs->nb_parts ? part[-1].pos + part[-1].size : 0;
+    part->size        = pos - vs->part_pos;
+    part->duration    = duration;
+    part->independent = vs->part_independent;
+    vs->nb_parts++;
+    vs->part_pos = pos;
+
+    return 0;
+}
+
+/* The last part of a segment covers what the previous ones did not. */
+static int hls_append_last_part(VariantStream *vs, double segment_duration)
+{
+    double duration = segment_duration;
+    int i;
+
+    for (i = 0; i < vs->nb_parts; i++)
+        duration -= vs->parts[i].duration;
+    vs->part_written   = 0;
+    vs->part_start_pts = AV_NOPTS_VALUE;
+
+    return hls_append_part(vs, FFMAX(duration, 0));
+}
+
+/**
+ * Cut a fragment and append it to the current segment file, opening it for
+ * the first part, then update the playlist. The segment file is kept open
+ * until the end of the segment, so that over HTTP the parts are uploaded
+ * with chunked transfer encoding as they are produced.
+ */
+static int hls_write_part(AVFormatContext *s, VariantStream *vs, double duration)
+{
+    HLSContext *hls = s->priv_data;
+    AVFormatContext *oc = vs->avf;
+    uint8_t *buf;
+    int ret, size;
+
+    av_write_frame(oc, NULL); /* Flush any buffered data */
+    if (!vs->init_range_length) {
+        /* The first flush only writes the moov */
+        if ((ret = hls_write_init_segment(s, vs)) < 0)
+            return ret;
+        av_write_frame(oc, NULL);
+    }
+
+    if (!vs->nb_parts) {
+        AVDictionary *options = NULL;
+
+        set_http_options(s, &options, hls);
+        ret = hlsenc_io_open(s, &vs->out, oc->url, &options);
+        av_dict_free(&options);
+        if (ret < 0) {
+            av_log(s, hls->ignore_io_errors ? AV_LOG_WARNING : AV_LOG_ERROR,
+                   "Failed to open file '%s'\n", oc->url);
+            return hls->ignore_io_errors ? 0 : ret;
+        }
+        vs->part_pos = avio_tell(vs->out);
+        write_styp(vs->out);
+    }
+
+    size = avio_get_dyn_buf(oc->pb, &buf);
+    avio_write(vs->out, buf + vs->part_written, size - vs->part_written);
+    avio_flush(vs->out);
+    vs->part_written = size;
+
+    ret = hls_append_part(vs, duration);
+    if (ret < 0)
+        return ret;
+
+    if (hls->pl_type != PLAYLIST_TYPE_VOD)
+        return hls_window(s, 0, vs);
+    return 0;
+}
+
 static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
 {
     HLSContext *hls = s->priv_data;
@@ -2447,6 +2657,9 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
     VariantStream *vs = NULL;
     char *old_filename = NULL;
 
+    if (hls->async_io_error < 0)
+        return hls->async_io_error;
+
     for (i = 0; i < hls->nb_varstreams; i++) {
         int subtitle_streams = 0;
         vs = &hls->var_streams[i];
@@ -2535,19 +2748,9 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
         avio_flush(oc->pb);
         if (hls->segment_type == SEGMENT_TYPE_FMP4) {
             if (!vs->init_range_length) {
-                range_length = avio_close_dyn_buf(oc->pb, &vs->init_buffer);
-                if (range_length <= 0)
-                    return AVERROR(EINVAL);
-                avio_write(vs->out, vs->init_buffer, range_length);
-                if (!hls->resend_init_file)
-                    av_freep(&vs->init_buffer);
-                vs->init_range_length = range_length;
-                avio_open_dyn_buf(&oc->pb);
+                if ((ret = hls_write_init_segment(s, vs)) < 0)
+                    return ret;
                 vs->packets_written = 0;
-                vs->start_pos = range_length;
-                if (!byterange_mode) {
-                    hlsenc_io_close(s, &vs->out, vs->base_output_dirname);
-                }
             }
         }
         if (!byterange_mode) {
@@ -2593,18 +2796,25 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
 
                 set_http_options(s, &options, hls);
 
-                ret = hlsenc_io_open(s, &vs->out, filename, &options);
-                if (ret < 0) {
-                    av_log(s, hls->ignore_io_errors ? AV_LOG_WARNING : AV_LOG_ERROR,
-                           "Failed to open file '%s'\n", filename);
-                    av_freep(&filename);
-                    av_dict_free(&options);
-                    return hls->ignore_io_errors ? 0 : ret;
-                }
-                if (hls->segment_type == SEGMENT_TYPE_FMP4) {
-                    write_styp(vs->out);
+                /* with parts, the segment file is already open */
+                if (!vs->nb_parts) {
+                    ret = hlsenc_io_open(s, &vs->out, filename, &options);
+                    if (ret < 0) {
+                        av_log(s, hls->ignore_io_errors ? AV_LOG_WARNING : AV_LOG_ERROR,
+                               "Failed to open file '%s'\n", filename);
+                        av_freep(&filename);
+                        av_dict_free(&options);
+                        return hls->ignore_io_errors ? 0 : ret;
+                    }
+                    vs->part_pos = avio_tell(vs->out);
+                    if (hls->segment_type == SEGMENT_TYPE_FMP4) {
+                        write_styp(vs->out);
+                    }
                 }
                 ret = flush_dynbuf(vs, &range_length);
+                if (ret >= 0 && hls->part_time > 0)
+                    ret = hls_append_last_part(vs, (double)(pkt->pts - vs->end_pts) *
+                                                   st->time_base.num / st->time_base.den);
                 if (ret < 0) {
                     av_freep(&filename);
                     av_dict_free(&options);
@@ -2649,7 +2859,8 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
         }
 
         // if we're building a VOD playlist, skip writing the manifest multiple times, and just wait until the end
-        if (hls->pl_type != PLAYLIST_TYPE_VOD) {
+        // with parts, wait for the next segment to be started to announce its first part
+        if (hls->pl_type != PLAYLIST_TYPE_VOD && !hls->part_time) {
             if ((ret = hls_window(s, 0, vs)) < 0) {
                 av_log(s, AV_LOG_WARNING, "upload playlist failed, will retry with a new http session.\n");
                 ff_format_io_close(s, &vs->out);
@@ -2678,7 +2889,7 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
         } else if (hls->max_seg_size > 0) {
             if (vs->size + vs->start_pos >= hls->max_seg_size) {
                 vs->sequence++;
-                sls_flag_file_rename(hls, vs, old_filename);
+                sls_flag_file_rename(s, vs, old_filename);
                 ret = hls_start(s, vs);
                 vs->start_pos = 0;
                 /* When split segment by byte, the duration is short than hls_time,
@@ -2688,7 +2899,7 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
             }
         } else {
             vs->start_pos = 0;
-            sls_flag_file_rename(hls, vs, old_filename);
+            sls_flag_file_rename(s, vs, old_filename);
             ret = hls_start(s, vs);
         }
         vs->number++;
@@ -2697,6 +2908,27 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
         if (ret < 0) {
             return ret;
         }
+
+        if (hls->pl_type != PLAYLIST_TYPE_VOD && hls->part_time > 0) {
+            if ((ret = hls_window(s, 0, vs)) < 0)
+                return ret;
+        }
+    }
+
+    if (hls->part_time > 0 && is_ref_pkt && oc == vs->avf) {
+        if (vs->part_start_pts != AV_NOPTS_VALUE && pkt->pts > vs->part_start_pts &&
+            av_compare_ts(pkt->pts + pkt->duration - vs->part_start_pts, st->time_base,
+                          hls->part_time, AV_TIME_BASE_Q) > 0) {
+            ret = hls_write_part(s, vs, (double)(pkt->pts - vs->part_start_pts) *
+                                        st->time_base.num / st->time_base.den);
+            if (ret < 0)
+                return ret;
+            vs->part_start_pts = AV_NOPTS_VALUE;
+        }
+        if (vs->part_start_pts == AV_NOPTS_VALUE) {
+            vs->part_start_pts   = pkt->pts;
+            vs->part_independent = !vs->has_video || (pkt->flags & AV_PKT_FLAG_KEY);
+        }
     }
 
     vs->packets_written++;
@@ -2730,16 +2962,28 @@ static void hls_deinit(AVFormatContext *s)
         av_freep(&vs->vtt_basename);
         av_freep(&vs->vtt_m3u8_name);
 
+        if (hls->writer_pool) {
+            ff_writer_pool_discard(hls->writer_pool, &vs->out);
+            if (vs->vtt_avf)
+                ff_writer_pool_discard(hls->writer_pool, &vs->vtt_avf->pb);
+        }
         avformat_free_context(vs->vtt_avf);
         avformat_free_context(vs->avf);
         if (hls->resend_init_file)
             av_freep(&vs->init_buffer);
         hls_free_segments(vs->segments);
         hls_free_segments(vs->old_segments);
+        av_freep(&vs->parts);
         av_freep(&vs->m3u8_name);
         av_freep(&vs->streams);
     }
 
+    if (hls->writer_pool) {
+        ff_writer_pool_discard(hls->writer_pool, &hls->m3u8_out);
+        ff_writer_pool_discard(hls->writer_pool, &hls->sub_m3u8_out);
+        ff_writer_pool_discard(hls->writer_pool, &hls->http_delete);
+        ff_writer_pool_free(&hls->writer_pool);
+    }
     ff_format_io_close(s, &hls->m3u8_out);
     ff_format_io_close(s, &hls->sub_m3u8_out);
     ff_format_io_close(s, &hls->http_delete);
@@ -2801,23 +3045,26 @@ static int hls_write_trailer(struct AVFormatContext *s)
                 vs->packets_written = 0;
                 vs->start_pos = range_length;
                 byterange_mode = (hls->flags & HLS_SINGLE_FILE) || (hls->max_seg_size > 0);
-                if (!byterange_mode) {
-                    ff_format_io_close(s, &vs->out);
-                    hlsenc_io_close(s, &vs->out, vs->base_output_dirname);
-                }
+                if (!byterange_mode)
+                    hlsenc_io_close_final(s, &vs->out, vs->base_output_dirname);
             }
         }
         if (!(hls->flags & HLS_SINGLE_FILE)) {
             set_http_options(s, &options, hls);
-            ret = hlsenc_io_open(s, &vs->out, filename, &options);
-            if (ret < 0) {
-                av_log(s, AV_LOG_ERROR, "Failed to open file '%s'\n", oc->url);
-                goto failed;
+            if (!vs->nb_parts) {
+                ret = hlsenc_io_open(s, &vs->out, filename, &options);
+                if (ret < 0) {
+                    av_log(s, AV_LOG_ERROR, "Failed to open file '%s'\n", oc->url);
+                    goto failed;
+                }
+                vs->part_pos = avio_tell(vs->out);
+                if (hls->segment_type == SEGMENT_TYPE_FMP4)
+                    write_styp(vs->out);
             }
-            if (hls->segment_type == SEGMENT_TYPE_FMP4)
-                write_styp(vs->out);
         }
         ret = flush_dynbuf(vs, &range_length);
+        if (ret >= 0 && hls->part_time > 0)
+            ret = hls_append_last_part(vs, vs->duration + vs->dpp);
         if (ret < 0)
             goto failed;
 
@@ -2866,13 +3113,13 @@ failed:
         /* after av_write_trailer, then duration + 1 duration per packet */
         hls_append_segment(s, hls, vs, vs->duration + vs->dpp, vs->start_pos, vs->size);
 
-        sls_flag_file_rename(hls, vs, old_filename);
+        sls_flag_file_rename(s, vs, old_filename);
 
         if (vtt_oc) {
             if (vtt_oc->pb)
                 av_write_trailer(vtt_oc);
             vs->size = avio_tell(vs->vtt_avf->pb) - vs->start_pos;
-            ff_format_io_close(s, &vtt_oc->pb);
+            hlsenc_io_close_final(s, &vtt_oc->pb, vtt_oc->url);
         }
         ret = hls_window(s, 1, vs);
         if (ret < 0) {
@@ -2885,6 +3132,10 @@ failed:
         av_free(old_filename);
     }
 
+    if (hls->writer_pool) {
+        ff_writer_pool_flush(hls->writer_pool, 1);
+        return hls->async_io_error;
+    }
     return 0;
 }
 
@@ -2924,6 +3175,33 @@ static int hls_init(AVFormatContext *s)
         av_log(hls, AV_LOG_WARNING, "No HTTP method set, hls muxer defaulting to method PUT.\n");
     }
 
+    if (hls->part_time > 0) {
+        if (hls->segment_type != SEGMENT_TYPE_FMP4) {
+            av_log(s, AV_LOG_ERROR, "hls_part_time requires hls_segment_type fmp4\n");
+            return AVERROR(EINVAL);
+        }
+        if ((hls->flags & (HLS_SINGLE_FILE | HLS_TEMP_FILE)) || hls->max_seg_size > 0 ||
+            hls->key_info_file || hls->encrypt || hls->async_io) {
+            av_log(s, AV_LOG_ERROR, "hls_part_time is not supported with single_file, temp_file, "
+                   "hls_segment_size, encryption or async_io\n");
+            return AVERROR(EINVAL);
+        }
+    }
+
+    if (hls->async_io) {
+        if ((hls->flags & HLS_SINGLE_FILE) || hls->max_seg_size > 0) {
+            av_log(s, AV_LOG_ERROR, "async_io is not supported with single_file or hls_segment_size\n");
+            return AVERROR(EINVAL);
+        }
+        if (hls->http_persistent)
+            av_log(s, AV_LOG_WARNING, "http_persistent is ignored with async_io\n");
+        /* a single thread keeps segments, playlists and deletions in order */
+        ret = ff_writer_pool_alloc(&hls->writer_pool, s, 1, hls->async_io_queue_size,
+                                   FF_WRITER_POOL_FLAG_IGNORE_OPTIONS, hls_async_io_done);
+        if (ret < 0)
+            return ret;
+    }
+
     ret = validate_name(hls->nb_varstreams, s->url);
     if (ret < 0)
         return ret;
@@ -2995,6 +3273,7 @@ static int hls_init(AVFormatContext *s)
         vs->sequence  = hls->start_sequence;
         vs->start_pts = AV_NOPTS_VALUE;
         vs->end_pts   = AV_NOPTS_VALUE;
+        vs->part_start_pts = AV_NOPTS_VALUE;
         vs->current_segment_final_filename_fmt[0] = '\0';
         vs->initial_prog_date_time = initial_program_date_time;
 
@@ -3201,6 +3480,10 @@ static const AVOption options[] = {
     {"timeout", "set timeout for socket I/O operations", OFFSET(timeout), AV_OPT_TYPE_DURATION, { .i64 = -1 }, -1, INT_MAX, .flags = E },
     {"ignore_io_errors", "Ignore IO errors for stable long-duration runs with network output", OFFSET(ignore_io_errors), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
     {"headers", "set custom HTTP headers, can override built in default headers", OFFSET(headers), AV_OPT_TYPE_STRING, { .str = NULL }, 0, 0, E },
+    {"hls_part_time", "set the duration of the LL-HLS partial segments, 0 to disable them", OFFSET(part_time), AV_OPT_TYPE_DURATION, {.i64 = 0}, 0, INT64_MAX, E},
+    {"hls_can_block_reload", "advertise LL-HLS blocking playlist reload, which the HTTP server has to implement", OFFSET(can_block_reload), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, E},
+    {"async_io", "write segments and playlists in a background thread", OFFSET(async_io), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
+    {"async_io_queue_size", "maximum number of files waiting to be written with async_io", OFFSET(async_io_queue_size), AV_OPT_TYPE_INT, { .i64 = 16 }, 1, 1024, E },
     { NULL },
 };
 
@@ -62,6 +62,8 @@ typedef struct VideoDemuxData {
     int frame_size;
     int ts_from_file;
     int export_path_metadata; /**< enabled when set to 1. */
+    int prefetch;           /**< number of images read ahead, set by a private option. */
+    struct ImgPrefetchContext *prefetch_ctx;
 } VideoDemuxData;
 
 typedef struct IdStrMap {
@@ -32,6 +32,7 @@
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/intreadwrite.h"
+#include "libavutil/thread.h"
 #include "libavcodec/gif.h"
 #include "avformat.h"
 #include "avio_internal.h"
@@ -410,6 +411,255 @@ static int add_filename_as_pkt_side_data(char *filename, AVPacket *pkt) {
     return 0;
 }
 
+static int get_image_filename(VideoDemuxData *s, int number,
+                              char *buf, int buf_size, char **filename)
+{
+    *filename = buf;
+    if (s->pattern_type == PT_NONE) {
+        av_strlcpy(buf, s->path, buf_size);
+    } else if (s->use_glob) {
+#if HAVE_GLOB
+        *filename = s->globstate.gl_pathv[number];
+#endif
+    } else {
+        if (av_get_frame_filename(buf, buf_size, s->path, number) < 0 && number > 1)
+            return AVERROR(EIO);
+    }
+    return 0;
+}
+
+#if HAVE_THREADS
+enum PrefetchState {
+    PREFETCH_IDLE,
+    PREFETCH_PENDING,
+    PREFETCH_DONE,
+};
+
+typedef struct ImgPrefetchSlot {
+    struct ImgPrefetchContext *ctx;
+    pthread_t thread;
+    pthread_cond_t cond;
+    enum PrefetchState state;
+    int number;             ///< image number the slot is (being) filled with
+    int ret;
+    AVPacket *pkt;
+} ImgPrefetchSlot;
+
+typedef struct ImgPrefetchContext {
+    AVFormatContext *s1;
+    ImgPrefetchSlot *slots;
+    int nb_slots;
+    int nb_threads;
+    int head;               ///< slot holding the next image to return
+    int next;               ///< next image number to schedule
+    int abort;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;    ///< signalled when a slot is done
+} ImgPrefetchContext;
+
+/**
+ * Read a whole image file into pkt. Called from the prefetch threads.
+ * @return the number of bytes read, 0 at end of file or a negative error
+ */
+static int prefetch_read_image(AVFormatContext *s1, int number, AVPacket *pkt)
+{
+    VideoDemuxData *s = s1->priv_data;
+    char filename_bytes[1024];
+    char *filename;
+    AVIOContext *f = NULL;
+    int64_t size;
+    int ret;
+
+    ret = get_image_filename(s, number, filename_bytes, sizeof(filename_bytes), &filename);
+    if (ret < 0)
+        return ret;
+    if (s1->io_open(s1, &f, filename, AVIO_FLAG_READ, NULL) < 0) {
+        av_log(s1, AV_LOG_ERROR, "Could not open file : %s\n", filename);
+        return AVERROR(EIO);
+    }
+    size = avio_size(f);
+    ret = size > INT_MAX ? AVERROR(ERANGE) : av_new_packet(pkt, size);
+    if (ret >= 0) {
+        ret = avio_read(f, pkt->data, pkt->size);
+        if (ret >= 0)
+            av_shrink_packet(pkt, ret);
+    }
+    ff_format_io_close(s1, &f);
+    return ret;
+}
+
+static void *prefetch_worker(void *arg)
+{
+    ImgPrefetchSlot *slot = arg;
+    ImgPrefetchContext *p = slot->ctx;
+
+    ff_thread_setname("img2-prefetch");
+
+    pthread_mutex_lock(&p->mutex);
+    while (!p->abort) {
+        int number, ret;
+
+        if (slot->state != PREFETCH_PENDING) {
+            pthread_cond_wait(&slot->cond, &p->mutex);
+            continue;
+        }
+        number = slot->number;
+        pthread_mutex_unlock(&p->mutex);
+
+        ret = prefetch_read_image(p->s1, number, slot->pkt);
+
+        pthread_mutex_lock(&p->mutex);
+        slot->ret   = ret;
+        slot->state = PREFETCH_DONE;
+        pthread_cond_signal(&p->cond);
+    }
+    pthread_mutex_unlock(&p->mutex);
+
+    return NULL;
+}
+
+/* Must be called with the mutex held. */
+static void prefetch_schedule(VideoDemuxData *s, ImgPrefetchSlot *slot)
+{
+    ImgPrefetchContext *p = s->prefetch_ctx;
+
+    if (p->next > s->img_last) {
+        if (!s->loop)
+            return;
+        p->next = s->img_first;
+    }
+    slot->number = p->next++;
+    slot->state  = PREFETCH_PENDING;
+    pthread_cond_signal(&slot->cond);
+}
+
+static void prefetch_uninit(VideoDemuxData *s)
+{
+    ImgPrefetchContext *p = s->prefetch_ctx;
+
+    if (!p)
+        return;
+
+    pthread_mutex_lock(&p->mutex);
+    p->abort = 1;
+    for (int i = 0; i < p->nb_threads; i++)
+        pthread_cond_signal(&p->slots[i].cond);
+    pthread_mutex_unlock(&p->mutex);
+
+    for (int i = 0; i < p->nb_threads; i++)
+        pthread_join(p->slots[i].thread, NULL);
+    for (int i = 0; i < p->nb_slots; i++) {
+        pthread_cond_destroy(&p->slots[i].cond);
+        av_packet_free(&p->slots[i].pkt);
+    }
+    pthread_cond_destroy(&p->cond);
+    pthread_mutex_destroy(&p->mutex);
+    av_freep(&p->slots);
+    av_freep(&s->prefetch_ctx);
+}
+
+static int prefetch_init(AVFormatContext *s1)
+{
+    VideoDemuxData *s = s1->priv_data;
+    ImgPrefetchContext *p;
+    int ret;
+
+    p = s->prefetch_ctx = av_mallocz(sizeof(*p));
+    if (!p)
+        return AVERROR(ENOMEM);
+    p->s1    = s1;
+    p->slots = av_calloc(s->prefetch, sizeof(*p->slots));
+    if (!p->slots) {
+        av_freep(&s->prefetch_ctx);
+        return AVERROR(ENOMEM);
+    }
+    if ((ret = pthread_mutex_init(&p->mutex, NULL))) {
+        av_freep(&p->slots);
+        av_freep(&s->prefetch_ctx);
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_cond_init(&p->cond, NULL))) {
+        pthread_mutex_destroy(&p->mutex);
+        av_freep(&p->slots);
+        av_freep(&s->prefetch_ctx);
+        return AVERROR(ret);
+    }
+
+    for (; p->nb_slots < s->prefetch; p->nb_slots++) {
+        ImgPrefetchSlot *slot = &p->slots[p->nb_slots];
+
+        slot->ctx = p;
+        slot->pkt = av_packet_alloc();
+        if (!slot->pkt) {
+            ret = AVERROR(ENOMEM);
+            goto fail;
+        }
+        if ((ret = pthread_cond_init(&slot->cond, NULL))) {
+            av_packet_free(&slot->pkt);
+            ret = AVERROR(ret);
+            goto fail;
+        }
+    }
+    for (; p->nb_threads < p->nb_slots; p->nb_threads++) {
+        ImgPrefetchSlot *slot = &p->slots[p->nb_threads];
+        if ((ret = pthread_create(&slot->thread, NULL, prefetch_worker, slot))) {
+            ret = AVERROR(ret);
+            goto fail;
+        }
+    }
+    return 0;
+fail:
+    av_log(s1, AV_LOG_ERROR, "Could not start prefetching: %s\n", av_err2str(ret));
+    prefetch_uninit(s);
+    return ret;
+}
+
+/**
+ * Return the image s->img_number read ahead by the prefetch threads in pkt,
+ * and queue the next one in its slot. The read ahead is restarted from
+ * s->img_number if it does not match the queued images, e.g. after seeking.
+ */
+static int prefetch_get_image(AVFormatContext *s1, AVPacket *pkt)
+{
+    VideoDemuxData *s = s1->priv_data;
+    ImgPrefetchContext *p = s->prefetch_ctx;
+    ImgPrefetchSlot *slot;
+    int ret;
+
+    if (!p) {
+        ret = prefetch_init(s1);
+        if (ret < 0)
+            return ret;
+        p = s->prefetch_ctx;
+    }
+
+    pthread_mutex_lock(&p->mutex);
+    slot = &p->slots[p->head];
+    if (slot->state == PREFETCH_IDLE || slot->number != s->img_number) {
+        for (int i = 0; i < p->nb_slots; i++) {
+            while (p->slots[i].state == PREFETCH_PENDING)
+                pthread_cond_wait(&p->cond, &p->mutex);
+            av_packet_unref(p->slots[i].pkt);
+            p->slots[i].state = PREFETCH_IDLE;
+        }
+        p->next = s->img_number;
+        for (int i = 0; i < p->nb_slots; i++)
+            prefetch_schedule(s, &p->slots[(p->head + i) % p->nb_slots]);
+    }
+    while (slot->state == PREFETCH_PENDING)
+        pthread_cond_wait(&p->cond, &p->mutex);
+
+    ret = slot->ret;
+    av_packet_move_ref(pkt, slot->pkt);
+    slot->state = PREFETCH_IDLE;
+    prefetch_schedule(s, slot);
+    p->head = (p->head + 1) % p->nb_slots;
+    pthread_mutex_unlock(&p->mutex);
+
+    return ret;
+}
+#endif
+
 int ff_img_read_packet(AVFormatContext *s1, AVPacket *pkt)
 {
     VideoDemuxData *s = s1->priv_data;
@@ -419,6 +669,7 @@ int ff_img_read_packet(AVFormatContext *s1, AVPacket *pkt)
     int size[3]           = { 0 }, ret[3] = { 0 };
     AVIOContext *f[3]     = { NULL };
     AVCodecParameters *par = s1->streams[0]->codecpar;
+    int prefetched = 0;
 
     if (!s->is_pipe) {
         /* loop over input */
@@ -427,19 +678,21 @@ int ff_img_read_packet(AVFormatContext *s1, AVPacket *pkt)
         }
         if (s->img_number > s->img_last)
             return AVERROR_EOF;
-        if (s->pattern_type == PT_NONE) {
-            av_strlcpy(filename_bytes, s->path, sizeof(filename_bytes));
-        } else if (s->use_glob) {
-#if HAVE_GLOB
-            filename = s->globstate.gl_pathv[s->img_number];
-#endif
-        } else {
-        if (av_get_frame_filename(filename_bytes, sizeof(filename_bytes),
-                                  s->path,
-                                  s->img_number) < 0 && s->img_number > 1)
-            return AVERROR(EIO);
+        res = get_image_filename(s, s->img_number, filename_bytes,
+                                 sizeof(filename_bytes), &filename);
+        if (res < 0)
+            return res;
+#if HAVE_THREADS
+        if (s->prefetch && s->pattern_type != PT_NONE &&
+            !s1->pb && !s->split_planes) {
+            res = prefetch_get_image(s1, pkt);
+            if (res <= 0)
+                return res ? res : AVERROR_EOF;
+            size[0] = ret[0] = res;
+            prefetched = 1;
         }
-        for (i = 0; i < 3; i++) {
+#endif
+        for (i = 0; i < 3 && !prefetched; i++) {
             if (s1->pb &&
                 !strcmp(filename_bytes, s->path) &&
                 !s->loop &&
@@ -466,11 +719,16 @@ int ff_img_read_packet(AVFormatContext *s1, AVPacket *pkt)
             int ret;
             int score = 0;
 
-            ret = avio_read(f[0], header, PROBE_BUF_MIN);
-            if (ret < 0)
-                return ret;
+            if (prefetched) {
+                ret = FFMIN(pkt->size, PROBE_BUF_MIN);
+                memcpy(header, pkt->data, ret);
+            } else {
+                ret = avio_read(f[0], header, PROBE_BUF_MIN);
+                if (ret < 0)
+                    return ret;
+                avio_skip(f[0], -ret);
+            }
             memset(header + ret, 0, sizeof(header) - ret);
-            avio_skip(f[0], -ret);
             pd.buf = header;
             pd.buf_size = ret;
             pd.filename = filename;
@@ -497,9 +755,10 @@ int ff_img_read_packet(AVFormatContext *s1, AVPacket *pkt)
         }
     }
 
-    res = av_new_packet(pkt, size[0] + size[1] + size[2]);
-    if (res < 0) {
-        goto fail;
+    if (!prefetched) {
+        res = av_new_packet(pkt, size[0] + size[1] + size[2]);
+        if (res < 0)
+            goto fail;
     }
     pkt->stream_index = 0;
     pkt->flags       |= AV_PKT_FLAG_KEY;
@@ -534,7 +793,8 @@ int ff_img_read_packet(AVFormatContext *s1, AVPacket *pkt)
             goto fail;
     }
 
-    pkt->size = 0;
+    if (!prefetched)
+        pkt->size = 0;
     for (i = 0; i < 3; i++) {
         if (f[i]) {
             ret[i] = avio_read(f[i], pkt->data + pkt->size, size[i]);
@@ -582,8 +842,11 @@ fail:
 
 static int img_read_close(struct AVFormatContext* s1)
 {
-#if HAVE_GLOB
     VideoDemuxData *s = s1->priv_data;
+#if HAVE_THREADS
+    prefetch_uninit(s);
+#endif
+#if HAVE_GLOB
     if (s->use_glob) {
         globfree(&s->globstate);
     }
@@ -634,6 +897,7 @@ const AVOption ff_img_options[] = {
     { "sec",  "second precision",       0, AV_OPT_TYPE_CONST,    {.i64 = 1   }, 0, 2,       DEC, .unit = "ts_type" },
     { "ns",   "nano second precision",  0, AV_OPT_TYPE_CONST,    {.i64 = 2   }, 0, 2,       DEC, .unit = "ts_type" },
     { "export_path_metadata", "enable metadata containing input path information", OFFSET(export_path_metadata), AV_OPT_TYPE_BOOL,   {.i64 = 0   }, 0, 1,       DEC }, \
+    { "prefetch", "set number of images to read ahead in background threads", OFFSET(prefetch), AV_OPT_TYPE_INT, {.i64 = 0 }, 0, 1024, DEC },
     COMMON_OPTIONS
 };
 
@@ -28,6 +28,7 @@
 #include "libavutil/avstring.h"
 #include "libavutil/dict.h"
 #include "libavutil/log.h"
+#include "libavutil/mem.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/time_internal.h"
@@ -36,6 +37,7 @@
 #include "internal.h"
 #include "img2.h"
 #include "mux.h"
+#include "writer_pool.h"
 
 typedef struct VideoMuxData {
     const AVClass *class;  /**< Class for private options. */
@@ -50,6 +52,8 @@ typedef struct VideoMuxData {
     const char *muxer;
     int use_rename;
     AVDictionary *protocol_opts;
+    int writer_threads;
+    FFWriterPool *writer_pool;
 } VideoMuxData;
 
 static int write_header(AVFormatContext *s)
@@ -75,6 +79,10 @@ static int write_header(AVFormatContext *s)
     }
     img->img_number = img->start_img_number;
 
+    if (img->writer_threads)
+        return ff_writer_pool_alloc(&img->writer_pool, s, img->writer_threads,
+                                    2 * img->writer_threads, 0, NULL);
+
     return 0;
 }
 
@@ -137,6 +145,63 @@ static int write_and_close(AVFormatContext *s, AVIOContext **pb, const unsigned
     return ff_format_io_close(s, pb);
 }
 
+/**
+ * Queue size bytes of pkt starting at offset to be written to the next file
+ * of the pool, or to its temporary name when writing atomically.
+ */
+static int submit_data(AVFormatContext *s, int i, const AVPacket *pkt, int offset, int size)
+{
+    VideoMuxData *img = s->priv_data;
+    AVBufferRef *buf;
+
+    if (pkt->buf) {
+        buf = av_buffer_ref(pkt->buf);
+        if (!buf)
+            return AVERROR(ENOMEM);
+        buf->data = pkt->data + offset;
+    } else {
+        buf = av_buffer_alloc(size);
+        if (!buf)
+            return AVERROR(ENOMEM);
+        memcpy(buf->data, pkt->data + offset, size);
+    }
+    buf->size = size;
+
+    return ff_writer_pool_submit(img->writer_pool,
+                                 img->use_rename ? img->tmp[i] : img->target[i],
+                                 img->use_rename ? img->target[i] : NULL,
+                                 img->protocol_opts, &buf, NULL);
+}
+
+static int submit_muxed_file(AVFormatContext *s, AVPacket *pkt)
+{
+    VideoMuxData *img = s->priv_data;
+    AVIOContext *dyn_pb;
+    AVBufferRef *buf;
+    uint8_t *data;
+    int ret, size;
+
+    ret = avio_open_dyn_buf(&dyn_pb);
+    if (ret < 0)
+        return ret;
+    ret = write_muxed_file(s, dyn_pb, pkt);
+    size = avio_close_dyn_buf(dyn_pb, &data);
+    if (ret < 0) {
+        av_free(data);
+        return ret;
+    }
+    buf = av_buffer_create(data, size, NULL, NULL, 0);
+    if (!buf) {
+        av_free(data);
+        return AVERROR(ENOMEM);
+    }
+
+    return ff_writer_pool_submit(img->writer_pool,
+                                 img->use_rename ? img->tmp[0] : img->target[0],
+                                 img->use_rename ? img->target[0] : NULL,
+                                 img->protocol_opts, &buf, NULL);
+}
+
 static int write_packet(AVFormatContext *s, AVPacket *pkt)
 {
     VideoMuxData *img = s->priv_data;
@@ -179,9 +244,15 @@ static int write_packet(AVFormatContext *s, AVPacket *pkt)
         }
     }
     for (i = 0; i < 4; i++) {
-        av_dict_copy(&options, img->protocol_opts, 0);
         snprintf(img->tmp[i], sizeof(img->tmp[i]), "%s.tmp", filename);
         av_strlcpy(img->target[i], filename, sizeof(img->target[i]));
+        if (img->writer_pool) {
+            if (!img->split_planes || i+1 >= desc->nb_components)
+                break;
+            filename[strlen(filename) - 1] = "UVAx"[i];
+            continue;
+        }
+        av_dict_copy(&options, img->protocol_opts, 0);
         if (s->io_open(s, &pb[i], img->use_rename ? img->tmp[i] : filename, AVIO_FLAG_WRITE, &options) < 0) {
             av_log(s, AV_LOG_ERROR, "Could not open file : %s\n", img->use_rename ? img->tmp[i] : filename);
             ret = AVERROR(EIO);
@@ -200,6 +271,31 @@ static int write_packet(AVFormatContext *s, AVPacket *pkt)
     if (img->use_rename)
         nb_renames = i + 1;
 
+    if (img->writer_pool) {
+        if (img->split_planes) {
+            int ysize = par->width * par->height;
+            int usize = AV_CEIL_RSHIFT(par->width, desc->log2_chroma_w) * AV_CEIL_RSHIFT(par->height, desc->log2_chroma_h);
+            if (desc->comp[0].depth >= 9) {
+                ysize *= 2;
+                usize *= 2;
+            }
+            if ((ret = submit_data(s, 0, pkt, 0                , ysize)) < 0 ||
+                (ret = submit_data(s, 1, pkt, ysize            , usize)) < 0 ||
+                (ret = submit_data(s, 2, pkt, ysize + usize    , usize)) < 0)
+                return ret;
+            if (desc->nb_components > 3)
+                ret = submit_data(s, 3, pkt, ysize + 2*usize, ysize);
+        } else if (img->muxer) {
+            ret = submit_muxed_file(s, pkt);
+        } else {
+            ret = submit_data(s, 0, pkt, 0, pkt->size);
+        }
+        if (ret < 0)
+            return ret;
+        img->img_number++;
+        return 0;
+    }
+
     if (img->split_planes) {
         int ysize = par->width * par->height;
         int usize = AV_CEIL_RSHIFT(par->width, desc->log2_chroma_w) * AV_CEIL_RSHIFT(par->height, desc->log2_chroma_h);
@@ -240,6 +336,22 @@ fail:
     return ret;
 }
 
+static int write_trailer(AVFormatContext *s)
+{
+    VideoMuxData *img = s->priv_data;
+
+    if (img->writer_pool)
+        return ff_writer_pool_flush(img->writer_pool, 1);
+    return 0;
+}
+
+static void deinit(AVFormatContext *s)
+{
+    VideoMuxData *img = s->priv_data;
+
+    ff_writer_pool_free(&img->writer_pool);
+}
+
 static int query_codec(enum AVCodecID id, int std_compliance)
 {
     int i;
@@ -260,6 +372,7 @@ static const AVOption muxoptions[] = {
     { "frame_pts",    "use current frame pts for filename", OFFSET(frame_pts),  AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, ENC },
     { "atomic_writing", "write files atomically (using temporary files and renames)", OFFSET(use_rename), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, ENC },
     { "protocol_opts", "specify protocol options for the opened files", OFFSET(protocol_opts), AV_OPT_TYPE_DICT, {0}, 0, 0, ENC },
+    { "writer_threads", "write files in this many background threads", OFFSET(writer_threads), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 64, ENC },
     { NULL },
 };
 
@@ -281,6 +394,8 @@ const FFOutputFormat ff_image2_muxer = {
     .p.video_codec  = AV_CODEC_ID_MJPEG,
     .write_header   = write_header,
     .write_packet   = write_packet,
+    .write_trailer  = write_trailer,
+    .deinit         = deinit,
     .query_codec    = query_codec,
     .p.flags        = AVFMT_NOTIMESTAMPS | AVFMT_NODIMENSIONS | AVFMT_NOFILE,
     .p.priv_class   = &img2mux_class,
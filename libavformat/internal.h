@@ -73,6 +73,24 @@ typedef struct FFFormatContext {
      */
     int nb_interleaved_streams;
 
+    /**
+     * Min-heap of the indices of the streams with packets in their
+     * FFStream.interleave_queue, ordered by the dts of the first queued
+     * packet. Only allocated when interleaving by dts without chunking;
+     * packet_buffer is used otherwise.
+     * Muxing only.
+     */
+    int *interleave_heap;
+    /**
+     * Number of streams in interleave_heap.
+     */
+    int nb_interleave_heap;
+    /**
+     * Number of streams with an empty interleave_queue which need not be
+     * waited for before applying max_interleave_delta.
+     */
+    int nb_interleave_idle;
+
     /**
      * Whether the timestamp shift offset has already been determined.
      * -1: disabled, 0: not yet determined, 1: determined.
@@ -190,6 +208,15 @@ static av_always_inline FFFormatContext *ffformatcontext(AVFormatContext *s)
     return (FFFormatContext*)s;
 }
 
+/**
+ * A timestamp found by a demuxer's read_timestamp() while seeking.
+ */
+typedef struct FFSeekPoint {
+    int64_t start_pos; ///< position the search started from
+    int64_t pos;       ///< position of the packet found
+    int64_t ts;
+} FFSeekPoint;
+
 typedef struct FFStream {
     /**
      * The public context.
@@ -251,6 +278,22 @@ typedef struct FFStream {
     int nb_index_entries;
     unsigned int index_entries_allocated_size;
 
+    /**
+     * Timestamps read by ff_gen_search(), sorted by start_pos, so that
+     * later seeks do not read them again. Limited by
+     * AVFormatContext.max_index_size.
+     */
+    FFSeekPoint *seek_points;
+    int nb_seek_points;
+    unsigned int seek_points_allocated_size;
+
+    /**
+     * Result of ff_find_last_ts() and the file size it was found for.
+     */
+    int64_t last_ts;
+    int64_t last_ts_pos;
+    int64_t last_ts_file_size;
+
     int64_t interleaver_chunk_size;
     int64_t interleaver_chunk_duration;
 
@@ -374,6 +417,12 @@ typedef struct FFStream {
      */
     PacketListEntry *last_in_packet_buffer;
 
+    /**
+     * Packets of this stream waiting to be interleaved when
+     * FFFormatContext.interleave_heap is used.
+     */
+    PacketList interleave_queue;
+
     int64_t last_IP_pts;
     int last_IP_duration;
 
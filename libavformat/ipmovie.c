@@ -700,11 +700,17 @@ static int ipmovie_read_packet(AVFormatContext *s,
     }
 }
 
+/* "In" of the signature */
+static const FFProbePairRange ipmovie_probe_pairs[] = {
+    { 0x496E, 0x496E }, { 0 }
+};
+
 const FFInputFormat ff_ipmovie_demuxer = {
     .p.name         = "ipmovie",
     .p.long_name    = NULL_IF_CONFIG_SMALL("Interplay MVE"),
     .priv_data_size = sizeof(IPMVEContext),
     .read_probe     = ipmovie_probe,
+    .probe_pairs    = ipmovie_probe_pairs,
     .read_header    = ipmovie_read_header,
     .read_packet    = ipmovie_read_packet,
 };
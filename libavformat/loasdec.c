@@ -84,12 +84,18 @@ static int loas_read_header(AVFormatContext *s)
     return 0;
 }
 
+/* LOAS syncword */
+static const FFProbePairRange loas_probe_pairs[] = {
+    { 0x56E0, 0x56FF }, { 0 }
+};
+
 const FFInputFormat ff_loas_demuxer = {
     .p.name         = "loas",
     .p.long_name    = NULL_IF_CONFIG_SMALL("LOAS AudioSyncStream"),
     .p.flags        = AVFMT_GENERIC_INDEX,
     .p.priv_class   = &ff_raw_demuxer_class,
     .read_probe     = loas_probe,
+    .probe_pairs    = loas_probe_pairs,
     .read_header    = loas_read_header,
     .read_packet    = ff_raw_read_partial_packet,
     .raw_codec_id = AV_CODEC_ID_AAC_LATM,
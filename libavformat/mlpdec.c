@@ -56,6 +56,11 @@ static int av_always_inline mlp_thd_probe(const AVProbeData *p, uint32_t sync)
     return 0;
 }
 
+/* first half of the major sync */
+static const FFProbePairRange mlp_probe_pairs[] = {
+    { 0xF872, 0xF872 }, { 0 }
+};
+
 static int mlp_read_header(AVFormatContext *s)
 {
     int ret = ff_raw_audio_read_header(s);
@@ -103,6 +108,7 @@ const FFInputFormat ff_mlp_demuxer = {
     .p.extensions   = "mlp",
     .p.priv_class   = &ff_raw_demuxer_class,
     .read_probe     = mlp_probe,
+    .probe_pairs    = mlp_probe_pairs,
     .read_header    = mlp_read_header,
     .read_packet    = ff_raw_read_partial_packet,
     .raw_codec_id   = AV_CODEC_ID_MLP,
@@ -123,6 +129,7 @@ const FFInputFormat ff_truehd_demuxer = {
     .p.extensions   = "thd",
     .p.priv_class   = &ff_raw_demuxer_class,
     .read_probe     = thd_probe,
+    .probe_pairs    = mlp_probe_pairs,
     .read_header    = mlp_read_header,
     .read_packet    = ff_raw_read_partial_packet,
     .raw_codec_id   = AV_CODEC_ID_TRUEHD,
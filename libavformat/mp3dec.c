@@ -607,6 +607,11 @@ static const AVClass demuxer_class = {
     .category   = AV_CLASS_CATEGORY_DEMUXER,
 };
 
+/* frame sync or "ID" of an ID3v2 tag */
+static const FFProbePairRange mp3_probe_pairs[] = {
+    { 0xFFE0, 0xFFFF }, { 0x4944, 0x4944 }, { 0 }
+};
+
 const FFInputFormat ff_mp3_demuxer = {
     .p.name         = "mp3",
     .p.long_name    = NULL_IF_CONFIG_SMALL("MP2/3 (MPEG audio layer 2/3)"),
@@ -614,6 +619,7 @@ const FFInputFormat ff_mp3_demuxer = {
     .p.extensions   = "mp2,mp3,m2a,mpa", /* XXX: use probe */
     .p.priv_class   = &demuxer_class,
     .read_probe     = mp3_read_probe,
+    .probe_pairs    = mp3_probe_pairs,
     .read_header    = mp3_read_header,
     .read_packet    = mp3_read_packet,
     .read_seek      = mp3_seek,
@@ -698,12 +698,18 @@ static int64_t mpegps_read_dts(AVFormatContext *s, int stream_index,
     return dts;
 }
 
+/* end of the 00 00 01 start code prefix */
+static const FFProbePairRange mpegps_probe_pairs[] = {
+    { 0x0001, 0x0001 }, { 0 }
+};
+
 const FFInputFormat ff_mpegps_demuxer = {
     .p.name         = "mpeg",
     .p.long_name    = NULL_IF_CONFIG_SMALL("MPEG-PS (MPEG-2 Program Stream)"),
     .p.flags        = AVFMT_SHOW_IDS | AVFMT_TS_DISCONT,
     .priv_data_size = sizeof(MpegDemuxContext),
     .read_probe     = mpegps_probe,
+    .probe_pairs    = mpegps_probe_pairs,
     .read_header    = mpegps_read_header,
     .read_packet    = mpegps_read_packet,
     .read_timestamp = mpegps_read_dts,
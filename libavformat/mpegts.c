@@ -3435,6 +3435,11 @@ void avpriv_mpegts_parse_close(MpegTSContext *ts)
     av_free(ts);
 }
 
+/* sync byte */
+static const FFProbePairRange mpegts_probe_pairs[] = {
+    { 0x4700, 0x47FF }, { 0 }
+};
+
 const FFInputFormat ff_mpegts_demuxer = {
     .p.name         = "mpegts",
     .p.long_name    = NULL_IF_CONFIG_SMALL("MPEG-TS (MPEG-2 Transport Stream)"),
@@ -3442,6 +3447,7 @@ const FFInputFormat ff_mpegts_demuxer = {
     .p.priv_class   = &mpegts_class,
     .priv_data_size = sizeof(MpegTSContext),
     .read_probe     = mpegts_probe,
+    .probe_pairs    = mpegts_probe_pairs,
     .read_header    = mpegts_read_header,
     .read_packet    = mpegts_read_packet,
     .read_close     = mpegts_read_close,
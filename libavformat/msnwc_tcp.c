@@ -137,10 +137,16 @@ static int msnwc_tcp_read_packet(AVFormatContext *ctx, AVPacket *pkt)
     return HEADER_SIZE + size;
 }
 
+/* "ML" of the ML20 fourcc */
+static const FFProbePairRange msnwc_tcp_probe_pairs[] = {
+    { 0x4D4C, 0x4D4C }, { 0 }
+};
+
 const FFInputFormat ff_msnwc_tcp_demuxer = {
     .p.name      = "msnwctcp",
     .p.long_name = NULL_IF_CONFIG_SMALL("MSN TCP Webcam stream"),
     .read_probe  = msnwc_tcp_probe,
+    .probe_pairs = msnwc_tcp_probe_pairs,
     .read_header = msnwc_tcp_read_header,
     .read_packet = msnwc_tcp_read_packet,
 };
@@ -182,6 +182,17 @@ static int validate_codec_tag(const AVFormatContext *s, const AVStream *st)
     return 1;
 }
 
+/**
+ * Whether max_interleave_delta may force output while a stream with these
+ * parameters has no packet queued.
+ */
+static int interleave_idle_ok(const AVCodecParameters *par)
+{
+    return par->codec_type != AVMEDIA_TYPE_ATTACHMENT &&
+           par->codec_id != AV_CODEC_ID_VP8 &&
+           par->codec_id != AV_CODEC_ID_VP9 &&
+           par->codec_id != AV_CODEC_ID_SMPTE_2038;
+}
 
 static int init_muxer(AVFormatContext *s, AVDictionary **options)
 {
@@ -354,6 +365,18 @@ FF_ENABLE_DEPRECATION_WARNINGS
                                     ff_interleave_packet_per_dts :
                                     ff_interleave_packet_passthrough;
 
+    if (si->interleave_packet == ff_interleave_packet_per_dts &&
+        !of->interleave_packet &&
+        !s->max_chunk_size && !s->max_chunk_duration) {
+        si->interleave_heap = av_calloc(s->nb_streams, sizeof(*si->interleave_heap));
+        if (!si->interleave_heap) {
+            ret = AVERROR(ENOMEM);
+            goto fail;
+        }
+        for (unsigned i = 0; i < s->nb_streams; i++)
+            si->nb_interleave_idle += interleave_idle_ok(s->streams[i]->codecpar);
+    }
+
     if (!s->priv_data && of->priv_data_size > 0) {
         s->priv_data = av_mallocz(of->priv_data_size);
         if (!s->priv_data) {
@@ -674,18 +697,22 @@ static void handle_avoid_negative_ts(FFFormatContext *si, FFStream *sti,
 
         /* Peek into the muxing queue to improve our estimate
          * of the lowest timestamp if av_interleaved_write_frame() is used. */
-        for (const PacketListEntry *pktl = si->packet_buffer.head;
-             pktl; pktl = pktl->next) {
-            AVRational cmp_tb = s->streams[pktl->pkt.stream_index]->time_base;
-            int64_t cmp_ts = use_pts ? pktl->pkt.pts : pktl->pkt.dts;
-            if (cmp_ts == AV_NOPTS_VALUE)
-                continue;
-            cmp_ts -= ffstream(s->streams[pktl->pkt.stream_index])->lowest_ts_allowed;
-            if (s->output_ts_offset)
-                cmp_ts += av_rescale_q(s->output_ts_offset, AV_TIME_BASE_Q, cmp_tb);
-            if (av_compare_ts(cmp_ts, cmp_tb, ts, tb) < 0) {
-                ts = cmp_ts;
-                tb = cmp_tb;
+        for (unsigned i = 0; i < (si->interleave_heap ? s->nb_streams : 1); i++) {
+            const PacketListEntry *pktl = si->interleave_heap ?
+                                          ffstream(s->streams[i])->interleave_queue.head :
+                                          si->packet_buffer.head;
+            for (; pktl; pktl = pktl->next) {
+                AVRational cmp_tb = s->streams[pktl->pkt.stream_index]->time_base;
+                int64_t cmp_ts = use_pts ? pktl->pkt.pts : pktl->pkt.dts;
+                if (cmp_ts == AV_NOPTS_VALUE)
+                    continue;
+                cmp_ts -= ffstream(s->streams[pktl->pkt.stream_index])->lowest_ts_allowed;
+                if (s->output_ts_offset)
+                    cmp_ts += av_rescale_q(s->output_ts_offset, AV_TIME_BASE_Q, cmp_tb);
+                if (av_compare_ts(cmp_ts, cmp_tb, ts, tb) < 0) {
+                    ts = cmp_ts;
+                    tb = cmp_tb;
+                }
             }
         }
 
@@ -956,44 +983,151 @@ static int interleave_compare_dts(AVFormatContext *s, const AVPacket *next,
     return comp > 0;
 }
 
+/**
+ * Compare the first queued packets of two streams in interleave_heap.
+ * @return nonzero if the packet of stream a is to be output after the one
+ *         of stream b
+ */
+static int interleave_heap_cmp(AVFormatContext *s, int a, int b)
+{
+    return interleave_compare_dts(s, &ffstream(s->streams[a])->interleave_queue.head->pkt,
+                                     &ffstream(s->streams[b])->interleave_queue.head->pkt);
+}
+
+static void interleave_heap_sift_down(AVFormatContext *s)
+{
+    FFFormatContext *const si = ffformatcontext(s);
+    int *const heap = si->interleave_heap;
+    const int nb    = si->nb_interleave_heap;
+    const int top   = heap[0];
+    int i = 0;
+
+    while (2 * i + 1 < nb) {
+        int child = 2 * i + 1;
+        if (child + 1 < nb && interleave_heap_cmp(s, heap[child], heap[child + 1]))
+            child++;
+        if (!interleave_heap_cmp(s, top, heap[child]))
+            break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = top;
+}
+
+static int interleave_queue_packet(AVFormatContext *s, AVPacket *pkt)
+{
+    FFFormatContext *const si = ffformatcontext(s);
+    const int stream_index = pkt->stream_index;
+    AVStream *const st  = s->streams[stream_index];
+    FFStream *const sti = ffstream(st);
+    int *const heap = si->interleave_heap;
+    int was_empty = !sti->interleave_queue.head;
+    int ret, i;
+
+    /* Timestamps are monotonic within a stream, so a new packet can simply be
+     * appended to its stream's queue; the heap only changes when the first
+     * packet of a queue does. */
+    if ((ret = avpriv_packet_list_put(&sti->interleave_queue, pkt, NULL, 0)) < 0) {
+        av_packet_unref(pkt);
+        return ret;
+    }
+    if (!was_empty)
+        return 0;
+
+    si->nb_interleave_idle -= interleave_idle_ok(st->codecpar);
+    for (i = si->nb_interleave_heap++; i > 0; i = (i - 1) >> 1) {
+        int parent = (i - 1) >> 1;
+        if (!interleave_heap_cmp(s, heap[parent], stream_index))
+            break;
+        heap[i] = heap[parent];
+    }
+    heap[i] = stream_index;
+
+    return 0;
+}
+
+/**
+ * @return the packet to be output next, NULL if none is queued
+ */
+static const AVPacket *interleave_top(AVFormatContext *s)
+{
+    FFFormatContext *const si = ffformatcontext(s);
+
+    if (si->interleave_heap)
+        return si->nb_interleave_heap ?
+               &ffstream(s->streams[si->interleave_heap[0]])->interleave_queue.head->pkt : NULL;
+    return si->packet_buffer.head ? &si->packet_buffer.head->pkt : NULL;
+}
+
+/**
+ * Remove the packet returned by interleave_top() from the queue.
+ */
+static void interleave_get_top(AVFormatContext *s, AVPacket *pkt)
+{
+    FFFormatContext *const si = ffformatcontext(s);
+
+    if (si->interleave_heap) {
+        AVStream *const st  = s->streams[si->interleave_heap[0]];
+        FFStream *const sti = ffstream(st);
+
+        avpriv_packet_list_get(&sti->interleave_queue, pkt);
+        if (!sti->interleave_queue.head) {
+            si->interleave_heap[0] = si->interleave_heap[--si->nb_interleave_heap];
+            si->nb_interleave_idle += interleave_idle_ok(st->codecpar);
+        }
+        if (si->nb_interleave_heap)
+            interleave_heap_sift_down(s);
+    } else {
+        PacketListEntry *pktl = si->packet_buffer.head;
+        FFStream *const sti = ffstream(s->streams[pktl->pkt.stream_index]);
+
+        if (sti->last_in_packet_buffer == pktl)
+            sti->last_in_packet_buffer = NULL;
+        avpriv_packet_list_get(&si->packet_buffer, pkt);
+    }
+}
+
 int ff_interleave_packet_per_dts(AVFormatContext *s, AVPacket *pkt,
                                  int flush, int has_packet)
 {
     FFFormatContext *const si = ffformatcontext(s);
+    const AVPacket *top_pkt;
     int stream_count = 0;
     int noninterleaved_count = 0;
     int ret;
     int eof = flush;
 
     if (has_packet) {
-        if ((ret = ff_interleave_add_packet(s, pkt, interleave_compare_dts)) < 0)
+        ret = si->interleave_heap ? interleave_queue_packet(s, pkt) :
+              ff_interleave_add_packet(s, pkt, interleave_compare_dts);
+        if (ret < 0)
             return ret;
     }
 
-    for (unsigned i = 0; i < s->nb_streams; i++) {
-        const AVStream *const st  = s->streams[i];
-        const FFStream *const sti = cffstream(st);
-        const AVCodecParameters *const par = st->codecpar;
-        if (sti->last_in_packet_buffer) {
-            ++stream_count;
-        } else if (par->codec_type != AVMEDIA_TYPE_ATTACHMENT &&
-                   par->codec_id != AV_CODEC_ID_VP8 &&
-                   par->codec_id != AV_CODEC_ID_VP9 &&
-                   par->codec_id != AV_CODEC_ID_SMPTE_2038) {
-            ++noninterleaved_count;
+    if (si->interleave_heap) {
+        stream_count         = si->nb_interleave_heap;
+        noninterleaved_count = si->nb_interleave_idle;
+    } else {
+        for (unsigned i = 0; i < s->nb_streams; i++) {
+            const AVStream *const st  = s->streams[i];
+            const FFStream *const sti = cffstream(st);
+            if (sti->last_in_packet_buffer)
+                ++stream_count;
+            else
+                noninterleaved_count += interleave_idle_ok(st->codecpar);
         }
     }
 
     if (si->nb_interleaved_streams == stream_count)
         flush = 1;
 
+    top_pkt = interleave_top(s);
     if (s->max_interleave_delta > 0 &&
-        si->packet_buffer.head &&
-        si->packet_buffer.head->pkt.dts != AV_NOPTS_VALUE &&
+        top_pkt &&
+        top_pkt->dts != AV_NOPTS_VALUE &&
         !flush &&
         si->nb_interleaved_streams == stream_count+noninterleaved_count
     ) {
-        AVPacket *const top_pkt = &si->packet_buffer.head->pkt;
         int64_t delta_dts = INT64_MIN;
         int64_t top_dts = av_rescale_q(top_pkt->dts,
                                        s->streams[top_pkt->stream_index]->time_base,
@@ -1002,7 +1136,9 @@ int ff_interleave_packet_per_dts(AVFormatContext *s, AVPacket *pkt,
         for (unsigned i = 0; i < s->nb_streams; i++) {
             const AVStream *const st  = s->streams[i];
             const FFStream *const sti = cffstream(st);
-            const PacketListEntry *const last = sti->last_in_packet_buffer;
+            const PacketListEntry *const last = si->interleave_heap ?
+                                                sti->interleave_queue.tail :
+                                                sti->last_in_packet_buffer;
             int64_t last_dts;
 
             if (!last || st->codecpar->codec_type == AVMEDIA_TYPE_SUBTITLE)
@@ -1024,52 +1160,33 @@ int ff_interleave_packet_per_dts(AVFormatContext *s, AVPacket *pkt,
     }
 
 #if FF_API_LAVF_SHORTEST
-    if (si->packet_buffer.head &&
+    if (top_pkt &&
         eof &&
         (s->flags & AVFMT_FLAG_SHORTEST) &&
         si->shortest_end == AV_NOPTS_VALUE) {
-        AVPacket *const top_pkt = &si->packet_buffer.head->pkt;
-
         si->shortest_end = av_rescale_q(top_pkt->dts,
                                        s->streams[top_pkt->stream_index]->time_base,
                                        AV_TIME_BASE_Q);
     }
 
     if (si->shortest_end != AV_NOPTS_VALUE) {
-        while (si->packet_buffer.head) {
-            PacketListEntry *pktl = si->packet_buffer.head;
-            AVPacket *const top_pkt = &pktl->pkt;
-            AVStream *const st = s->streams[top_pkt->stream_index];
-            FFStream *const sti = ffstream(st);
-            int64_t top_dts = av_rescale_q(top_pkt->dts, st->time_base,
-                                        AV_TIME_BASE_Q);
+        while ((top_pkt = interleave_top(s))) {
+            int64_t top_dts = av_rescale_q(top_pkt->dts,
+                                           s->streams[top_pkt->stream_index]->time_base,
+                                           AV_TIME_BASE_Q);
 
             if (si->shortest_end + 1 >= top_dts)
                 break;
 
-            si->packet_buffer.head = pktl->next;
-            if (!si->packet_buffer.head)
-                si->packet_buffer.tail = NULL;
-
-            if (sti->last_in_packet_buffer == pktl)
-                sti->last_in_packet_buffer = NULL;
-
-            av_packet_unref(&pktl->pkt);
-            av_freep(&pktl);
+            interleave_get_top(s, pkt);
+            av_packet_unref(pkt);
             flush = 0;
         }
     }
 #endif
 
     if (stream_count && flush) {
-        PacketListEntry *pktl = si->packet_buffer.head;
-        AVStream *const st = s->streams[pktl->pkt.stream_index];
-        FFStream *const sti = ffstream(st);
-
-        if (sti->last_in_packet_buffer == pktl)
-            sti->last_in_packet_buffer = NULL;
-        avpriv_packet_list_get(&si->packet_buffer, pkt);
-
+        interleave_get_top(s, pkt);
         return 1;
     } else {
         return 0;
@@ -1102,6 +1219,11 @@ const AVPacket *ff_interleaved_peek(AVFormatContext *s, int stream)
 {
     FFFormatContext *const si = ffformatcontext(s);
     PacketListEntry *pktl = si->packet_buffer.head;
+
+    if (si->interleave_heap) {
+        pktl = ffstream(s->streams[stream])->interleave_queue.head;
+        return pktl ? &pktl->pkt : NULL;
+    }
     while (pktl) {
         if (pktl->pkt.stream_index == stream) {
             return &pktl->pkt;
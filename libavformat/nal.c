@@ -21,6 +21,8 @@
 #include <stdint.h>
 #include <string.h>
 
+#include "config.h"
+#include "libavutil/intreadwrite.h"
 #include "libavutil/mem.h"
 #include "libavutil/error.h"
 #include "libavcodec/defs.h"
@@ -38,7 +40,17 @@ static const uint8_t *nal_find_startcode_internal(const uint8_t *p, const uint8_
     }
 
     for (end -= 3; p < end; p += 4) {
-        uint32_t x = *(const uint32_t*)p;
+        uint32_t x;
+#if HAVE_FAST_64BIT
+        /* a start code beginning in p[0..7] has a zero byte in p[0..7] */
+        while (end - p > 8) {
+            uint64_t y = AV_RN64(p);
+            if ((y - 0x0101010101010101ULL) & ~y & 0x8080808080808080ULL)
+                break;
+            p += 8;
+        }
+#endif
+        x = *(const uint32_t*)p;
 //      if ((x - 0x01000100) & (~x) & 0x80008000) // little endian
 //      if ((x - 0x00010001) & (~x) & 0x00800080) // big endian
         if ((x - 0x01010101) & (~x) & 0x80808080) { // generic
@@ -1301,6 +1301,11 @@ static int read_seek(AVFormatContext *s, int stream_index,
     return 0;
 }
 
+/* "NM" of the main startcode */
+static const FFProbePairRange nut_probe_pairs[] = {
+    { 0x4E4D, 0x4E4D }, { 0 }
+};
+
 const FFInputFormat ff_nut_demuxer = {
     .p.name         = "nut",
     .p.long_name    = NULL_IF_CONFIG_SMALL("NUT"),
@@ -1310,6 +1315,7 @@ const FFInputFormat ff_nut_demuxer = {
     .priv_data_size = sizeof(NUTContext),
     .flags_internal = FF_INFMT_FLAG_INIT_CLEANUP,
     .read_probe     = nut_probe,
+    .probe_pairs    = nut_probe_pairs,
     .read_header    = nut_read_header,
     .read_packet    = nut_read_packet,
     .read_close     = nut_read_close,
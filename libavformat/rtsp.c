@@ -2493,12 +2493,18 @@ static const AVClass sdp_demuxer_class = {
     .version        = LIBAVUTIL_VERSION_INT,
 };
 
+/* "c=" of the connection line */
+static const FFProbePairRange sdp_probe_pairs[] = {
+    { 0x633D, 0x633D }, { 0 }
+};
+
 const FFInputFormat ff_sdp_demuxer = {
     .p.name         = "sdp",
     .p.long_name    = NULL_IF_CONFIG_SMALL("SDP"),
     .p.priv_class   = &sdp_demuxer_class,
     .priv_data_size = sizeof(RTSPState),
     .read_probe     = sdp_probe,
+    .probe_pairs    = sdp_probe_pairs,
     .read_header    = sdp_read_header,
     .read_packet    = ff_rtsp_fetch_packet,
     .read_close     = sdp_read_close,
@@ -188,11 +188,17 @@ static int s337m_read_packet(AVFormatContext *s, AVPacket *pkt)
     return 0;
 }
 
+/* Pa sync word of the 16/24-bit and the 20-bit markers */
+static const FFProbePairRange s337m_probe_pairs[] = {
+    { 0x72F8, 0x72F8 }, { 0x876F, 0x876F }, { 0 }
+};
+
 const FFInputFormat ff_s337m_demuxer = {
     .p.name         = "s337m",
     .p.long_name    = NULL_IF_CONFIG_SMALL("SMPTE 337M"),
     .p.flags        = AVFMT_GENERIC_INDEX,
     .read_probe     = s337m_probe,
+    .probe_pairs    = s337m_probe_pairs,
     .read_header    = s337m_read_header,
     .read_packet    = s337m_read_packet,
 };
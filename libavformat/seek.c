@@ -277,12 +277,81 @@ const AVIndexEntry *avformat_index_get_entry_from_timestamp(AVStream *st,
     return &sti->index_entries[idx];
 }
 
+/**
+ * @return the index of the first seek point starting after pos
+ */
+static int seek_point_search(const FFStream *sti, int64_t pos)
+{
+    int a = 0, b = sti->nb_seek_points;
+
+    while (a < b) {
+        int m = (a + b) >> 1;
+        if (sti->seek_points[m].start_pos <= pos)
+            a = m + 1;
+        else
+            b = m;
+    }
+    return a;
+}
+
+static void add_seek_point(AVFormatContext *s, FFStream *sti,
+                           int64_t start_pos, int64_t pos, int64_t ts)
+{
+    unsigned int max_entries = s->max_index_size / sizeof(FFSeekPoint);
+    FFSeekPoint *points;
+    int i;
+
+    if (!max_entries)
+        return;
+    if ((unsigned) sti->nb_seek_points >= max_entries) {
+        for (i = 0; 2 * i < sti->nb_seek_points; i++)
+            sti->seek_points[i] = sti->seek_points[2 * i];
+        sti->nb_seek_points = i;
+    }
+
+    i = seek_point_search(sti, start_pos);
+    if (i > 0 && sti->seek_points[i - 1].start_pos == start_pos) {
+        sti->seek_points[i - 1].pos = pos;
+        sti->seek_points[i - 1].ts  = ts;
+        return;
+    }
+
+    points = av_fast_realloc(sti->seek_points, &sti->seek_points_allocated_size,
+                             (sti->nb_seek_points + 1) * sizeof(*points));
+    if (!points)
+        return;
+    sti->seek_points = points;
+
+    memmove(points + i + 1, points + i,
+            (sti->nb_seek_points - i) * sizeof(*points));
+    points[i].start_pos = start_pos;
+    points[i].pos       = pos;
+    points[i].ts        = ts;
+    sti->nb_seek_points++;
+}
+
 static int64_t read_timestamp(AVFormatContext *s, int stream_index, int64_t *ppos, int64_t pos_limit,
                               int64_t (*read_timestamp)(struct AVFormatContext *, int , int64_t *, int64_t ))
 {
-    int64_t ts = read_timestamp(s, stream_index, ppos, pos_limit);
+    /* Only searches not bounded by pos_limit give reusable results */
+    FFStream *const sti = stream_index >= 0 && pos_limit == INT64_MAX ?
+                          ffstream(s->streams[stream_index]) : NULL;
+    int64_t start_pos = *ppos;
+    int64_t ts;
+
+    if (sti) {
+        int i = seek_point_search(sti, start_pos);
+        if (i > 0 && sti->seek_points[i - 1].start_pos == start_pos) {
+            *ppos = sti->seek_points[i - 1].pos;
+            return sti->seek_points[i - 1].ts;
+        }
+    }
+
+    ts = read_timestamp(s, stream_index, ppos, pos_limit);
     if (stream_index >= 0)
         ts = ff_wrap_timestamp(s->streams[stream_index], ts);
+    if (sti && ts != AV_NOPTS_VALUE)
+        add_seek_point(s, sti, start_pos, *ppos, ts);
     return ts;
 }
 
@@ -359,10 +428,20 @@ int ff_seek_frame_binary(AVFormatContext *s, int stream_index,
 int ff_find_last_ts(AVFormatContext *s, int stream_index, int64_t *ts, int64_t *pos,
                     int64_t (*read_timestamp_func)(struct AVFormatContext *, int , int64_t *, int64_t ))
 {
+    FFStream *const sti = stream_index >= 0 ? ffstream(s->streams[stream_index]) : NULL;
     int64_t step = 1024;
     int64_t limit, ts_max;
     int64_t filesize = avio_size(s->pb);
     int64_t pos_max  = filesize - 1;
+
+    if (sti && filesize > 0 && sti->last_ts_file_size == filesize) {
+        if (ts)
+            *ts  = sti->last_ts;
+        if (pos)
+            *pos = sti->last_ts_pos;
+        return 0;
+    }
+
     do {
         limit   = pos_max;
         pos_max = FFMAX(0, (pos_max) - step);
@@ -386,6 +465,12 @@ int ff_find_last_ts(AVFormatContext *s, int stream_index, int64_t *ts, int64_t *
             break;
     }
 
+    if (sti && filesize > 0) {
+        sti->last_ts           = ts_max;
+        sti->last_ts_pos       = pos_max;
+        sti->last_ts_file_size = filesize;
+    }
+
     if (ts)
         *ts  = ts_max;
     if (pos)
@@ -434,6 +519,32 @@ int64_t ff_gen_search(AVFormatContext *s, int stream_index, int64_t target_ts,
 
     av_assert0(ts_min < ts_max);
 
+    if (stream_index >= 0) {
+        /* Narrow the interval with the timestamps read by previous
+         * searches, as if they had been read again by the loop below. */
+        const FFStream *const sti = ffstream(s->streams[stream_index]);
+        int i;
+
+        for (i = seek_point_search(sti, pos_min); i < sti->nb_seek_points; i++) {
+            const FFSeekPoint *p = &sti->seek_points[i];
+            if (p->start_pos > pos_limit)
+                break;
+            if (p->start_pos <= pos_min)
+                continue;
+            if (target_ts <= p->ts) {
+                pos_limit = p->start_pos - 1;
+                pos_max   = p->pos;
+                ts_max    = p->ts;
+            }
+            if (target_ts >= p->ts) {
+                pos_min = p->pos;
+                ts_min  = p->ts;
+            }
+        }
+        av_log(s, AV_LOG_TRACE, "using seek points pos_min=0x%"PRIx64" pos_max=0x%"PRIx64
+                " pos_limit=0x%"PRIx64"\n", pos_min, pos_max, pos_limit);
+    }
+
     no_change = 0;
     while (pos_min < pos_limit) {
         av_log(s, AV_LOG_TRACE,
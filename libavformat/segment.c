@@ -29,8 +29,10 @@
 #include <time.h>
 
 #include "avformat.h"
+#include "avio_internal.h"
 #include "internal.h"
 #include "mux.h"
+#include "writer_pool.h"
 
 #include "libavutil/avassert.h"
 #include "libavutil/internal.h"
@@ -127,6 +129,13 @@ typedef struct SegmentContext {
     SegmentListEntry cur_entry;
     SegmentListEntry *segment_list_entries;
     SegmentListEntry *segment_list_entries_end;
+    int list_count;        ///< number of entries added to the segment list
+
+    int writer_threads;
+    FFWriterPool *writer_pool;
+    const SegmentListEntry *last_entry; ///< entry of the last segment, while it is written
+    FFIOContext *reader;   ///< in-memory segment re-opened for reading by the segment muxer
+    uint8_t *reader_data;
 } SegmentContext;
 
 static void print_csv_escaped_str(AVIOContext *ctx, const char *str)
@@ -145,6 +154,47 @@ static void print_csv_escaped_str(AVIOContext *ctx, const char *str)
         avio_w8(ctx, '"');
 }
 
+/* With writer threads, the segment being muxed only exists in memory.
+ * Muxers that re-open their output to move data around, e.g. mp4 with
+ * faststart, read a copy of what has been written so far instead. */
+static int seg_io_open(AVFormatContext *oc, AVIOContext **pb, const char *url,
+                       int flags, AVDictionary **options)
+{
+    AVFormatContext *s = oc->opaque;
+    SegmentContext *seg = s->priv_data;
+    uint8_t *data;
+    int size;
+
+    if (flags != AVIO_FLAG_READ || !oc->pb || seg->is_nullctx || seg->reader ||
+        strcmp(url, oc->url))
+        return s->io_open(s, pb, url, flags, options);
+
+    size = avio_get_dyn_buf(oc->pb, &data);
+    seg->reader      = av_mallocz(sizeof(*seg->reader));
+    seg->reader_data = av_memdup(data, size);
+    if (!seg->reader || !seg->reader_data) {
+        av_freep(&seg->reader);
+        av_freep(&seg->reader_data);
+        return AVERROR(ENOMEM);
+    }
+    ffio_init_read_context(seg->reader, seg->reader_data, size);
+    *pb = &seg->reader->pub;
+    return 0;
+}
+
+static int seg_io_close2(AVFormatContext *oc, AVIOContext *pb)
+{
+    AVFormatContext *s = oc->opaque;
+    SegmentContext *seg = s->priv_data;
+
+    if (seg->reader && pb == &seg->reader->pub) {
+        av_freep(&seg->reader);
+        av_freep(&seg->reader_data);
+        return 0;
+    }
+    return s->io_close2(s, pb);
+}
+
 static int segment_mux_init(AVFormatContext *s)
 {
     SegmentContext *seg = s->priv_data;
@@ -164,6 +214,11 @@ static int segment_mux_init(AVFormatContext *s)
     oc->io_close2          = s->io_close2;
     oc->io_open            = s->io_open;
     oc->flags              = s->flags;
+    if (seg->writer_pool) {
+        oc->opaque         = s;
+        oc->io_open        = seg_io_open;
+        oc->io_close2      = seg_io_close2;
+    }
 
     for (i = 0; i < s->nb_streams; i++) {
         AVStream *st, *ist = s->streams[i];
@@ -229,6 +284,22 @@ static int set_segment_filename(AVFormatContext *s)
     return 0;
 }
 
+static int segment_open_pb(AVFormatContext *s, AVIOContext **pb, const char *url)
+{
+    SegmentContext *seg = s->priv_data;
+    int ret;
+
+    if (!seg->writer_pool)
+        return s->io_open(s, pb, url, AVIO_FLAG_WRITE, NULL);
+
+    /* the segment is written to memory and handed to the writer pool
+     * once complete */
+    if ((ret = avio_open_dyn_buf(pb)) < 0)
+        return ret;
+    (*pb)->seekable = AVIO_SEEKABLE_NORMAL;
+    return 0;
+}
+
 static int segment_start(AVFormatContext *s, int write_header)
 {
     SegmentContext *seg = s->priv_data;
@@ -250,7 +321,7 @@ static int segment_start(AVFormatContext *s, int write_header)
     if ((err = set_segment_filename(s)) < 0)
         return err;
 
-    if ((err = s->io_open(s, &oc->pb, oc->url, AVIO_FLAG_WRITE, NULL)) < 0) {
+    if ((err = segment_open_pb(s, &oc->pb, oc->url)) < 0) {
         av_log(s, AV_LOG_ERROR, "Failed to open segment '%s'\n", oc->url);
         return err;
     }
@@ -344,6 +415,111 @@ static void segment_list_print_entry(AVIOContext      *list_ioctx,
     }
 }
 
+static int segment_list_update(AVFormatContext *s, const SegmentListEntry *list_entry,
+                               int is_last)
+{
+    SegmentContext *seg = s->priv_data;
+    int ret;
+
+    if (seg->list_size || seg->list_type == LIST_TYPE_M3U8) {
+        SegmentListEntry *entry = av_mallocz(sizeof(*entry));
+        if (!entry)
+            return AVERROR(ENOMEM);
+
+        /* append new element */
+        memcpy(entry, list_entry, sizeof(*entry));
+        entry->next     = NULL;
+        entry->filename = av_strdup(entry->filename);
+        if (!seg->segment_list_entries)
+            seg->segment_list_entries = seg->segment_list_entries_end = entry;
+        else
+            seg->segment_list_entries_end->next = entry;
+        seg->segment_list_entries_end = entry;
+
+        /* drop first item */
+        if (seg->list_size && seg->list_count >= seg->list_size) {
+            entry = seg->segment_list_entries;
+            seg->segment_list_entries = seg->segment_list_entries->next;
+            av_freep(&entry->filename);
+            av_freep(&entry);
+        }
+        seg->list_count++;
+
+        if ((ret = segment_list_open(s)) < 0)
+            return ret;
+        for (entry = seg->segment_list_entries; entry; entry = entry->next)
+            segment_list_print_entry(seg->list_pb, seg->list_type, entry, s);
+        if (seg->list_type == LIST_TYPE_M3U8 && is_last)
+            avio_printf(seg->list_pb, "#EXT-X-ENDLIST\n");
+        ff_format_io_close(s, &seg->list_pb);
+        if (seg->use_rename)
+            ff_rename(seg->temp_list_filename, seg->list, s);
+    } else {
+        segment_list_print_entry(seg->list_pb, seg->list_type, list_entry, s);
+        avio_flush(seg->list_pb);
+    }
+    return 0;
+}
+
+/* Called by the writer pool, in segment order, once a file is written. */
+static int segment_written(AVFormatContext *s, void *opaque, int ret)
+{
+    SegmentContext *seg = s->priv_data;
+    SegmentListEntry *entry = opaque;
+
+    if (entry) {
+        int is_last = entry == seg->last_entry;
+        if (is_last)
+            seg->last_entry = NULL;
+        /* as in synchronous mode, a segment is only listed once written */
+        if (ret >= 0)
+            ret = segment_list_update(s, entry, is_last);
+        av_freep(&entry->filename);
+        av_freep(&entry);
+    }
+    return ret;
+}
+
+/**
+ * Close a segment or header file. With writer threads, the file is
+ * queued for writing, and listed once it is written if entry is set.
+ */
+static int segment_close_pb(AVFormatContext *s, AVIOContext **pb, const char *url,
+                            const SegmentListEntry *entry, int is_last)
+{
+    SegmentContext *seg = s->priv_data;
+    SegmentListEntry *list_entry = NULL;
+    AVBufferRef *buf;
+    uint8_t *data;
+    int size;
+
+    if (!seg->writer_pool)
+        return ff_format_io_close(s, pb);
+
+    /* the buffer is padded at the current position, which is not the end
+     * if the muxer went back to write a header, e.g. mp4 with faststart */
+    avio_seek(*pb, avio_get_dyn_buf(*pb, &data), SEEK_SET);
+    size = avio_close_dyn_buf(*pb, &data);
+    *pb = NULL;
+    buf = av_buffer_create(data, size, NULL, NULL, 0);
+    if (!buf) {
+        av_free(data);
+        return AVERROR(ENOMEM);
+    }
+    if (entry) {
+        list_entry = av_memdup(entry, sizeof(*entry));
+        if (!list_entry || !(list_entry->filename = av_strdup(entry->filename))) {
+            av_free(list_entry);
+            av_buffer_unref(&buf);
+            return AVERROR(ENOMEM);
+        }
+        list_entry->next = NULL;
+        if (is_last)
+            seg->last_entry = list_entry;
+    }
+    return ff_writer_pool_submit(seg->writer_pool, url, NULL, NULL, &buf, list_entry);
+}
+
 static int segment_end(AVFormatContext *s, int write_trailer, int is_last)
 {
     SegmentContext *seg = s->priv_data;
@@ -367,44 +543,9 @@ static int segment_end(AVFormatContext *s, int write_trailer, int is_last)
         av_log(s, AV_LOG_ERROR, "Failure occurred when ending segment '%s'\n",
                oc->url);
 
-    if (seg->list) {
-        if (seg->list_size || seg->list_type == LIST_TYPE_M3U8) {
-            SegmentListEntry *entry = av_mallocz(sizeof(*entry));
-            if (!entry) {
-                ret = AVERROR(ENOMEM);
-                goto end;
-            }
-
-            /* append new element */
-            memcpy(entry, &seg->cur_entry, sizeof(*entry));
-            entry->filename = av_strdup(entry->filename);
-            if (!seg->segment_list_entries)
-                seg->segment_list_entries = seg->segment_list_entries_end = entry;
-            else
-                seg->segment_list_entries_end->next = entry;
-            seg->segment_list_entries_end = entry;
-
-            /* drop first item */
-            if (seg->list_size && seg->segment_count >= seg->list_size) {
-                entry = seg->segment_list_entries;
-                seg->segment_list_entries = seg->segment_list_entries->next;
-                av_freep(&entry->filename);
-                av_freep(&entry);
-            }
-
-            if ((ret = segment_list_open(s)) < 0)
-                goto end;
-            for (entry = seg->segment_list_entries; entry; entry = entry->next)
-                segment_list_print_entry(seg->list_pb, seg->list_type, entry, s);
-            if (seg->list_type == LIST_TYPE_M3U8 && is_last)
-                avio_printf(seg->list_pb, "#EXT-X-ENDLIST\n");
-            ff_format_io_close(s, &seg->list_pb);
-            if (seg->use_rename)
-                ff_rename(seg->temp_list_filename, seg->list, s);
-        } else {
-            segment_list_print_entry(seg->list_pb, seg->list_type, &seg->cur_entry, s);
-            avio_flush(seg->list_pb);
-        }
+    if (seg->list && !seg->writer_pool) {
+        if ((ret = segment_list_update(s, &seg->cur_entry, is_last)) < 0)
+            goto end;
     }
 
     av_log(s, AV_LOG_VERBOSE, "segment:'%s' count:%d ended\n",
@@ -451,7 +592,10 @@ static int segment_end(AVFormatContext *s, int write_trailer, int is_last)
     }
 
 end:
-    ff_format_io_close(oc, &oc->pb);
+    err = segment_close_pb(s, &oc->pb, oc->url,
+                           seg->list ? &seg->cur_entry : NULL, is_last);
+    if (ret >= 0 && seg->writer_pool)
+        ret = err;
 
     return ret;
 }
@@ -647,10 +791,15 @@ static void seg_free(AVFormatContext *s)
     SegmentContext *seg = s->priv_data;
     SegmentListEntry *cur;
 
+    ff_writer_pool_free(&seg->writer_pool);
     ff_format_io_close(s, &seg->list_pb);
+    av_freep(&seg->reader);
+    av_freep(&seg->reader_data);
     if (seg->avf) {
         if (seg->is_nullctx)
             close_null_ctxp(&seg->avf->pb);
+        else if (seg->writer_threads)
+            ffio_free_dyn_buf(&seg->avf->pb);
         else
             ff_format_io_close(s, &seg->avf->pb);
         avformat_free_context(seg->avf);
@@ -759,6 +908,13 @@ static int seg_init(AVFormatContext *s)
         return AVERROR(EINVAL);
     }
 
+    if (seg->writer_threads) {
+        ret = ff_writer_pool_alloc(&seg->writer_pool, s, seg->writer_threads,
+                                   2 * seg->writer_threads, 0, segment_written);
+        if (ret < 0)
+            return ret;
+    }
+
     if ((ret = segment_mux_init(s)) < 0)
         return ret;
 
@@ -767,9 +923,8 @@ static int seg_init(AVFormatContext *s)
     oc = seg->avf;
 
     if (seg->write_header_trailer) {
-        if ((ret = s->io_open(s, &oc->pb,
-                              seg->header_filename ? seg->header_filename : oc->url,
-                              AVIO_FLAG_WRITE, NULL)) < 0) {
+        if ((ret = segment_open_pb(s, &oc->pb,
+                                   seg->header_filename ? seg->header_filename : oc->url)) < 0) {
             av_log(s, AV_LOG_ERROR, "Failed to open segment '%s'\n", oc->url);
             return ret;
         }
@@ -832,12 +987,14 @@ static int seg_write_header(AVFormatContext *s)
     if (!seg->write_header_trailer || seg->header_filename) {
         if (seg->header_filename) {
             av_write_frame(oc, NULL);
-            ff_format_io_close(oc, &oc->pb);
+            if ((ret = segment_close_pb(s, &oc->pb, seg->header_filename, NULL, 0)) < 0 &&
+                seg->writer_pool)
+                return ret;
         } else {
             close_null_ctxp(&oc->pb);
             seg->is_nullctx = 0;
         }
-        if ((ret = oc->io_open(oc, &oc->pb, oc->url, AVIO_FLAG_WRITE, NULL)) < 0)
+        if ((ret = segment_open_pb(s, &oc->pb, oc->url)) < 0)
             return ret;
         if (!seg->individual_header_trailer)
             oc->pb->seekable = 0;
@@ -1009,6 +1166,11 @@ static int seg_write_trailer(struct AVFormatContext *s)
     } else {
         ret = segment_end(s, 1, 1);
     }
+    if (seg->writer_pool) {
+        int err = ff_writer_pool_flush(seg->writer_pool, 1);
+        if (ret >= 0)
+            ret = err;
+    }
     return ret;
 }
 
@@ -1075,6 +1237,7 @@ static const AVOption options[] = {
     { "reset_timestamps", "reset timestamps at the beginning of each segment", OFFSET(reset_timestamps), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, E },
     { "initial_offset", "set initial timestamp offset", OFFSET(initial_offset), AV_OPT_TYPE_DURATION, {.i64 = 0}, -INT64_MAX, INT64_MAX, E },
     { "write_empty_segments", "allow writing empty 'filler' segments", OFFSET(write_empty), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, E },
+    { "writer_threads", "write segment files in background threads", OFFSET(writer_threads), AV_OPT_TYPE_INT, {.i64 = 0}, 0, 64, E },
     { NULL },
 };
 
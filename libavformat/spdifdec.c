@@ -249,11 +249,17 @@ int ff_spdif_read_packet(AVFormatContext *s, AVPacket *pkt)
     return 0;
 }
 
+/* byte-swapped Pa sync word */
+static const FFProbePairRange spdif_probe_pairs[] = {
+    { 0x72F8, 0x72F8 }, { 0 }
+};
+
 const FFInputFormat ff_spdif_demuxer = {
     .p.name         = "spdif",
     .p.long_name    = NULL_IF_CONFIG_SMALL("IEC 61937 (compressed data in S/PDIF)"),
     .p.flags        = AVFMT_GENERIC_INDEX,
     .read_probe     = spdif_probe,
+    .probe_pairs    = spdif_probe_pairs,
     .read_header    = spdif_read_header,
     .read_packet    = ff_spdif_read_packet,
 };
@@ -0,0 +1,115 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/error.h"
+#include "libavutil/macros.h"
+#include "libavutil/mem.h"
+#include "libavcodec/defs.h"
+#include "libavformat/avio.h"
+
+#define DATA_SIZE   100000
+#define BUFFER_SIZE 4096
+
+static uint8_t data[DATA_SIZE];
+
+typedef struct Reader {
+    int pos;
+} Reader;
+
+static int read_packet(void *opaque, uint8_t *buf, int size)
+{
+    Reader *r = opaque;
+    int len = FFMIN(size, DATA_SIZE - r->pos);
+
+    if (!len)
+        return AVERROR_EOF;
+    memcpy(buf, data + r->pos, len);
+    r->pos += len;
+    return len;
+}
+
+static int check_read(AVIOContext *pb, int64_t pos, int size)
+{
+    AVBufferRef *buf;
+    int ret = avio_read_to_buffer(pb, &buf, size);
+
+    printf("read %6d: ", size);
+    if (ret < 0) {
+        printf("%s, buffer %s\n", av_err2str(ret), buf ? "set" : "NULL");
+        return buf != NULL;
+    }
+    printf("got %6d, buffer size %6d", ret, (int)buf->size);
+    if (buf->size != ret + AV_INPUT_BUFFER_PADDING_SIZE) {
+        printf(", wrong size\n");
+        goto fail;
+    }
+    if (memcmp(buf->data, data + pos, ret)) {
+        printf(", data mismatch\n");
+        goto fail;
+    }
+    for (int i = 0; i < AV_INPUT_BUFFER_PADDING_SIZE; i++) {
+        if (buf->data[ret + i]) {
+            printf(", padding not zeroed\n");
+            goto fail;
+        }
+    }
+    printf("\n");
+    av_buffer_unref(&buf);
+    return 0;
+fail:
+    av_buffer_unref(&buf);
+    return 1;
+}
+
+int main(void)
+{
+    static const int sizes[] = { 1000, 0, 10000, 3000, 50000, 40000 };
+    Reader reader = { 0 };
+    AVIOContext *pb;
+    uint8_t *buffer;
+    int64_t pos = 0;
+    int ret = 0;
+
+    for (int i = 0; i < DATA_SIZE; i++)
+        data[i] = i * 7 + (i >> 8);
+
+    buffer = av_malloc(BUFFER_SIZE);
+    if (!buffer)
+        return 1;
+    pb = avio_alloc_context(buffer, BUFFER_SIZE, 0, &reader, read_packet,
+                            NULL, NULL);
+    if (!pb) {
+        av_free(buffer);
+        return 1;
+    }
+
+    /* buffered and direct reads, the last one is short */
+    for (int i = 0; i < FF_ARRAY_ELEMS(sizes); i++) {
+        ret |= check_read(pb, pos, sizes[i]);
+        pos = avio_tell(pb);
+    }
+    /* at EOF */
+    ret |= check_read(pb, pos, 100);
+
+    av_freep(&pb->buffer);
+    avio_context_free(&pb);
+    return ret;
+}
@@ -0,0 +1,524 @@
+/*
+ * Background writing of whole output files
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+
+#include "libavutil/avassert.h"
+#include "libavutil/avstring.h"
+#include "libavutil/mem.h"
+#include "libavutil/thread.h"
+#include "libavutil/time.h"
+
+#include "avio.h"
+#include "avio_internal.h"
+#include "internal.h"
+#include "url.h"
+#include "writer_pool.h"
+
+typedef struct WriterJob {
+    char *url;
+    char *rename_to;
+    AVDictionary *options;
+    /* data to write; without it, url is renamed if rename_to is set,
+     * deleted otherwise */
+    AVBufferRef *buf;
+    void *opaque;
+    int done;
+    int ret;
+    int64_t write_time;
+} WriterJob;
+
+/* a dynamic buffer opened with ff_writer_pool_open() */
+typedef struct WriterFile {
+    AVIOContext *pb;
+    char *url;
+    AVDictionary *options;
+    struct WriterFile *next;
+} WriterFile;
+
+struct FFWriterPool {
+    AVFormatContext *s;
+    FFWriterPoolDone done;
+    int flags;
+
+    /* ring of max_pending jobs, indexed by the job counters below */
+    WriterJob *jobs;
+    int max_pending;
+    unsigned nb_submitted;
+    unsigned nb_started;
+    unsigned nb_collected;
+
+    WriterFile *files;
+
+    /* statistics, logged when freeing the pool */
+    unsigned nb_written;
+    unsigned nb_full;
+    int64_t total_write_time;
+    int64_t max_write_time;
+
+#if HAVE_THREADS
+    pthread_t *threads;
+    int nb_threads;
+    int abort;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond_worker;
+    pthread_cond_t cond_main;
+#endif
+};
+
+static WriterJob *get_job(FFWriterPool *pool, unsigned n)
+{
+    return &pool->jobs[n % pool->max_pending];
+}
+
+static int write_file(FFWriterPool *pool, WriterJob *job)
+{
+    AVFormatContext *s = pool->s;
+    AVIOContext *pb = NULL;
+    int ret, err;
+
+    ret = s->io_open(s, &pb, job->url, AVIO_FLAG_WRITE, &job->options);
+    if (ret < 0) {
+        av_log(s, AV_LOG_ERROR, "Could not open file : %s\n", job->url);
+        return ret;
+    }
+    if (job->options && !(pool->flags & FF_WRITER_POOL_FLAG_IGNORE_OPTIONS)) {
+        av_log(s, AV_LOG_ERROR, "Could not recognize some protocol options\n");
+        ff_format_io_close(s, &pb);
+        return AVERROR(EINVAL);
+    }
+
+    avio_write(pb, job->buf->data, job->buf->size);
+    avio_flush(pb);
+    err = pb->error;
+    ret = ff_format_io_close(s, &pb);
+    if (err < 0)
+        ret = err;
+    if (ret < 0) {
+        av_log(s, AV_LOG_ERROR, "Error writing file %s: %s\n", job->url, av_err2str(ret));
+        return ret;
+    }
+    if (job->rename_to)
+        ret = ff_rename(job->url, job->rename_to, s);
+    return ret;
+}
+
+static int run_job(FFWriterPool *pool, WriterJob *job)
+{
+    int64_t start;
+    int ret;
+
+    if (job->rename_to && !job->buf)
+        return ff_rename(job->url, job->rename_to, pool->s);
+    if (!job->buf) {
+        ret = ffurl_delete(job->url);
+        if (ret < 0)
+            av_log(pool->s, ret == AVERROR(ENOENT) ? AV_LOG_WARNING : AV_LOG_ERROR,
+                   "failed to delete %s: %s\n", job->url, av_err2str(ret));
+        return 0;
+    }
+
+    start = av_gettime_relative();
+    ret = write_file(pool, job);
+    job->write_time = av_gettime_relative() - start;
+    return ret;
+}
+
+static void free_job(WriterJob *job)
+{
+    av_freep(&job->url);
+    av_freep(&job->rename_to);
+    av_dict_free(&job->options);
+    av_buffer_unref(&job->buf);
+}
+
+#if HAVE_THREADS
+static int same_file(const char *a, const char *b)
+{
+    return a && b && !strcmp(a, b);
+}
+
+/* Whether an older job still being processed touches the same file. */
+static int job_conflicts(FFWriterPool *pool, const WriterJob *job)
+{
+    for (unsigned n = pool->nb_collected; n != pool->nb_started; n++) {
+        const WriterJob *old = get_job(pool, n);
+        if (old->done)
+            continue;
+        if (same_file(old->url,       job->url) || same_file(old->url,       job->rename_to) ||
+            same_file(old->rename_to, job->url) || same_file(old->rename_to, job->rename_to))
+            return 1;
+    }
+    return 0;
+}
+
+static void *writer_thread(void *arg)
+{
+    FFWriterPool *pool = arg;
+
+    ff_thread_setname("writer-pool");
+
+    pthread_mutex_lock(&pool->mutex);
+    while (1) {
+        WriterJob *job;
+        int ret;
+
+        if (pool->nb_started == pool->nb_submitted ||
+            job_conflicts(pool, get_job(pool, pool->nb_started))) {
+            if (pool->abort)
+                break;
+            pthread_cond_wait(&pool->cond_worker, &pool->mutex);
+            continue;
+        }
+        job = get_job(pool, pool->nb_started++);
+        pthread_mutex_unlock(&pool->mutex);
+
+        ret = run_job(pool, job);
+
+        pthread_mutex_lock(&pool->mutex);
+        job->ret  = ret;
+        job->done = 1;
+        pthread_cond_signal(&pool->cond_main);
+        /* a job waiting for this file can start now */
+        pthread_cond_broadcast(&pool->cond_worker);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    return NULL;
+}
+#endif
+
+/**
+ * Run the done callback of the oldest job, waiting for it if wait is set.
+ * @return 1 if there was no job to collect, 0 or a negative error code
+ *         returned by the callback otherwise
+ */
+static int collect_job(FFWriterPool *pool, int wait)
+{
+    WriterJob *job;
+    int ret, done;
+
+    if (pool->nb_collected == pool->nb_submitted)
+        return 1;
+    job = get_job(pool, pool->nb_collected);
+
+#if HAVE_THREADS
+    if (pool->nb_threads) {
+        pthread_mutex_lock(&pool->mutex);
+        while (wait && !job->done)
+            pthread_cond_wait(&pool->cond_main, &pool->mutex);
+        done = job->done;
+        pthread_mutex_unlock(&pool->mutex);
+    } else
+#endif
+    done = job->done;
+    if (!done)
+        return 1;
+
+    if (job->buf) {
+        av_log(pool->s, AV_LOG_DEBUG, "File %s written in %.3f ms\n",
+               job->url, job->write_time / 1000.0);
+        pool->nb_written++;
+        pool->total_write_time += job->write_time;
+        pool->max_write_time    = FFMAX(pool->max_write_time, job->write_time);
+    }
+
+    ret = job->ret;
+    if (pool->done)
+        ret = pool->done(pool->s, job->opaque, ret);
+    free_job(job);
+
+#if HAVE_THREADS
+    if (pool->nb_threads) {
+        pthread_mutex_lock(&pool->mutex);
+        pool->nb_collected++;
+        pthread_mutex_unlock(&pool->mutex);
+    } else
+#endif
+    pool->nb_collected++;
+    return FFMIN(ret, 0);
+}
+
+int ff_writer_pool_flush(FFWriterPool *pool, int wait)
+{
+    int ret, err = 0;
+
+    while ((ret = collect_job(pool, wait)) <= 0)
+        if (!err)
+            err = ret;
+    return err;
+}
+
+static int queue_job(FFWriterPool *pool, const char *url, const char *rename_to,
+                     const AVDictionary *options, AVBufferRef *buf, void *opaque)
+{
+    WriterJob *job;
+    int ret, err;
+
+    err = ff_writer_pool_flush(pool, 0);
+    if (pool->nb_submitted - pool->nb_collected == pool->max_pending)
+        pool->nb_full++;
+    while (pool->nb_submitted - pool->nb_collected == pool->max_pending) {
+        ret = collect_job(pool, 1);
+        if (!err)
+            err = ret;
+    }
+
+    job = get_job(pool, pool->nb_submitted);
+    memset(job, 0, sizeof(*job));
+    job->url       = av_strdup(url);
+    job->rename_to = rename_to ? av_strdup(rename_to) : NULL;
+    job->buf       = buf;
+    job->opaque    = opaque;
+    if (!job->url || (rename_to && !job->rename_to) ||
+        av_dict_copy(&job->options, options, 0) < 0) {
+        free_job(job);
+        ret = AVERROR(ENOMEM);
+        if (pool->done)
+            pool->done(pool->s, opaque, ret);
+        return ret;
+    }
+
+#if HAVE_THREADS
+    if (pool->nb_threads) {
+        pthread_mutex_lock(&pool->mutex);
+        pool->nb_submitted++;
+        pthread_cond_signal(&pool->cond_worker);
+        pthread_mutex_unlock(&pool->mutex);
+        return err;
+    }
+#endif
+    job->ret  = run_job(pool, job);
+    job->done = 1;
+    pool->nb_started = ++pool->nb_submitted;
+    return err;
+}
+
+int ff_writer_pool_submit(FFWriterPool *pool, const char *url, const char *rename_to,
+                          const AVDictionary *options, AVBufferRef **buf, void *opaque)
+{
+    AVBufferRef *ref = *buf;
+
+    *buf = NULL;
+    return queue_job(pool, url, rename_to, options, ref, opaque);
+}
+
+int ff_writer_pool_rename(FFWriterPool *pool, const char *url, const char *rename_to)
+{
+    return queue_job(pool, url, rename_to, NULL, NULL, NULL);
+}
+
+int ff_writer_pool_delete(FFWriterPool *pool, const char *url)
+{
+    return queue_job(pool, url, NULL, NULL, NULL, NULL);
+}
+
+static void free_file(WriterFile **pfile)
+{
+    WriterFile *file = *pfile;
+
+    ffio_free_dyn_buf(&file->pb);
+    av_freep(&file->url);
+    av_dict_free(&file->options);
+    av_freep(pfile);
+}
+
+static WriterFile **find_file(FFWriterPool *pool, const AVIOContext *pb)
+{
+    WriterFile **pfile = &pool->files;
+
+    while (*pfile && (*pfile)->pb != pb)
+        pfile = &(*pfile)->next;
+    return pfile;
+}
+
+int ff_writer_pool_open(FFWriterPool *pool, AVIOContext **pb, const char *url,
+                        const AVDictionary *options)
+{
+    WriterFile *file = av_mallocz(sizeof(*file));
+    int ret;
+
+    if (!file)
+        return AVERROR(ENOMEM);
+    file->url = av_strdup(url);
+    if (!file->url || av_dict_copy(&file->options, options, 0) < 0) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    if ((ret = avio_open_dyn_buf(&file->pb)) < 0)
+        goto fail;
+
+    file->next  = pool->files;
+    pool->files = file;
+    *pb = file->pb;
+    return 0;
+fail:
+    free_file(&file);
+    return ret;
+}
+
+int ff_writer_pool_close(FFWriterPool *pool, AVIOContext **pb,
+                         const char *rename_to, void *opaque)
+{
+    WriterFile **pfile = find_file(pool, *pb);
+    WriterFile *file = *pfile;
+    AVBufferRef *buf;
+    uint8_t *data;
+    int size, ret;
+
+    av_assert1(file);
+    *pfile = file->next;
+    *pb = NULL;
+
+    size = avio_close_dyn_buf(file->pb, &data);
+    file->pb = NULL;
+    buf = av_buffer_create(data, size, NULL, NULL, 0);
+    if (!buf) {
+        av_free(data);
+        free_file(&file);
+        if (pool->done)
+            pool->done(pool->s, opaque, AVERROR(ENOMEM));
+        return AVERROR(ENOMEM);
+    }
+    ret = queue_job(pool, file->url, rename_to, file->options, buf, opaque);
+    free_file(&file);
+    return ret;
+}
+
+void ff_writer_pool_discard(FFWriterPool *pool, AVIOContext **pb)
+{
+    WriterFile **pfile = find_file(pool, *pb);
+    WriterFile *file = *pfile;
+
+    if (!file)
+        return;
+    *pfile = file->next;
+    *pb = NULL;
+    free_file(&file);
+}
+
+void ff_writer_pool_free(FFWriterPool **ppool)
+{
+    FFWriterPool *pool = *ppool;
+
+    if (!pool)
+        return;
+
+    ff_writer_pool_flush(pool, 1);
+
+#if HAVE_THREADS
+    if (pool->nb_threads) {
+        pthread_mutex_lock(&pool->mutex);
+        pool->abort = 1;
+        pthread_cond_broadcast(&pool->cond_worker);
+        pthread_mutex_unlock(&pool->mutex);
+        for (int i = 0; i < pool->nb_threads; i++)
+            pthread_join(pool->threads[i], NULL);
+        pthread_cond_destroy(&pool->cond_main);
+        pthread_cond_destroy(&pool->cond_worker);
+        pthread_mutex_destroy(&pool->mutex);
+    }
+    av_freep(&pool->threads);
+#endif
+
+    if (pool->nb_written)
+        av_log(pool->s, AV_LOG_VERBOSE, "%u files written in %.3f ms on average, "
+               "%.3f ms at most, queue full %u times\n", pool->nb_written,
+               pool->total_write_time / 1000.0 / pool->nb_written,
+               pool->max_write_time / 1000.0, pool->nb_full);
+
+    while (pool->files) {
+        WriterFile *file = pool->files;
+        pool->files = file->next;
+        free_file(&file);
+    }
+    av_freep(&pool->jobs);
+    av_freep(ppool);
+}
+
+int ff_writer_pool_alloc(FFWriterPool **ppool, AVFormatContext *s, int nb_threads,
+                         int max_pending, int flags, FFWriterPoolDone done)
+{
+    FFWriterPool *pool;
+    int ret = 0;
+
+    pool = av_mallocz(sizeof(*pool));
+    if (!pool)
+        return AVERROR(ENOMEM);
+    pool->s           = s;
+    pool->done        = done;
+    pool->flags       = flags;
+    pool->max_pending = FFMAX(max_pending, 1);
+    pool->jobs        = av_calloc(pool->max_pending, sizeof(*pool->jobs));
+    if (!pool->jobs) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+
+#if HAVE_THREADS
+    pool->threads = av_calloc(nb_threads, sizeof(*pool->threads));
+    if (nb_threads && !pool->threads) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    if (nb_threads) {
+        if ((ret = pthread_mutex_init(&pool->mutex, NULL))) {
+            ret = AVERROR(ret);
+            goto fail;
+        }
+        if ((ret = pthread_cond_init(&pool->cond_worker, NULL))) {
+            pthread_mutex_destroy(&pool->mutex);
+            ret = AVERROR(ret);
+            goto fail;
+        }
+        if ((ret = pthread_cond_init(&pool->cond_main, NULL))) {
+            pthread_cond_destroy(&pool->cond_worker);
+            pthread_mutex_destroy(&pool->mutex);
+            ret = AVERROR(ret);
+            goto fail;
+        }
+    }
+    for (; pool->nb_threads < nb_threads; pool->nb_threads++) {
+        ret = pthread_create(&pool->threads[pool->nb_threads], NULL, writer_thread, pool);
+        if (ret) {
+            ret = AVERROR(ret);
+            if (!pool->nb_threads) {
+                pthread_cond_destroy(&pool->cond_main);
+                pthread_cond_destroy(&pool->cond_worker);
+                pthread_mutex_destroy(&pool->mutex);
+                goto fail;
+            }
+            av_log(s, AV_LOG_ERROR, "Could not create writer thread: %s\n", av_err2str(ret));
+            ff_writer_pool_free(&pool);
+            return ret;
+        }
+    }
+#endif
+
+    *ppool = pool;
+    return 0;
+fail:
+#if HAVE_THREADS
+    av_freep(&pool->threads);
+#endif
+    av_freep(&pool->jobs);
+    av_freep(&pool);
+    return ret;
+}
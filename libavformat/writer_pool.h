@@ -0,0 +1,141 @@
+/*
+ * Background writing of whole output files
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFORMAT_WRITER_POOL_H
+#define AVFORMAT_WRITER_POOL_H
+
+#include "libavutil/buffer.h"
+#include "libavutil/dict.h"
+
+#include "avformat.h"
+
+/**
+ * A bounded pool of threads opening, writing, closing and optionally
+ * renaming output files, so that a muxer does not block on the latency
+ * of the storage. Files are opened with AVFormatContext.io_open() and
+ * closed with AVFormatContext.io_close2() from the pool threads.
+ *
+ * Completion callbacks run on the calling thread, in submission order,
+ * from the functions queuing files, ff_writer_pool_flush() and
+ * ff_writer_pool_free(). Operations on the same file name are done one
+ * after the other in submission order; with a single thread, all of them
+ * are.
+ *
+ * Without thread support, files are written synchronously on submission.
+ */
+typedef struct FFWriterPool FFWriterPool;
+
+/**
+ * Do not fail writing a file when some of its protocol options are not
+ * recognized.
+ */
+#define FF_WRITER_POOL_FLAG_IGNORE_OPTIONS 1
+
+/**
+ * Called when a file has been written.
+ *
+ * @param ret    0 on success, a negative error code if the file could
+ *               not be written
+ * @return a negative error code to be returned to the caller of the
+ *         function that invoked the callback, 0 otherwise
+ */
+typedef int (*FFWriterPoolDone)(AVFormatContext *s, void *opaque, int ret);
+
+/**
+ * @param nb_threads  number of files written concurrently
+ * @param max_pending maximum number of files that are written or waiting
+ *                    to be, bounding the memory held by the pool
+ * @param flags       a combination of FF_WRITER_POOL_FLAG_*
+ * @param done        callback called when a file has been written, may be
+ *                    NULL
+ */
+int ff_writer_pool_alloc(FFWriterPool **pool, AVFormatContext *s, int nb_threads,
+                         int max_pending, int flags, FFWriterPoolDone done);
+
+/**
+ * Queue writing a file, waiting for the oldest file to be written first
+ * if max_pending files are pending.
+ *
+ * @param url       name of the file to write
+ * @param rename_to if not NULL, url is renamed to it after being closed
+ * @param options   protocol options for io_open(), may be NULL; an error is
+ *                  reported if some are not recognized, unless
+ *                  FF_WRITER_POOL_FLAG_IGNORE_OPTIONS is set
+ * @param buf       data to write; the pool takes ownership of the reference
+ *                  and sets *buf to NULL
+ * @param opaque    passed to the done callback, which is called exactly once
+ *                  for each submission, also if it fails
+ * @return 0 on success, a negative error code if the file could not be
+ *         queued or the error returned by a done callback; without done
+ *         callback, the error of a previously submitted file
+ */
+int ff_writer_pool_submit(FFWriterPool *pool, const char *url, const char *rename_to,
+                          const AVDictionary *options, AVBufferRef **buf, void *opaque);
+
+/**
+ * Open a dynamic buffer, queued for writing to url by
+ * ff_writer_pool_close().
+ *
+ * @param options protocol options for io_open(), copied, may be NULL
+ */
+int ff_writer_pool_open(FFWriterPool *pool, AVIOContext **pb, const char *url,
+                        const AVDictionary *options);
+
+/**
+ * Queue writing the content of a buffer opened with ff_writer_pool_open()
+ * to its file, and free *pb.
+ *
+ * @return as ff_writer_pool_submit()
+ */
+int ff_writer_pool_close(FFWriterPool *pool, AVIOContext **pb,
+                         const char *rename_to, void *opaque);
+
+/**
+ * Free a buffer opened with ff_writer_pool_open() without writing it.
+ */
+void ff_writer_pool_discard(FFWriterPool *pool, AVIOContext **pb);
+
+/**
+ * Queue renaming a file, after the operations queued before on it.
+ * A failure is only logged.
+ */
+int ff_writer_pool_rename(FFWriterPool *pool, const char *url, const char *rename_to);
+
+/**
+ * Queue deleting a file, after the operations queued before on it.
+ * A failure is only logged.
+ */
+int ff_writer_pool_delete(FFWriterPool *pool, const char *url);
+
+/**
+ * Run the done callback of the files written so far.
+ *
+ * @param wait if set, wait for all the pending files to be written first
+ * @return 0 or the first error, as in ff_writer_pool_submit()
+ */
+int ff_writer_pool_flush(FFWriterPool *pool, int wait);
+
+/**
+ * Wait for all the pending files to be written, run their done callbacks
+ * and free the pool. The time taken to write the files is logged.
+ */
+void ff_writer_pool_free(FFWriterPool **pool);
+
+#endif /* AVFORMAT_WRITER_POOL_H */
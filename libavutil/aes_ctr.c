@@ -24,17 +24,20 @@
 #include "aes_ctr.h"
 #include "aes.h"
 #include "aes_internal.h"
+#include "intreadwrite.h"
 #include "macros.h"
 #include "mem.h"
 #include "random_seed.h"
 
 #define AES_BLOCK_SIZE (16)
+#define AES_CTR_BATCH  (16)
 
 typedef struct AVAESCTR {
     uint8_t counter[AES_BLOCK_SIZE];
     uint8_t encrypted_counter[AES_BLOCK_SIZE];
     int block_offset;
     AVAES aes;
+    uint8_t keystream[AES_CTR_BATCH * AES_BLOCK_SIZE];
 } AVAESCTR;
 
 struct AVAESCTR *av_aes_ctr_alloc(void)
@@ -111,6 +114,24 @@ void av_aes_ctr_crypt(struct AVAESCTR *a, uint8_t *dst, const uint8_t *src, int
     uint8_t* encrypted_counter_pos;
 
     while (src < src_end) {
+        if (a->block_offset == 0 && src_end - src >= AES_BLOCK_SIZE) {
+            /* Encrypt a batch of counters in a single call, so that
+             * multi-block implementations can interleave them. */
+            int i, blocks = FFMIN((src_end - src) / AES_BLOCK_SIZE, AES_CTR_BATCH);
+
+            for (i = 0; i < blocks; i++) {
+                memcpy(a->keystream + i * AES_BLOCK_SIZE, a->counter, AES_BLOCK_SIZE);
+                av_aes_ctr_increment_be64(a->counter + 8);
+            }
+            av_aes_crypt(&a->aes, a->keystream, a->keystream, blocks, NULL, 0);
+
+            for (i = 0; i < blocks * AES_BLOCK_SIZE; i += 8)
+                AV_WN64(dst + i, AV_RN64(src + i) ^ AV_RN64(a->keystream + i));
+            src += blocks * AES_BLOCK_SIZE;
+            dst += blocks * AES_BLOCK_SIZE;
+            continue;
+        }
+
         if (a->block_offset == 0) {
             av_aes_crypt(&a->aes, a->encrypted_counter, a->counter, 1, NULL, 0);
 
@@ -299,8 +299,52 @@ AVBufferPool *av_buffer_pool_init(size_t size, AVBufferRef* (*alloc)(size_t size
     return pool;
 }
 
+static BufferPoolEntry *pool_cache_get(AVBufferPool *pool)
+{
+    for (int i = 0; i < BUFFER_POOL_CACHE_SIZE; i++) {
+        if (atomic_load_explicit(&pool->cache[i], memory_order_relaxed)) {
+            uintptr_t buf = atomic_exchange_explicit(&pool->cache[i], 0,
+                                                     memory_order_acquire);
+            if (buf)
+                return (BufferPoolEntry *)buf;
+        }
+    }
+    return NULL;
+}
+
+static int pool_cache_put(AVBufferPool *pool, BufferPoolEntry *buf)
+{
+    for (int i = 0; i < BUFFER_POOL_CACHE_SIZE; i++) {
+        uintptr_t empty = 0;
+        if (atomic_compare_exchange_strong_explicit(&pool->cache[i], &empty,
+                                                    (uintptr_t)buf,
+                                                    memory_order_release,
+                                                    memory_order_relaxed))
+            return 1;
+    }
+    return 0;
+}
+
+static void pool_put(AVBufferPool *pool, BufferPoolEntry *buf)
+{
+    if (pool_cache_put(pool, buf))
+        return;
+
+    ff_mutex_lock(&pool->mutex);
+    buf->next = pool->pool;
+    pool->pool = buf;
+    ff_mutex_unlock(&pool->mutex);
+}
+
 static void buffer_pool_flush(AVBufferPool *pool)
 {
+    BufferPoolEntry *buf;
+
+    while ((buf = pool_cache_get(pool))) {
+        buf->free(buf->opaque, buf->data);
+        av_freep(&buf);
+    }
+
     while (pool->pool) {
         BufferPoolEntry *buf = pool->pool;
         pool->pool = buf->next;
@@ -347,10 +391,7 @@ static void pool_release_buffer(void *opaque, uint8_t *data)
     BufferPoolEntry *buf = opaque;
     AVBufferPool *pool = buf->pool;
 
-    ff_mutex_lock(&pool->mutex);
-    buf->next = pool->pool;
-    pool->pool = buf;
-    ff_mutex_unlock(&pool->mutex);
+    pool_put(pool, buf);
 
     if (atomic_fetch_sub_explicit(&pool->refcount, 1, memory_order_acq_rel) == 1)
         buffer_pool_free(pool);
@@ -389,24 +430,31 @@ static AVBufferRef *pool_alloc_buffer(AVBufferPool *pool)
 
 AVBufferRef *av_buffer_pool_get(AVBufferPool *pool)
 {
-    AVBufferRef *ret;
-    BufferPoolEntry *buf;
+    AVBufferRef *ret = NULL;
+    BufferPoolEntry *buf = pool_cache_get(pool);
+
+    if (!buf) {
+        ff_mutex_lock(&pool->mutex);
+        buf = pool->pool;
+        if (buf) {
+            pool->pool = buf->next;
+            buf->next = NULL;
+        } else {
+            ret = pool_alloc_buffer(pool);
+        }
+        ff_mutex_unlock(&pool->mutex);
+    }
 
-    ff_mutex_lock(&pool->mutex);
-    buf = pool->pool;
     if (buf) {
         memset(&buf->buffer, 0, sizeof(buf->buffer));
         ret = buffer_create(&buf->buffer, buf->data, pool->size,
                             pool_release_buffer, buf, 0);
         if (ret) {
-            pool->pool = buf->next;
-            buf->next = NULL;
             buf->buffer.flags_internal |= BUFFER_FLAG_NO_FREE;
+        } else {
+            pool_put(pool, buf);
         }
-    } else {
-        ret = pool_alloc_buffer(pool);
     }
-    ff_mutex_unlock(&pool->mutex);
 
     if (ret)
         atomic_fetch_add_explicit(&pool->refcount, 1, memory_order_relaxed);
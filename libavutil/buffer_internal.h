@@ -85,10 +85,20 @@ typedef struct BufferPoolEntry {
     AVBuffer buffer;
 } BufferPoolEntry;
 
+/**
+ * Number of entries cached in front of the locked free list. Releasing a
+ * buffer stores it in a free slot and getting one takes it out of a slot,
+ * without taking the pool mutex.
+ */
+#define BUFFER_POOL_CACHE_SIZE 16
+
 struct AVBufferPool {
     AVMutex mutex;
     BufferPoolEntry *pool;
 
+    /* BufferPoolEntry pointers, 0 for an empty slot */
+    atomic_uintptr_t cache[BUFFER_POOL_CACHE_SIZE];
+
     /*
      * This is used to track when the pool is to be freed.
      * The pointer to the pool itself held by the caller is considered to
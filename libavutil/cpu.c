@@ -51,6 +51,7 @@
 
 static atomic_int cpu_flags = -1;
 static atomic_int cpu_count = -1;
+static atomic_int shared_threads = -1;
 
 static int get_cpu_flags(void)
 {
@@ -265,6 +266,16 @@ void av_cpu_force_count(int count)
     atomic_store_explicit(&cpu_count, count, memory_order_relaxed);
 }
 
+void av_cpu_set_shared_threads(int count)
+{
+    atomic_store_explicit(&shared_threads, count, memory_order_relaxed);
+}
+
+int ff_cpu_shared_threads(void)
+{
+    return atomic_load_explicit(&shared_threads, memory_order_relaxed);
+}
+
 size_t av_cpu_max_align(void)
 {
 #if ARCH_MIPS
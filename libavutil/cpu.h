@@ -131,6 +131,21 @@ int av_cpu_count(void);
  */
 void av_cpu_force_count(int count);
 
+/**
+ * Make the slice threads of the codecs, filter graphs and scalers created
+ * afterwards run on a single pool of worker threads shared by the whole
+ * process, instead of each of them starting its own threads. The number of
+ * slices each context uses is not affected.
+ *
+ * Contexts keep the pool they were created with, and the pool is stopped
+ * once all of them have been freed.
+ *
+ * @param count number of threads in the shared pool, 0 for the number of
+ *              logical cores; count < 0 disables sharing, which is the
+ *              default
+ */
+void av_cpu_set_shared_threads(int count);
+
 /**
  * Get the maximum data alignment that may be required by FFmpeg.
  *
@@ -59,4 +59,10 @@ size_t ff_get_cpu_max_align_ppc(void);
 size_t ff_get_cpu_max_align_x86(void);
 size_t ff_get_cpu_max_align_loongarch(void);
 
+/**
+ * @return the number of threads set with av_cpu_set_shared_threads(),
+ *         negative if threads are not shared
+ */
+int ff_cpu_shared_threads(void);
+
 #endif /* AVUTIL_CPU_INTERNAL_H */
@@ -176,6 +176,15 @@ struct AVExpr {
     struct AVExpr *param[3];
     double *var;
     FFSFC64 *prng_state;
+
+    /* program for av_expr_eval_batch(), only used in the root node */
+    int compiled; ///< 0 not yet compiled, 1 compiled, -1 cannot be compiled
+    struct ExprInsn *insns;
+    int nb_insns;
+    int nb_regs;
+    double *regs;
+    int nb_consts;
+    double *consts;
 };
 
 static double etime(double v)
@@ -363,6 +372,9 @@ void av_expr_free(AVExpr *e)
     av_expr_free(e->param[2]);
     av_freep(&e->var);
     av_freep(&e->prng_state);
+    av_freep(&e->insns);
+    av_freep(&e->regs);
+    av_freep(&e->consts);
     av_freep(&e);
 }
 
@@ -707,6 +719,56 @@ static int verify_expr(AVExpr *e)
     }
 }
 
+/**
+ * Replace the subexpressions which only depend on numbers by their value.
+ * Only operations without side effects are folded, so the results of
+ * av_expr_eval() are unchanged.
+ */
+static void fold_expr(AVExpr *e)
+{
+    Parser p = { 0 };
+    double value;
+    int i;
+
+    for (i = 0; i < 3; i++)
+        if (e->param[i])
+            fold_expr(e->param[i]);
+
+    switch (e->type) {
+    case e_value:
+    case e_const:
+    case e_func1:
+    case e_func2:
+    case e_ld:
+    case e_st:
+    case e_while:
+    case e_taylor:
+    case e_root:
+    case e_random:
+    case e_randomi:
+    case e_print:
+        return;
+    case e_func0:
+        if (e->a.func0 == etime)
+            return;
+        break;
+    default:
+        break;
+    }
+
+    for (i = 0; i < 3; i++)
+        if (e->param[i] && e->param[i]->type != e_value)
+            return;
+
+    value = eval_expr(&p, e);
+    for (i = 0; i < 3; i++) {
+        av_expr_free(e->param[i]);
+        e->param[i] = NULL;
+    }
+    e->type  = e_value;
+    e->value = value;
+}
+
 int av_expr_parse(AVExpr **expr, const char *s,
                   const char * const *const_names,
                   const char * const *func1_names, double (* const *funcs1)(void *, double),
@@ -749,6 +811,7 @@ int av_expr_parse(AVExpr **expr, const char *s,
         ret = AVERROR(EINVAL);
         goto end;
     }
+    fold_expr(e);
     e->var= av_mallocz(sizeof(double) *VARS);
     e->prng_state = av_mallocz(sizeof(*e->prng_state) *VARS);
     if (!e->var || !e->prng_state) {
@@ -800,6 +863,265 @@ double av_expr_eval(AVExpr *e, const double *const_values, void *opaque)
     return eval_expr(&p, e);
 }
 
+#define EXPR_BATCH    128
+#define EXPR_MAX_REGS 64
+
+/* lane mask for the branches of if() and ifnot() */
+#define e_mask (e_randomi + 1)
+
+typedef struct ExprInsn {
+    int type;
+    int dst;
+    int src[3];
+    int mask;           ///< register with the lanes to evaluate, or -1 for all
+    double value;
+    const AVExpr *node;
+} ExprInsn;
+
+static void count_consts(const AVExpr *e, int *nb_consts)
+{
+    int i;
+
+    if (e->type == e_const)
+        *nb_consts = FFMAX(*nb_consts, e->const_index + 1);
+    for (i = 0; i < 3; i++)
+        if (e->param[i])
+            count_consts(e->param[i], nb_consts);
+}
+
+static int has_user_func(const AVExpr *e)
+{
+    if (!e)
+        return 0;
+    if (e->type == e_func1 || e->type == e_func2)
+        return 1;
+    return has_user_func(e->param[0]) || has_user_func(e->param[1]) ||
+           has_user_func(e->param[2]);
+}
+
+static int emit_insn(AVExpr *root, ExprInsn *insn)
+{
+    if (insn->dst >= EXPR_MAX_REGS)
+        return AVERROR(ENOTSUP);
+    if (!av_dynarray2_add((void **)&root->insns, &root->nb_insns,
+                          sizeof(*insn), (const uint8_t *)insn))
+        return AVERROR(ENOMEM);
+    root->nb_regs = FFMAX(root->nb_regs, insn->dst + 1);
+    return 0;
+}
+
+/**
+ * Append the instructions computing e into register dst. Registers below
+ * dst are left untouched, so the parameters of a node end up in consecutive
+ * registers starting at the register of the node itself.
+ */
+static int compile_expr(AVExpr *root, const AVExpr *e, int dst, int mask)
+{
+    ExprInsn insn = { .type = e->type, .dst = dst, .mask = -1,
+                      .value = e->value, .node = e };
+    int i, ret, masked;
+
+    switch (e->type) {
+    case e_ld:
+    case e_st:
+    case e_while:
+    case e_taylor:
+    case e_root:
+    case e_random:
+    case e_randomi:
+    case e_print:
+        return AVERROR(ENOTSUP);
+    case e_func1:
+    case e_func2:
+        insn.mask = mask;
+        break;
+    case e_last:
+        /* the left side has no side effects, only the right one matters */
+        if ((ret = compile_expr(root, e->param[1], dst, mask)) < 0)
+            return ret;
+        insn.src[1] = dst;
+        return emit_insn(root, &insn);
+    case e_if:
+    case e_ifnot:
+        if ((ret = compile_expr(root, e->param[0], dst, mask)) < 0)
+            return ret;
+        insn.src[0] = dst;
+        /* only call the user functions for the lanes taking the branch */
+        masked = has_user_func(e->param[1]) || has_user_func(e->param[2]);
+        for (i = 1; i < 3; i++) {
+            int branch_mask = mask;
+            insn.src[i] = dst + i;
+            if (masked) {
+                ExprInsn m = { .type = e_mask, .dst = dst + 2 * i - 1,
+                               .src = { dst }, .mask = mask,
+                               .value = (e->type == e_if) ^ (i == 2) };
+                if ((ret = emit_insn(root, &m)) < 0)
+                    return ret;
+                branch_mask  = m.dst;
+                insn.src[i] = dst + 2 * i;
+            }
+            if (e->param[i]) {
+                ret = compile_expr(root, e->param[i], insn.src[i], branch_mask);
+            } else {
+                ExprInsn zero = { .type = e_value, .dst = insn.src[i], .mask = -1 };
+                ret = emit_insn(root, &zero);
+            }
+            if (ret < 0)
+                return ret;
+        }
+        return emit_insn(root, &insn);
+    default:
+        break;
+    }
+
+    for (i = 0; i < 3 && e->param[i]; i++) {
+        if ((ret = compile_expr(root, e->param[i], dst + i, mask)) < 0)
+            return ret;
+        insn.src[i] = dst + i;
+    }
+    return emit_insn(root, &insn);
+}
+
+static int compile_program(AVExpr *e)
+{
+    int ret = compile_expr(e, e, 0, -1);
+
+    if (ret >= 0) {
+        e->regs = av_malloc_array(e->nb_regs, EXPR_BATCH * sizeof(*e->regs));
+        if (!e->regs)
+            ret = AVERROR(ENOMEM);
+    }
+    if (ret < 0) {
+        av_freep(&e->insns);
+        e->nb_insns = 0;
+        e->nb_regs  = 0;
+    }
+    if (ret == AVERROR(ENOTSUP)) {
+        e->compiled = -1;
+        return 0;
+    }
+    if (ret < 0)
+        return ret;
+    e->compiled = 1;
+    return 0;
+}
+
+#define LOOP(expr)                  \
+    for (j = 0; j < n; j++)         \
+        d[j] = expr;                \
+    break
+
+static void run_program(const AVExpr *e, int offset, int n,
+                        const double *const_values,
+                        const double * const *const_arrays, void *opaque)
+{
+    int i, j;
+
+    for (i = 0; i < e->nb_insns; i++) {
+        const ExprInsn *insn = &e->insns[i];
+        const AVExpr *node = insn->node;
+        const double *a = e->regs + insn->src[0] * EXPR_BATCH;
+        const double *b = e->regs + insn->src[1] * EXPR_BATCH;
+        const double *c = e->regs + insn->src[2] * EXPR_BATCH;
+        const double *m = insn->mask >= 0 ? e->regs + insn->mask * EXPR_BATCH : NULL;
+        const double v = insn->value;
+        double *d = e->regs + insn->dst * EXPR_BATCH;
+
+        switch (insn->type) {
+        case e_value:  LOOP(v);
+        case e_const:
+            if (const_arrays && const_arrays[node->const_index]) {
+                const double *src = const_arrays[node->const_index] + offset;
+                LOOP(v * src[j]);
+            } else {
+                const double x = v * const_values[node->const_index];
+                LOOP(x);
+            }
+        case e_func0:  LOOP(v * node->a.func0(a[j]));
+        case e_func1:  LOOP(m && !m[j] ? 0 : v * node->a.func1(opaque, a[j]));
+        case e_func2:  LOOP(m && !m[j] ? 0 : v * node->a.func2(opaque, a[j], b[j]));
+        case e_squish: LOOP(1/(1+exp(4*a[j])));
+        case e_gauss:  LOOP(exp(-a[j]*a[j]/2)/sqrt(2*M_PI));
+        case e_isnan:  LOOP(v * !!isnan(a[j]));
+        case e_isinf:  LOOP(v * !!isinf(a[j]));
+        case e_floor:  LOOP(v * floor(a[j]));
+        case e_ceil:   LOOP(v * ceil (a[j]));
+        case e_trunc:  LOOP(v * trunc(a[j]));
+        case e_round:  LOOP(v * round(a[j]));
+        case e_sgn:    LOOP(v * FFDIFFSIGN(a[j], 0));
+        case e_sqrt:   LOOP(v * sqrt (a[j]));
+        case e_not:    LOOP(v * (a[j] == 0));
+        case e_if:     LOOP(v * ( a[j] ? b[j] : c[j]));
+        case e_ifnot:  LOOP(v * (!a[j] ? b[j] : c[j]));
+        case e_mask:   LOOP((a[j] != 0) == v && (!m || m[j]));
+        case e_clip:
+            LOOP(isnan(b[j]) || isnan(c[j]) || isnan(a[j]) || b[j] > c[j] ?
+                 NAN : v * av_clipd(a[j], b[j], c[j]));
+        case e_between: LOOP(v * (a[j] >= b[j] && a[j] <= c[j]));
+        case e_lerp:   LOOP(a[j] + (b[j] - a[j]) * c[j]);
+        case e_mod:    LOOP(v * (a[j] - floor(b[j] ? a[j] / b[j] : a[j] * INFINITY) * b[j]));
+        case e_gcd:    LOOP(v * av_gcd(a[j], b[j]));
+        case e_max:    LOOP(v * (a[j] >  b[j] ? a[j] : b[j]));
+        case e_min:    LOOP(v * (a[j] <  b[j] ? a[j] : b[j]));
+        case e_eq:     LOOP(v * (a[j] == b[j] ? 1.0 : 0.0));
+        case e_gt:     LOOP(v * (a[j] >  b[j] ? 1.0 : 0.0));
+        case e_gte:    LOOP(v * (a[j] >= b[j] ? 1.0 : 0.0));
+        case e_lt:     LOOP(v * (a[j] <  b[j] ? 1.0 : 0.0));
+        case e_lte:    LOOP(v * (a[j] <= b[j] ? 1.0 : 0.0));
+        case e_pow:    LOOP(v * pow(a[j], b[j]));
+        case e_mul:    LOOP(v * (a[j] * b[j]));
+        case e_div:    LOOP(v * (b[j] ? (a[j] / b[j]) : a[j] * INFINITY));
+        case e_add:    LOOP(v * (a[j] + b[j]));
+        case e_last:   LOOP(v * b[j]);
+        case e_hypot:  LOOP(v * hypot(a[j], b[j]));
+        case e_atan2:  LOOP(v * atan2(a[j], b[j]));
+        case e_bitand:
+            LOOP(isnan(a[j]) || isnan(b[j]) ? NAN : v * ((long int)a[j] & (long int)b[j]));
+        case e_bitor:
+            LOOP(isnan(a[j]) || isnan(b[j]) ? NAN : v * ((long int)a[j] | (long int)b[j]));
+        default:       LOOP(NAN);
+        }
+    }
+}
+
+int av_expr_eval_batch(AVExpr *e, double *res, int nb_values,
+                       const double *const_values,
+                       const double * const *const_arrays, void *opaque)
+{
+    int i, j, ret;
+
+    if (!e->compiled && (ret = compile_program(e)) < 0)
+        return ret;
+
+    if (e->compiled > 0) {
+        for (i = 0; i < nb_values; i += EXPR_BATCH) {
+            int n = FFMIN(nb_values - i, EXPR_BATCH);
+            run_program(e, i, n, const_values, const_arrays, opaque);
+            memcpy(res + i, e->regs, n * sizeof(*res));
+        }
+        return 0;
+    }
+
+    if (!const_arrays) {
+        for (i = 0; i < nb_values; i++)
+            res[i] = av_expr_eval(e, const_values, opaque);
+        return 0;
+    }
+
+    if (!e->consts) {
+        count_consts(e, &e->nb_consts);
+        e->consts = av_malloc_array(FFMAX(e->nb_consts, 1), sizeof(*e->consts));
+        if (!e->consts)
+            return AVERROR(ENOMEM);
+    }
+    for (i = 0; i < nb_values; i++) {
+        for (j = 0; j < e->nb_consts; j++)
+            e->consts[j] = const_arrays[j] ? const_arrays[j][i] : const_values[j];
+        res[i] = av_expr_eval(e, e->consts, opaque);
+    }
+    return 0;
+}
+
 int av_expr_parse_and_eval(double *d, const char *s,
                            const char * const *const_names, const double *const_values,
                            const char * const *func1_names, double (* const *funcs1)(void *, double),
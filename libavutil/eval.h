@@ -87,6 +87,36 @@ int av_expr_parse(AVExpr **expr, const char *s,
  */
 double av_expr_eval(AVExpr *e, const double *const_values, void *opaque);
 
+/**
+ * Evaluate a previously parsed expression for a batch of values.
+ *
+ * This gives the same results as calling av_expr_eval() nb_values times,
+ * where for the i-th call each constant c takes the value const_arrays[c][i]
+ * if const_arrays[c] is set, and const_values[c] otherwise. Expressions
+ * without state (st(), ld(), random() and similar) are compiled into a
+ * flat program on the first call and evaluated for many values at once.
+ *
+ * The functions from funcs1 and funcs2 may be called in a different order
+ * and a different number of times than with av_expr_eval(), so they must
+ * not have side effects. They are not called for the branch of if() or
+ * ifnot() which is not taken.
+ *
+ * @param e the AVExpr to evaluate
+ * @param res array of nb_values elements where the results are stored
+ * @param nb_values number of values to evaluate
+ * @param const_values array of values for the identifiers from
+ *                     av_expr_parse() const_names, used for the identifiers
+ *                     without an entry in const_arrays
+ * @param const_arrays NULL, or an array with one entry per identifier from
+ *                     av_expr_parse() const_names; each entry is either NULL
+ *                     or an array of nb_values values for that identifier
+ * @param opaque a pointer which will be passed to all functions from funcs1 and funcs2
+ * @return 0 on success, a negative AVERROR code on failure
+ */
+int av_expr_eval_batch(AVExpr *e, double *res, int nb_values,
+                       const double *const_values,
+                       const double * const *const_arrays, void *opaque);
+
 /**
  * Track the presence of variables and their number of occurrences in a parsed expression
  *
@@ -18,6 +18,7 @@
 
 #include <stdatomic.h>
 #include "cpu.h"
+#include "cpu_internal.h"
 #include "internal.h"
 #include "slicethread.h"
 #include "mem.h"
@@ -52,8 +53,33 @@ struct AVSliceThread {
     void            *priv;
     void            (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads);
     void            (*main_func)(void *priv);
+
+    /* only used when running on the shared pool */
+    int             shared;
+    int             nb_pending;   ///< helpers requested but not started yet
+    AVSliceThread   *next;        ///< next context in the pool queue
 };
 
+/**
+ * Worker threads shared by all the contexts created while
+ * av_cpu_set_shared_threads() is enabled. A context queues one request per
+ * helper it wants for the current execution; idle workers serve the queued
+ * contexts in turn, and the caller runs the requests which have not been
+ * picked up yet by the time it is done with its own jobs.
+ */
+typedef struct SharedPool {
+    pthread_cond_t  cond;
+    pthread_t       *threads;
+    int             nb_threads;
+    int             nb_users;
+    int             finished;
+    AVSliceThread   *head, *tail;
+} SharedPool;
+
+static AVMutex pool_init_mutex = AV_MUTEX_INITIALIZER; ///< protects starting and stopping the pool
+static AVMutex pool_mutex      = AV_MUTEX_INITIALIZER; ///< protects the queue
+static SharedPool pool;
+
 static int run_jobs(AVSliceThread *ctx)
 {
     unsigned nb_jobs    = ctx->nb_jobs;
@@ -95,6 +121,203 @@ static void *attribute_align_arg thread_worker(void *v)
     }
 }
 
+static void signal_done(AVSliceThread *ctx)
+{
+    pthread_mutex_lock(&ctx->done_mutex);
+    ctx->done = 1;
+    pthread_cond_signal(&ctx->done_cond);
+    pthread_mutex_unlock(&ctx->done_mutex);
+}
+
+static void pool_remove(AVSliceThread *ctx)
+{
+    AVSliceThread **p = &pool.head, *prev = NULL;
+
+    while (*p && *p != ctx) {
+        prev = *p;
+        p    = &prev->next;
+    }
+    if (!*p)
+        return;
+    *p = ctx->next;
+    if (pool.tail == ctx)
+        pool.tail = prev;
+    ctx->next = NULL;
+}
+
+static void *attribute_align_arg pool_worker(void *arg)
+{
+    ff_mutex_lock(&pool_mutex);
+    while (!pool.finished) {
+        AVSliceThread *ctx = pool.head;
+
+        if (!ctx) {
+            pthread_cond_wait(&pool.cond, &pool_mutex);
+            continue;
+        }
+
+        /* round robin between the queued contexts */
+        pool_remove(ctx);
+        if (--ctx->nb_pending) {
+            if (pool.tail)
+                pool.tail->next = ctx;
+            else
+                pool.head = ctx;
+            pool.tail = ctx;
+        }
+        ff_mutex_unlock(&pool_mutex);
+
+        if (run_jobs(ctx))
+            signal_done(ctx);
+
+        ff_mutex_lock(&pool_mutex);
+    }
+    ff_mutex_unlock(&pool_mutex);
+    return NULL;
+}
+
+/* must be called with pool_init_mutex locked */
+static void pool_stop(void)
+{
+    ff_mutex_lock(&pool_mutex);
+    pool.finished = 1;
+    pthread_cond_broadcast(&pool.cond);
+    ff_mutex_unlock(&pool_mutex);
+    for (int i = 0; i < pool.nb_threads; i++)
+        pthread_join(pool.threads[i], NULL);
+
+    pthread_cond_destroy(&pool.cond);
+    av_freep(&pool.threads);
+    pool.nb_threads = 0;
+    pool.finished   = 0;
+}
+
+/* must be called with pool_init_mutex locked */
+static int pool_attach(int nb_threads)
+{
+    int ret;
+
+    if (pool.nb_users++)
+        return 0;
+
+    if (!nb_threads)
+        nb_threads = av_cpu_count();
+    if (nb_threads <= 1)
+        goto fail;
+
+    pool.threads = av_calloc(nb_threads, sizeof(*pool.threads));
+    if (!pool.threads)
+        goto fail;
+    if (pthread_cond_init(&pool.cond, NULL)) {
+        av_freep(&pool.threads);
+        goto fail;
+    }
+
+    for (pool.nb_threads = 0; pool.nb_threads < nb_threads; pool.nb_threads++) {
+        ret = pthread_create(&pool.threads[pool.nb_threads], NULL, pool_worker, NULL);
+        if (ret) {
+            pool_stop();
+            goto fail;
+        }
+    }
+    return 0;
+fail:
+    pool.nb_users--;
+    return AVERROR(ENOSYS);
+}
+
+static void pool_detach(void)
+{
+    ff_mutex_lock(&pool_init_mutex);
+    if (!--pool.nb_users)
+        pool_stop();
+    ff_mutex_unlock(&pool_init_mutex);
+}
+
+static void shared_execute(AVSliceThread *ctx)
+{
+    int nb_helpers = ctx->nb_active_threads - 1, is_last = 0;
+
+    if (nb_helpers) {
+        ff_mutex_lock(&pool_mutex);
+        ctx->nb_pending = nb_helpers;
+        if (pool.tail)
+            pool.tail->next = ctx;
+        else
+            pool.head = ctx;
+        pool.tail = ctx;
+        if (nb_helpers > 1)
+            pthread_cond_broadcast(&pool.cond);
+        else
+            pthread_cond_signal(&pool.cond);
+        ff_mutex_unlock(&pool_mutex);
+    }
+
+    is_last = run_jobs(ctx);
+
+    if (nb_helpers) {
+        /* do the work of the helpers which did not start */
+        ff_mutex_lock(&pool_mutex);
+        nb_helpers      = ctx->nb_pending;
+        ctx->nb_pending = 0;
+        pool_remove(ctx);
+        ff_mutex_unlock(&pool_mutex);
+
+        while (nb_helpers--)
+            if (run_jobs(ctx))
+                is_last = 1;
+    }
+
+    if (!is_last) {
+        pthread_mutex_lock(&ctx->done_mutex);
+        while (!ctx->done)
+            pthread_cond_wait(&ctx->done_cond, &ctx->done_mutex);
+        pthread_mutex_unlock(&ctx->done_mutex);
+    }
+    ctx->done = 0;
+}
+
+static int shared_create(AVSliceThread **pctx, void *priv,
+                         void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
+                         int nb_threads, int pool_threads)
+{
+    AVSliceThread *ctx;
+    int ret;
+
+    ff_mutex_lock(&pool_init_mutex);
+    ret = pool_attach(pool_threads);
+    ff_mutex_unlock(&pool_init_mutex);
+    if (ret < 0)
+        return ret;
+
+    *pctx = ctx = av_mallocz(sizeof(*ctx));
+    if (!ctx) {
+        pool_detach();
+        return AVERROR(ENOMEM);
+    }
+
+    ctx->priv        = priv;
+    ctx->worker_func = worker_func;
+    ctx->nb_threads  = nb_threads;
+    ctx->shared      = 1;
+    atomic_init(&ctx->first_job, 0);
+    atomic_init(&ctx->current_job, 0);
+
+    if ((ret = pthread_mutex_init(&ctx->done_mutex, NULL))) {
+        av_freep(pctx);
+        pool_detach();
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_cond_init(&ctx->done_cond, NULL))) {
+        pthread_mutex_destroy(&ctx->done_mutex);
+        av_freep(pctx);
+        pool_detach();
+        return AVERROR(ret);
+    }
+
+    return nb_threads;
+}
+
 int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
                               void (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads),
                               void (*main_func)(void *priv),
@@ -102,7 +325,7 @@ int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
 {
     AVSliceThread *ctx;
     int nb_workers, i;
-    int ret;
+    int ret, pool_threads;
 
     av_assert0(nb_threads >= 0);
     if (!nb_threads) {
@@ -113,6 +336,15 @@ int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
             nb_threads = 1;
     }
 
+    /* contexts with a main function keep their own threads, as the main
+     * function cannot help with the jobs of the helpers */
+    pool_threads = ff_cpu_shared_threads();
+    if (pool_threads >= 0 && !main_func && nb_threads > 1) {
+        ret = shared_create(pctx, priv, worker_func, nb_threads, pool_threads);
+        if (ret != AVERROR(ENOSYS))
+            return ret;
+    }
+
     nb_workers = nb_threads;
     if (!main_func)
         nb_workers--;
@@ -196,6 +428,11 @@ void avpriv_slicethread_execute(AVSliceThread *ctx, int nb_jobs, int execute_mai
     ctx->nb_active_threads = FFMIN(nb_jobs, ctx->nb_threads);
     atomic_store_explicit(&ctx->first_job, 0, memory_order_relaxed);
     atomic_store_explicit(&ctx->current_job, ctx->nb_active_threads, memory_order_relaxed);
+    if (ctx->shared) {
+        shared_execute(ctx);
+        return;
+    }
+
     nb_workers             = ctx->nb_active_threads;
     if (!ctx->main_func || !execute_main)
         nb_workers--;
@@ -231,6 +468,14 @@ void avpriv_slicethread_free(AVSliceThread **pctx)
         return;
 
     ctx = *pctx;
+    if (ctx->shared) {
+        pthread_cond_destroy(&ctx->done_cond);
+        pthread_mutex_destroy(&ctx->done_mutex);
+        av_freep(pctx);
+        pool_detach();
+        return;
+    }
+
     nb_workers = ctx->nb_threads;
     if (!ctx->main_func)
         nb_workers--;
@@ -19,6 +19,7 @@
 #include <string.h>
 
 #include "libavutil/log.h"
+#include "libavutil/macros.h"
 #include "libavutil/mem_internal.h"
 #include "libavutil/aes_ctr.h"
 
@@ -26,12 +27,15 @@ static const DECLARE_ALIGNED(8, uint8_t, plain)[] = {
     0x6d, 0x6f, 0x73, 0x74, 0x20, 0x72, 0x61, 0x6e, 0x64, 0x6f, 0x6d
 };
 static DECLARE_ALIGNED(8, uint8_t, tmp)[11];
+static uint8_t long_plain[1000], long_tmp[1000];
 
 int main (void)
 {
     int ret = 1;
+    int i;
     struct AVAESCTR *ae, *ad;
     const uint8_t *iv;
+    uint8_t full_iv[16];
 
     ae = av_aes_ctr_alloc();
     ad = av_aes_ctr_alloc();
@@ -57,6 +61,21 @@ int main (void)
         goto ERROR;
     }
 
+    /* bulk encryption must match encryption in odd-sized pieces */
+    for (i = 0; i < sizeof(long_plain); i++)
+        long_plain[i] = i * 7 + 3;
+    memcpy(full_iv, iv, sizeof(full_iv));
+    av_aes_ctr_set_full_iv(ae, full_iv);
+    av_aes_ctr_set_full_iv(ad, full_iv);
+    av_aes_ctr_crypt(ae, long_tmp, long_plain, sizeof(long_tmp));
+    for (i = 0; i < sizeof(long_tmp); i += 7)
+        av_aes_ctr_crypt(ad, long_tmp + i, long_tmp + i, FFMIN(7, sizeof(long_tmp) - i));
+
+    if (memcmp(long_tmp, long_plain, sizeof(long_tmp)) != 0){
+        av_log(NULL, AV_LOG_ERROR, "test failed\n");
+        goto ERROR;
+    }
+
     av_log(NULL, AV_LOG_INFO, "test passed\n");
     ret = 0;
 
@@ -24,6 +24,8 @@
 
 #include "libavutil/libm.h"
 #include "libavutil/eval.h"
+#include "libavutil/log.h"
+#include "libavutil/macros.h"
 
 static const double const_values[] = {
     M_PI,
@@ -37,6 +39,45 @@ static const char *const const_names[] = {
     0
 };
 
+#define NB_BATCH 300
+
+/* check that batch evaluation matches av_expr_eval() for varying PI */
+static void check_batch(const char *s)
+{
+    AVExpr *e = NULL, *e_batch = NULL;
+    double pi[NB_BATCH], res[NB_BATCH];
+    const double *const_arrays[FF_ARRAY_ELEMS(const_values)] = { pi };
+    double values[FF_ARRAY_ELEMS(const_values)];
+    int i, level = av_log_get_level();
+
+    av_log_set_level(AV_LOG_QUIET);
+    if (av_expr_parse(&e, s, const_names, NULL, NULL, NULL, NULL, 0, NULL) < 0 ||
+        av_expr_parse(&e_batch, s, const_names, NULL, NULL, NULL, NULL, 0, NULL) < 0)
+        goto end;
+
+    for (i = 0; i < NB_BATCH; i++)
+        pi[i] = (i - NB_BATCH / 2) * 0.25;
+    memcpy(values, const_values, sizeof(values));
+
+    if (av_expr_eval_batch(e_batch, res, NB_BATCH, const_values, const_arrays, NULL) < 0) {
+        printf("av_expr_eval_batch failed\n");
+        goto end;
+    }
+    for (i = 0; i < NB_BATCH; i++) {
+        double d;
+        values[0] = pi[i];
+        d = av_expr_eval(e, values, NULL);
+        if (d != res[i] && !(isnan(d) && isnan(res[i]))) {
+            printf("'%s' batch mismatch for PI=%f: %f != %f\n", s, pi[i], res[i], d);
+            break;
+        }
+    }
+end:
+    av_expr_free(e);
+    av_expr_free(e_batch);
+    av_log_set_level(level);
+}
+
 int main(int argc, char **argv)
 {
     int i;
@@ -138,6 +179,9 @@ int main(int argc, char **argv)
         "clip(0, 2, 1)",
         "clip(0/0, 1, 2)",
         "clip(0, 0/0, 1)",
+        "if(gt(PI,3), sqrt(PI), -PI*E) + ifnot(lt(PI,-10), mod(PI, 3))",
+        "clip(PI*2, -1, 20) + lerp(PI, E, 0.5) + between(PI, -5, 5) * squish(PI)",
+        "st(0, PI); while(lt(ld(0), 100), st(0, ld(0) + 10))",
         NULL
     };
     int ret;
@@ -153,6 +197,7 @@ int main(int argc, char **argv)
             printf("'%s' -> %f\n\n", *expr, d);
         if (ret < 0)
             printf("av_expr_parse_and_eval failed\n");
+        check_batch(*expr);
     }
 
     ret = av_expr_parse_and_eval(&d, "1+(5-2)^(3-1)+1/2+sin(PI)-max(-2.2,-3.1)",
@@ -0,0 +1,259 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Compare av_tx_init_batch() and av_tx_init_2d() transforms with the same
+ * transforms done one at a time on contiguous arrays with av_tx_init().
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/lfg.h"
+#include "libavutil/macros.h"
+#include "libavutil/mem.h"
+#include "libavutil/tx.h"
+
+static AVLFG lfg;
+
+static void fill(void *buf, size_t size, int is_double)
+{
+    if (is_double) {
+        double *d = buf;
+        for (size_t i = 0; i < size / sizeof(*d); i++)
+            d[i] = av_lfg_get(&lfg) / (double)UINT32_MAX - 0.5;
+    } else {
+        float *f = buf;
+        for (size_t i = 0; i < size / sizeof(*f); i++)
+            f[i] = av_lfg_get(&lfg) / (float)UINT32_MAX - 0.5f;
+    }
+}
+
+static void copy(uint8_t *dst, ptrdiff_t dst_stride,
+                 const uint8_t *src, ptrdiff_t src_stride, int len, int size)
+{
+    for (int i = 0; i < len; i++)
+        memcpy(dst + i * dst_stride, src + i * src_stride, size);
+}
+
+enum Layout {
+    ROWS,       /* one transform after the other */
+    COLUMNS,    /* transforms are the columns of an array */
+    REVERSED,   /* rows in reverse order, negative distance */
+    NB_LAYOUTS,
+};
+
+static const char *const layout_names[] = { "rows", "columns", "reversed" };
+
+/* Run count transforms of the given layout through the batch API and
+ * compare each of them with the same transform done by itself. */
+static int test_batch(enum AVTXType type, int inv, int len, int count,
+                      enum Layout layout)
+{
+    const int is_double = type == AV_TX_DOUBLE_FFT || type == AV_TX_DOUBLE_RDFT;
+    const int real      = is_double ? sizeof(double) : sizeof(float);
+    const int is_rdft   = type == AV_TX_FLOAT_RDFT || type == AV_TX_DOUBLE_RDFT;
+    const int in_size   = is_rdft && !inv ? real : 2 * real;
+    const int out_size  = is_rdft &&  inv ? real : 2 * real;
+    const int in_len    = is_rdft &&  inv ? len / 2 + 1 : len;
+    const int out_len   = is_rdft && !inv ? len / 2 + 1 : len;
+    const double scale_d = 1.0;
+    const float  scale_f = 1.0f;
+    const void *scale = is_double ? (const void *)&scale_d : (const void *)&scale_f;
+    /* padded rows, aligned so that the rows layouts take the direct path */
+    const int row_len = FFALIGN(FFMAX(in_len, out_len) + 1, 16);
+    const size_t in_bytes  = (size_t)count * row_len * in_size;
+    const size_t out_bytes = (size_t)count * row_len * out_size;
+    AVTXContext *batch_ctx = NULL, *ref_ctx = NULL;
+    av_tx_batch_fn batch_fn;
+    av_tx_fn ref_fn;
+    uint8_t *in = NULL, *in_copy = NULL, *out = NULL, *ref_in = NULL, *ref_out = NULL;
+    ptrdiff_t in_stride, in_dist, out_stride, out_dist;
+    uint8_t *in_start, *out_start;
+    int ret = 1;
+
+    if (av_tx_init_batch(&batch_ctx, &batch_fn, type, inv, len, scale, 0) < 0 ||
+        av_tx_init(&ref_ctx, &ref_fn, type, inv, len, scale, 0) < 0)
+        goto end;
+
+    in      = av_malloc(in_bytes);
+    in_copy = av_malloc(in_bytes);
+    out     = av_mallocz(out_bytes);
+    ref_in  = av_malloc(row_len * in_size);
+    ref_out = av_malloc(row_len * out_size);
+    if (!in || !in_copy || !out || !ref_in || !ref_out)
+        goto end;
+
+    fill(in, in_bytes, is_double);
+    memcpy(in_copy, in, in_bytes);
+
+    switch (layout) {
+    case ROWS:
+        in_stride  = in_size;
+        in_dist    = row_len * in_size;
+        out_stride = out_size;
+        out_dist   = row_len * out_size;
+        in_start   = in;
+        out_start  = out;
+        break;
+    case COLUMNS:
+        in_stride  = count * in_size;
+        in_dist    = in_size;
+        out_stride = count * out_size;
+        out_dist   = out_size;
+        in_start   = in;
+        out_start  = out;
+        break;
+    default:
+        in_stride  = in_size;
+        in_dist    = -row_len * in_size;
+        out_stride = out_size;
+        out_dist   = -row_len * out_size;
+        in_start   = in  + (count - 1) * row_len * in_size;
+        out_start  = out + (count - 1) * row_len * out_size;
+        break;
+    }
+
+    batch_fn(batch_ctx, out_start, out_stride, out_dist,
+             in_start, in_stride, in_dist, count);
+
+    if (memcmp(in, in_copy, in_bytes)) {
+        fprintf(stderr, "type %d inv %d len %d %s: input overwritten\n",
+                type, inv, len, layout_names[layout]);
+        goto end;
+    }
+
+    for (int i = 0; i < count; i++) {
+        copy(ref_in, in_size, in_start + i * in_dist, in_stride, in_len, in_size);
+        ref_fn(ref_ctx, ref_out, ref_in, in_size);
+        copy(ref_in, out_size, out_start + i * out_dist, out_stride, out_len, out_size);
+        if (memcmp(ref_in, ref_out, out_len * out_size)) {
+            fprintf(stderr, "type %d inv %d len %d %s: transform %d differs\n",
+                    type, inv, len, layout_names[layout], i);
+            goto end;
+        }
+    }
+    ret = 0;
+
+end:
+    av_tx_uninit(&batch_ctx);
+    av_tx_uninit(&ref_ctx);
+    av_free(in);
+    av_free(in_copy);
+    av_free(out);
+    av_free(ref_in);
+    av_free(ref_out);
+    return ret;
+}
+
+/* Compare a 2D FFT with 1D FFTs of all rows, then of all columns. */
+static int test_2d(enum AVTXType type, int inv, int width, int height, int inplace)
+{
+    const int is_double = type == AV_TX_DOUBLE_FFT;
+    const int size = is_double ? sizeof(AVComplexDouble) : sizeof(AVComplexFloat);
+    const double scale_d = 1.0;
+    const float  scale_f = 1.0f;
+    const void *scale = is_double ? (const void *)&scale_d : (const void *)&scale_f;
+    const ptrdiff_t stride = (width + 1) * size;
+    AVTXContext *ctx = NULL, *row_ctx = NULL, *col_ctx = NULL;
+    av_tx_fn fn, row_fn, col_fn;
+    uint8_t *in = NULL, *out = NULL, *ref = NULL, *tmp_in = NULL, *tmp_out = NULL;
+    int ret = 1;
+
+    if (av_tx_init_2d(&ctx, &fn, type, inv, width, height, 0) < 0 ||
+        av_tx_init(&row_ctx, &row_fn, type, inv, width,  scale, 0) < 0 ||
+        av_tx_init(&col_ctx, &col_fn, type, inv, height, scale, 0) < 0)
+        goto end;
+
+    in      = av_malloc(height * stride);
+    out     = av_malloc(height * stride);
+    ref     = av_malloc(height * stride);
+    tmp_in  = av_malloc(FFMAX(width, height) * size);
+    tmp_out = av_malloc(FFMAX(width, height) * size);
+    if (!in || !out || !ref || !tmp_in || !tmp_out)
+        goto end;
+
+    fill(in, height * stride, is_double);
+
+    for (int y = 0; y < height; y++) {
+        memcpy(tmp_in, in + y * stride, width * size);
+        row_fn(row_ctx, ref + y * stride, tmp_in, size);
+    }
+    for (int x = 0; x < width; x++) {
+        copy(tmp_in, size, ref + x * size, stride, height, size);
+        col_fn(col_ctx, tmp_out, tmp_in, size);
+        copy(ref + x * size, stride, tmp_out, size, height, size);
+    }
+
+    if (inplace) {
+        memcpy(out, in, height * stride);
+        fn(ctx, out, out, stride);
+    } else {
+        fn(ctx, out, in, stride);
+    }
+
+    for (int y = 0; y < height; y++) {
+        if (memcmp(out + y * stride, ref + y * stride, width * size)) {
+            fprintf(stderr, "2D type %d inv %d %dx%d%s: row %d differs\n",
+                    type, inv, width, height, inplace ? " in-place" : "", y);
+            goto end;
+        }
+    }
+    ret = 0;
+
+end:
+    av_tx_uninit(&ctx);
+    av_tx_uninit(&row_ctx);
+    av_tx_uninit(&col_ctx);
+    av_free(in);
+    av_free(out);
+    av_free(ref);
+    av_free(tmp_in);
+    av_free(tmp_out);
+    return ret;
+}
+
+int main(void)
+{
+    static const enum AVTXType types[] = {
+        AV_TX_FLOAT_FFT, AV_TX_DOUBLE_FFT, AV_TX_FLOAT_RDFT, AV_TX_DOUBLE_RDFT,
+    };
+    /* power of two and composite lengths, counts covering partial tiles */
+    static const int lens[]   = { 16, 60, 256 };
+    static const int counts[] = { 1, 16, 37 };
+    int ret = 0;
+
+    av_lfg_init(&lfg, 0xdeadbeef);
+
+    for (int t = 0; t < FF_ARRAY_ELEMS(types); t++)
+        for (int inv = 0; inv < 2; inv++)
+            for (int l = 0; l < FF_ARRAY_ELEMS(lens); l++)
+                for (int c = 0; c < FF_ARRAY_ELEMS(counts); c++)
+                    for (int layout = 0; layout < NB_LAYOUTS; layout++)
+                        ret |= test_batch(types[t], inv, lens[l], counts[c], layout);
+
+    for (int inv = 0; inv < 2; inv++) {
+        for (int inplace = 0; inplace < 2; inplace++) {
+            ret |= test_2d(AV_TX_FLOAT_FFT,  inv, 32, 24, inplace);
+            ret |= test_2d(AV_TX_FLOAT_FFT,  inv, 15, 64, inplace);
+            ret |= test_2d(AV_TX_DOUBLE_FFT, inv, 20, 16, inplace);
+        }
+    }
+
+    return ret;
+}
@@ -900,28 +900,42 @@ end:
     return ret;
 }
 
+static const double default_scale_d = 1.0;
+static const float  default_scale_f = 1.0f;
+
+static const void *tx_default_scale(enum AVTXType type, const void *scale)
+{
+    if (!scale && ((type == AV_TX_DOUBLE_MDCT) || (type == AV_TX_DOUBLE_DCT) ||
+                   (type == AV_TX_DOUBLE_DCT_I) || (type == AV_TX_DOUBLE_DST_I) ||
+                   (type == AV_TX_DOUBLE_RDFT)))
+        scale = &default_scale_d;
+    else if (!scale && !TYPE_IS(FFT, type))
+        scale = &default_scale_f;
+
+    return scale;
+}
+
+static uint64_t tx_default_flags(uint64_t flags)
+{
+    if (!(flags & AV_TX_UNALIGNED))
+        flags |= FF_TX_ALIGNED;
+    if (!(flags & AV_TX_INPLACE))
+        flags |= FF_TX_OUT_OF_PLACE;
+
+    return flags;
+}
+
 av_cold int av_tx_init(AVTXContext **ctx, av_tx_fn *tx, enum AVTXType type,
                        int inv, int len, const void *scale, uint64_t flags)
 {
     int ret;
     AVTXContext tmp = { 0 };
-    const double default_scale_d = 1.0;
-    const float  default_scale_f = 1.0f;
 
     if (!len || type >= AV_TX_NB || !ctx || !tx)
         return AVERROR(EINVAL);
 
-    if (!(flags & AV_TX_UNALIGNED))
-        flags |= FF_TX_ALIGNED;
-    if (!(flags & AV_TX_INPLACE))
-        flags |= FF_TX_OUT_OF_PLACE;
-
-    if (!scale && ((type == AV_TX_DOUBLE_MDCT) || (type == AV_TX_DOUBLE_DCT) ||
-                   (type == AV_TX_DOUBLE_DCT_I) || (type == AV_TX_DOUBLE_DST_I) ||
-                   (type == AV_TX_DOUBLE_RDFT)))
-        scale = &default_scale_d;
-    else if (!scale && !TYPE_IS(FFT, type))
-        scale = &default_scale_f;
+    flags = tx_default_flags(flags);
+    scale = tx_default_scale(type, scale);
 
     ret = ff_tx_init_subtx(&tmp, type, flags, NULL, len, inv, scale);
     if (ret < 0)
@@ -937,3 +951,224 @@ av_cold int av_tx_init(AVTXContext **ctx, av_tx_fn *tx, enum AVTXType type,
 
     return ret;
 }
+
+/* Number of transforms copied to and from the temporary buffer at once when
+ * the input or output is not contiguous. Copying a tile of transforms reads
+ * whole cache lines when the transforms are the columns of an array. */
+#define TX_BATCH_TILE 16
+
+/* Sample sizes in bytes and numbers of samples of the input and output of
+ * a subtransform. */
+static void tx_batch_geometry(const AVTXContext *s, int *in_size, int *in_len,
+                              int *out_size, int *out_len)
+{
+    const int real = s->type == AV_TX_DOUBLE_FFT ||
+                     s->type == AV_TX_DOUBLE_RDFT ? sizeof(double) : sizeof(float);
+
+    *in_size = *out_size = 2 * real;
+    *in_len  = *out_len  = s->len;
+
+    if (TYPE_IS(RDFT, s->type)) {
+        if (s->inv) {
+            *in_len   = s->len / 2 + 1;
+            *out_size = real;
+        } else {
+            *in_size  = real;
+            *out_len  = s->len / 2 + 1;
+        }
+    }
+}
+
+static ptrdiff_t tx_batch_row_size(const AVTXContext *s)
+{
+    int in_size, in_len, out_size, out_len;
+
+    tx_batch_geometry(s, &in_size, &in_len, &out_size, &out_len);
+
+    return FFALIGN(FFMAX(in_size * in_len, out_size * out_len), 64);
+}
+
+static av_always_inline void tx_copy_c(uint8_t *dst, ptrdiff_t dst_stride, ptrdiff_t dst_dist,
+                                       const uint8_t *src, ptrdiff_t src_stride, ptrdiff_t src_dist,
+                                       int len, int count, int size, int columns)
+{
+    if (columns) {
+        for (int j = 0; j < len; j++)
+            for (int i = 0; i < count; i++)
+                memcpy(dst + i * dst_dist + j * dst_stride,
+                       src + i * src_dist + j * src_stride, size);
+    } else {
+        for (int i = 0; i < count; i++)
+            for (int j = 0; j < len; j++)
+                memcpy(dst + i * dst_dist + j * dst_stride,
+                       src + i * src_dist + j * src_stride, size);
+    }
+}
+
+/* Copy count arrays of len samples. The loop order follows the array in
+ * memory which is not the temporary buffer. */
+static void tx_copy(uint8_t *dst, ptrdiff_t dst_stride, ptrdiff_t dst_dist,
+                    const uint8_t *src, ptrdiff_t src_stride, ptrdiff_t src_dist,
+                    int len, int count, int size, int columns)
+{
+    switch (size) {
+#define COPY(n)                                                               \
+    case n:                                                                   \
+        if (columns)                                                          \
+            tx_copy_c(dst, dst_stride, dst_dist, src, src_stride, src_dist,   \
+                      len, count, n, 1);                                      \
+        else                                                                  \
+            tx_copy_c(dst, dst_stride, dst_dist, src, src_stride, src_dist,   \
+                      len, count, n, 0);                                      \
+        break;
+    COPY(4)
+    COPY(8)
+    COPY(16)
+#undef COPY
+    }
+}
+
+static void tx_batch(AVTXContext *s, int idx,
+                     uint8_t *out, ptrdiff_t out_stride, ptrdiff_t out_dist,
+                     const uint8_t *in, ptrdiff_t in_stride, ptrdiff_t in_dist,
+                     int count)
+{
+    AVTXContext *sub = &s->sub[idx];
+    const av_tx_fn fn = s->fn[idx];
+    const ptrdiff_t row = tx_batch_row_size(sub);
+    const uintptr_t align = (s->flags & FF_TX_ALIGNED) ? av_cpu_max_align() - 1 : 0;
+    uint8_t *tmp_in  = (uint8_t *)s->tmp;
+    uint8_t *tmp_out = tmp_in + TX_BATCH_TILE * row;
+    int in_size, in_len, out_size, out_len;
+    int in_direct, out_direct;
+
+    tx_batch_geometry(sub, &in_size, &in_len, &out_size, &out_len);
+
+    /* Contiguous and suitably aligned arrays are passed to the transform
+     * directly. Inverse RDFTs overwrite their input, so it is always copied. */
+    in_direct  = in_stride == in_size && in != out &&
+                 !(((uintptr_t)in | (uintptr_t)in_dist) & align) &&
+                 !(TYPE_IS(RDFT, s->type) && s->inv);
+    out_direct = out_stride == out_size &&
+                 !(((uintptr_t)out | (uintptr_t)out_dist) & align);
+
+    for (int i = 0; i < count; i += TX_BATCH_TILE) {
+        const int n = FFMIN(count - i, TX_BATCH_TILE);
+        const uint8_t *src = in + i * in_dist;
+        uint8_t *dst = out + i * out_dist;
+
+        if (!in_direct)
+            tx_copy(tmp_in, in_size, row, src, in_stride, in_dist,
+                    in_len, n, in_size, FFABS(in_stride) > FFABS(in_dist));
+
+        for (int j = 0; j < n; j++)
+            fn(sub, out_direct ? dst + j * out_dist : tmp_out + j * row,
+               in_direct ? (void *)(src + j * in_dist) : tmp_in + j * row,
+               in_size);
+
+        if (!out_direct)
+            tx_copy(dst, out_stride, out_dist, tmp_out, out_size, row,
+                    out_len, n, out_size, FFABS(out_stride) > FFABS(out_dist));
+    }
+}
+
+static void tx_batch_fn(AVTXContext *s,
+                        void *out, ptrdiff_t out_stride, ptrdiff_t out_dist,
+                        const void *in, ptrdiff_t in_stride, ptrdiff_t in_dist,
+                        int count)
+{
+    tx_batch(s, 0, out, out_stride, out_dist, in, in_stride, in_dist, count);
+}
+
+static void tx_2d_fn(AVTXContext *s, void *out, void *in, ptrdiff_t stride)
+{
+    const int size = s->type == AV_TX_DOUBLE_FFT ? sizeof(AVComplexDouble)
+                                                 : sizeof(AVComplexFloat);
+
+    tx_batch(s, 0, out, size, stride, in,  size, stride, s->sub[1].len);
+    tx_batch(s, 1, out, stride, size, out, stride, size, s->sub[0].len);
+}
+
+static av_cold int tx_init_multi(AVTXContext **ctx, enum AVTXType type, int inv,
+                                 const int *len, int nb_len, const void *scale,
+                                 uint64_t flags)
+{
+    AVTXContext *s;
+    ptrdiff_t row = 0;
+    int ret;
+
+    if (!ctx || (!TYPE_IS(FFT, type) && !TYPE_IS(RDFT, type)) ||
+        (flags & (AV_TX_REAL_TO_REAL | AV_TX_REAL_TO_IMAGINARY)))
+        return AVERROR(EINVAL);
+
+    s = av_mallocz(sizeof(*s));
+    if (!s)
+        return AVERROR(ENOMEM);
+
+    /* The transforms always run out-of-place from or to the temporary
+     * buffer when needed */
+    s->type  = type;
+    s->inv   = inv;
+    s->flags = tx_default_flags(flags & ~AV_TX_INPLACE);
+    scale    = tx_default_scale(type, scale);
+
+    for (int i = 0; i < nb_len; i++) {
+        if (len[i] <= 0) {
+            ret = AVERROR(EINVAL);
+            goto fail;
+        }
+        ret = ff_tx_init_subtx(s, type, s->flags, NULL, len[i], inv, scale);
+        if (ret < 0)
+            goto fail;
+        row = FFMAX(row, tx_batch_row_size(&s->sub[i]));
+    }
+    s->len = s->sub[0].len;
+
+    s->tmp = av_malloc(2 * TX_BATCH_TILE * row);
+    if (!s->tmp) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+
+    *ctx = s;
+    return 0;
+
+fail:
+    av_tx_uninit(&s);
+    return ret;
+}
+
+av_cold int av_tx_init_batch(AVTXContext **ctx, av_tx_batch_fn *tx, enum AVTXType type,
+                             int inv, int len, const void *scale, uint64_t flags)
+{
+    int ret;
+
+    if (!tx || type >= AV_TX_NB)
+        return AVERROR(EINVAL);
+
+    ret = tx_init_multi(ctx, type, inv, &len, 1, scale, flags);
+    if (ret < 0)
+        return ret;
+
+    *tx = tx_batch_fn;
+
+    return 0;
+}
+
+av_cold int av_tx_init_2d(AVTXContext **ctx, av_tx_fn *tx, enum AVTXType type,
+                          int inv, int width, int height, uint64_t flags)
+{
+    const int len[2] = { width, height };
+    int ret;
+
+    if (!tx || !TYPE_IS(FFT, type))
+        return AVERROR(EINVAL);
+
+    ret = tx_init_multi(ctx, type, inv, len, 2, NULL, flags);
+    if (ret < 0)
+        return ret;
+
+    *tx = tx_2d_fn;
+
+    return 0;
+}
@@ -150,6 +150,36 @@ enum AVTXType {
  */
 typedef void (*av_tx_fn)(AVTXContext *s, void *out, void *in, ptrdiff_t stride);
 
+/**
+ * Function pointer to a function to perform a batch of transforms of the
+ * same size, as created by av_tx_init_batch().
+ *
+ * The input of the i-th transform starts at in + i * in_dist, its n-th
+ * sample is at in + i * in_dist + n * in_stride. The output is laid out
+ * the same way with out_dist and out_stride. All values are in bytes and
+ * may be negative. Samples are AVComplexFloat/AVComplexDouble/AVComplexInt32
+ * for FFTs, and for RDFTs the real or complex type the transform reads or
+ * writes, as described for the transform type.
+ *
+ * Rows and columns of 2D arrays, or interleaved channels, can be transformed
+ * directly without copying them into separate arrays first. The input is
+ * never overwritten, even for inverse RDFTs. The output may only overlap the
+ * input if both have the same layout.
+ *
+ * @param s the transform context
+ * @param out the output array
+ * @param out_stride the spacing between two samples of one output
+ * @param out_dist the spacing between the starts of two outputs
+ * @param in the input array
+ * @param in_stride the spacing between two samples of one input
+ * @param in_dist the spacing between the starts of two inputs
+ * @param count the number of transforms
+ */
+typedef void (*av_tx_batch_fn)(AVTXContext *s,
+                               void *out, ptrdiff_t out_stride, ptrdiff_t out_dist,
+                               const void *in, ptrdiff_t in_stride, ptrdiff_t in_dist,
+                               int count);
+
 /**
  * Flags for av_tx_init()
  */
@@ -202,6 +232,47 @@ enum AVTXFlags {
 int av_tx_init(AVTXContext **ctx, av_tx_fn *tx, enum AVTXType type,
                int inv, int len, const void *scale, uint64_t flags);
 
+/**
+ * Initialize a context for batches of transforms with the given
+ * configuration. Only FFTs and RDFTs are supported, without the
+ * AV_TX_REAL_TO_REAL and AV_TX_REAL_TO_IMAGINARY flags.
+ *
+ * The context contains a temporary buffer, so a separate context is needed
+ * for each thread which runs transforms at the same time.
+ *
+ * @param ctx the context to allocate, will be NULL on error
+ * @param tx pointer to the batch transform function pointer to set
+ * @param type type the type of transform
+ * @param inv whether to do an inverse or a forward transform
+ * @param len the size of each transform in samples
+ * @param scale pointer to the value to scale the output if supported by type
+ * @param flags a bitmask of AVTXFlags or 0
+ * @return 0 on success, negative error code on failure
+ */
+int av_tx_init_batch(AVTXContext **ctx, av_tx_batch_fn *tx, enum AVTXType type,
+                     int inv, int len, const void *scale, uint64_t flags);
+
+/**
+ * Initialize a two-dimensional complex FFT context. Only the FFT types are
+ * supported.
+ *
+ * The returned function transforms a height x width array of complex
+ * values: all rows first, then all columns. Its stride parameter is the
+ * spacing between two rows in bytes, for both the input and the output.
+ * The transform may be done in-place. The output is not normalized.
+ *
+ * @param ctx the context to allocate, will be NULL on error
+ * @param tx pointer to the transform function pointer to set
+ * @param type type the type of transform
+ * @param inv whether to do an inverse or a forward transform
+ * @param width the number of samples in a row
+ * @param height the number of rows
+ * @param flags a bitmask of AVTXFlags or 0
+ * @return 0 on success, negative error code on failure
+ */
+int av_tx_init_2d(AVTXContext **ctx, av_tx_fn *tx, enum AVTXType type,
+                  int inv, int width, int height, uint64_t flags);
+
 /**
  * Frees a context and sets *ctx to NULL, does nothing when *ctx == NULL.
  */
@@ -1137,6 +1137,88 @@ static const FFTXCodelet TX_NAME(ff_tx_fft_pfa_ns_def) = {
     .prio       = FF_TX_PRIO_BASE,
 };
 
+static av_cold int TX_NAME(ff_tx_fft_pfa_comp_init)(AVTXContext *s,
+                                                    const FFTXCodelet *cd,
+                                                    uint64_t flags,
+                                                    FFTXCodeletOptions *opts,
+                                                    int len, int inv,
+                                                    const void *scale)
+{
+    int ret, sub_len = len / cd->factors[0];
+    FFTXCodeletOptions sub_opts = { .map_dir = FF_TX_MAP_SCATTER };
+
+    flags &= ~FF_TX_OUT_OF_PLACE; /* We want the subtransform to be */
+    flags |=  AV_TX_INPLACE;      /* in-place */
+    flags |=  FF_TX_PRESHUFFLE;   /* This function handles the permute step */
+
+    if ((ret = ff_tx_init_subtx(s, TX_TYPE(FFT), flags, &sub_opts,
+                                sub_len, inv, scale)))
+        return ret;
+
+    if ((ret = ff_tx_gen_compound_mapping(s, opts, inv, cd->factors[0], sub_len)))
+        return ret;
+
+    /* Our 15-point transform is also a compound one, so embed its input map */
+    if (cd->factors[0] == 15)
+        TX_EMBED_INPUT_PFA_MAP(s->map, len, 3, 5);
+
+    if (!(s->tmp = av_malloc(len*sizeof(*s->tmp))))
+        return AVERROR(ENOMEM);
+
+    TX_TAB(ff_tx_init_tabs)(cd->factors[0]);
+
+    return 0;
+}
+
+/* Same as ff_tx_fft_pfa for N*2^n lengths, but with the odd-length transform
+ * inlined rather than called through a function pointer for every column. */
+#define DECL_COMP_FFT(N)                                                       \
+static void TX_NAME(ff_tx_fft_pfa_##N##xM)(AVTXContext *s, void *_out,         \
+                                           void *_in, ptrdiff_t stride)        \
+{                                                                              \
+    TXComplex fft##N##in[N];                                                   \
+    TXComplex *in = _in, *out = _out;                                          \
+    const int m = s->sub->len;                                                 \
+    const int l = N*m;                                                         \
+    const int *in_map = s->map, *out_map = in_map + l;                         \
+    const int *sub_map = s->sub->map;                                          \
+                                                                               \
+    stride /= sizeof(*out);                                                    \
+                                                                               \
+    for (int i = 0; i < m; i++) {                                              \
+        for (int j = 0; j < N; j++)                                            \
+            fft##N##in[j] = in[in_map[j]];                                     \
+        fft##N(s->tmp + sub_map[i], fft##N##in, m);                            \
+        in_map += N;                                                           \
+    }                                                                          \
+                                                                               \
+    for (int i = 0; i < N; i++)                                                \
+        s->fn[0](&s->sub[0], s->tmp + m*i, s->tmp + m*i, sizeof(TXComplex));   \
+                                                                               \
+    for (int i = 0; i < l; i++)                                                \
+        out[i*stride] = s->tmp[out_map[i]];                                    \
+}                                                                              \
+                                                                               \
+static const FFTXCodelet TX_NAME(ff_tx_fft_pfa_##N##xM_def) = {                \
+    .name       = TX_NAME_STR("fft_pfa_" #N "xM"),                             \
+    .function   = TX_NAME(ff_tx_fft_pfa_##N##xM),                              \
+    .type       = TX_TYPE(FFT),                                                \
+    .flags      = AV_TX_UNALIGNED | FF_TX_OUT_OF_PLACE,                        \
+    .factors    = { N, 2 },                                                    \
+    .nb_factors = 2,                                                           \
+    .min_len    = N*2,                                                         \
+    .max_len    = TX_LEN_UNLIMITED,                                            \
+    .init       = TX_NAME(ff_tx_fft_pfa_comp_init),                            \
+    .cpu_flags  = FF_TX_CPU_FLAGS_ALL,                                         \
+    .prio       = FF_TX_PRIO_BASE + 96,                                        \
+};
+
+DECL_COMP_FFT(3)
+DECL_COMP_FFT(5)
+DECL_COMP_FFT(7)
+DECL_COMP_FFT(9)
+DECL_COMP_FFT(15)
+
 static av_cold int TX_NAME(ff_tx_mdct_naive_init)(AVTXContext *s,
                                                   const FFTXCodelet *cd,
                                                   uint64_t flags,
@@ -2184,6 +2266,11 @@ const FFTXCodelet * const TX_NAME(ff_tx_codelet_list)[] = {
     &TX_NAME(ff_tx_fft_inplace_small_def),
     &TX_NAME(ff_tx_fft_pfa_def),
     &TX_NAME(ff_tx_fft_pfa_ns_def),
+    &TX_NAME(ff_tx_fft_pfa_3xM_def),
+    &TX_NAME(ff_tx_fft_pfa_5xM_def),
+    &TX_NAME(ff_tx_fft_pfa_7xM_def),
+    &TX_NAME(ff_tx_fft_pfa_9xM_def),
+    &TX_NAME(ff_tx_fft_pfa_15xM_def),
     &TX_NAME(ff_tx_fft_naive_def),
     &TX_NAME(ff_tx_fft_naive_small_def),
     &TX_NAME(ff_tx_mdct_fwd_def),
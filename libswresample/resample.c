@@ -177,13 +177,49 @@ static void resample_free(ResampleContext **cc){
     ResampleContext *c = *cc;
     if(!c)
         return;
+    avpriv_slicethread_free(&c->slicethread);
     av_freep(&c->filter_bank);
     av_freep(cc);
 }
 
+static void resample_worker(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads)
+{
+    ResampleContext *c = priv;
+    AudioData *dst = c->job.dst, *src = c->job.src;
+    int start = (dst->ch_count *  jobnr     ) / nb_jobs;
+    int end   = (dst->ch_count * (jobnr + 1)) / nb_jobs;
+
+    for (int i = start; i < end; i++) {
+        if (!c->job.func) {
+            c->dsp.resample_one(dst->ch[i], src->ch[i], c->job.n, c->job.index2, c->job.incr);
+        } else if (i + 1 == dst->ch_count) {
+            /* the other channels may still be reading the position, so
+             * advance it on a copy of the context */
+            ResampleContext tmp = *c;
+            c->job.consumed = c->job.func(&tmp, dst->ch[i], src->ch[i], c->job.n, 1);
+            c->job.index    = tmp.index;
+            c->job.frac     = tmp.frac;
+        } else {
+            c->job.func(c, dst->ch[i], src->ch[i], c->job.n, 0);
+        }
+    }
+}
+
+static void resample_channels(ResampleContext *c, AudioData *dst, AudioData *src, int n)
+{
+    c->job.dst = dst;
+    c->job.src = src;
+    c->job.n   = n;
+
+    if (c->slicethread && dst->ch_count > 1)
+        avpriv_slicethread_execute(c->slicethread, FFMIN(dst->ch_count, c->nb_threads), 0);
+    else
+        resample_worker(c, 0, 0, 1, 1);
+}
+
 static ResampleContext *resample_init(ResampleContext *c, int out_rate, int in_rate, int filter_size, int phase_shift, int linear,
                                     double cutoff0, enum AVSampleFormat format, enum SwrFilterType filter_type, double kaiser_beta,
-                                    double precision, int cheby, int exact_rational)
+                                    double precision, int cheby, int exact_rational, int nb_threads)
 {
     double cutoff = cutoff0? cutoff0 : 0.97;
     double factor= FFMIN(out_rate * cutoff / in_rate, 1.0);
@@ -270,8 +306,22 @@ static ResampleContext *resample_init(ResampleContext *c, int out_rate, int in_r
 
     swri_resample_dsp_init(c);
 
+    avpriv_slicethread_free(&c->slicethread);
+    c->nb_threads = 1;
+    if (nb_threads != 1) {
+        int ret = avpriv_slicethread_create(&c->slicethread, c, resample_worker,
+                                            NULL, nb_threads);
+        if (ret == AVERROR(ENOSYS) || ret == 1)
+            avpriv_slicethread_free(&c->slicethread);
+        else if (ret < 0)
+            goto error;
+        else
+            c->nb_threads = ret;
+    }
+
     return c;
 error:
+    avpriv_slicethread_free(&c->slicethread);
     av_freep(&c->filter_bank);
     av_free(c);
     return NULL;
@@ -347,7 +397,6 @@ static int set_compensation(ResampleContext *c, int sample_delta, int compensati
 }
 
 static int multiple_resample(ResampleContext *c, AudioData *dst, int dst_size, AudioData *src, int src_size, int *consumed){
-    int i;
     int64_t max_src_size = (INT64_MAX/2 / c->phase_count) / c->src_incr;
 
     if (c->compensation_distance)
@@ -363,33 +412,34 @@ static int multiple_resample(ResampleContext *c, AudioData *dst, int dst_size, A
 
         dst_size = FFMAX(FFMIN(dst_size, new_size), 0);
         if (dst_size > 0) {
-            for (i = 0; i < dst->ch_count; i++) {
-                c->dsp.resample_one(dst->ch[i], src->ch[i], dst_size, index2, incr);
-                if (i+1 == dst->ch_count) {
-                    c->index += dst_size * c->dst_incr_div;
-                    c->index += (c->frac + dst_size * (int64_t)c->dst_incr_mod) / c->src_incr;
-                    av_assert2(c->index >= 0);
-                    *consumed = c->index;
-                    c->frac   = (c->frac + dst_size * (int64_t)c->dst_incr_mod) % c->src_incr;
-                    c->index = 0;
-                }
-            }
+            c->job.func   = NULL;
+            c->job.index2 = index2;
+            c->job.incr   = incr;
+            resample_channels(c, dst, src, dst_size);
+
+            c->index += dst_size * c->dst_incr_div;
+            c->index += (c->frac + dst_size * (int64_t)c->dst_incr_mod) / c->src_incr;
+            av_assert2(c->index >= 0);
+            *consumed = c->index;
+            c->frac   = (c->frac + dst_size * (int64_t)c->dst_incr_mod) % c->src_incr;
+            c->index = 0;
         }
     } else {
         int64_t end_index = (1LL + src_size - c->filter_length) * c->phase_count;
         int64_t delta_frac = (end_index - c->index) * c->src_incr - c->frac;
         int delta_n = (delta_frac + c->dst_incr - 1) / c->dst_incr;
-        int (*resample_func)(struct ResampleContext *c, void *dst,
-                             const void *src, int n, int update_ctx);
 
         dst_size = FFMAX(FFMIN(dst_size, delta_n), 0);
         if (dst_size > 0) {
             /* resample_linear and resample_common should have same behavior
              * when frac and dst_incr_mod are zero */
-            resample_func = (c->linear && (c->frac || c->dst_incr_mod)) ?
-                            c->dsp.resample_linear : c->dsp.resample_common;
-            for (i = 0; i < dst->ch_count; i++)
-                *consumed = resample_func(c, dst->ch[i], src->ch[i], dst_size, i+1 == dst->ch_count);
+            c->job.func = (c->linear && (c->frac || c->dst_incr_mod)) ?
+                          c->dsp.resample_linear : c->dsp.resample_common;
+            resample_channels(c, dst, src, dst_size);
+
+            *consumed = c->job.consumed;
+            c->index  = c->job.index;
+            c->frac   = c->job.frac;
         }
     }
 
@@ -24,6 +24,7 @@
 
 #include "libavutil/log.h"
 #include "libavutil/samplefmt.h"
+#include "libavutil/slicethread.h"
 
 #include "swresample_internal.h"
 
@@ -58,6 +59,17 @@ typedef struct ResampleContext {
         int (*resample_linear)(struct ResampleContext *c, void *dst,
                                const void *src, int n, int update_ctx);
     } dsp;
+
+    AVSliceThread *slicethread;
+    int nb_threads;
+    struct {
+        AudioData *dst, *src;
+        int n;
+        int64_t index2, incr;          ///< resample_one() position and increment
+        int (*func)(struct ResampleContext *c, void *dst,
+                    const void *src, int n, int update_ctx);
+        int consumed, index, frac;     ///< state after the last channel
+    } job;
 } ResampleContext;
 
 void swri_resample_dsp_init(ResampleContext *c);
@@ -1201,6 +1201,124 @@ int sws_scale_frame(struct SwsContext *c, AVFrame *dst, const AVFrame *src)
     return ret;
 }
 
+typedef struct SwsMultiJob {
+    SwsContext    *c;
+    AVFrame       *dst;
+    const AVFrame *src;
+    int            level;
+    int            err;
+} SwsMultiJob;
+
+/* Like sws_scale_frame(), but without slice threading, for outputs that are
+ * already scaled concurrently. */
+static int scale_frame_single_thread(SwsContext *c, AVFrame *dst, const AVFrame *src)
+{
+    int ret;
+
+    if (!c->slicethread)
+        return sws_scale_frame(c, dst, src);
+
+    ret = sws_frame_start(c, dst, src);
+    if (ret < 0)
+        return ret;
+
+    c->dst_slice_start  = 0;
+    c->dst_slice_height = dst->height;
+    ff_sws_slice_worker(c, 0, 0, 1, 1);
+    ret = c->slice_err[0];
+    c->slice_err[0] = 0;
+
+    sws_frame_end(c);
+
+    return ret;
+}
+
+static void multi_worker(void *priv, int jobnr, int threadnr,
+                         int nb_jobs, int nb_threads)
+{
+    SwsContext *c = priv;
+    SwsMultiJob *job = &c->multi_jobs[c->multi_first + jobnr];
+
+    job->err = nb_jobs > 1 ? scale_frame_single_thread(job->c, job->dst, job->src)
+                           : sws_scale_frame(job->c, job->dst, job->src);
+}
+
+int sws_scale_frame_multi(struct SwsContext **c, AVFrame **dst,
+                          const int *src_idx, int nb_dst, const AVFrame *src)
+{
+    SwsContext *c0 = c[0];
+    SwsMultiJob *jobs, *sorted;
+    int max_level = 0, ret;
+
+    if (nb_dst <= 0)
+        return AVERROR(EINVAL);
+
+    jobs = av_fast_realloc(c0->multi_jobs, &c0->multi_jobs_size,
+                           2 * nb_dst * sizeof(*jobs));
+    if (!jobs)
+        return AVERROR(ENOMEM);
+    c0->multi_jobs = jobs;
+
+    for (int i = 0; i < nb_dst; i++) {
+        int idx = src_idx ? src_idx[i] : -1;
+
+        for (int j = 0; j < i; j++) {
+            if (c[j] == c[i] || dst[j] == dst[i]) {
+                av_log(c0, AV_LOG_ERROR, "Output %d duplicates output %d\n", i, j);
+                return AVERROR(EINVAL);
+            }
+        }
+        if (idx < -1 || idx >= i) {
+            av_log(c0, AV_LOG_ERROR, "Invalid source %d for output %d\n", idx, i);
+            return AVERROR(EINVAL);
+        }
+
+        jobs[i].c     = c[i];
+        jobs[i].dst   = dst[i];
+        jobs[i].src   = idx < 0 ? src : dst[idx];
+        jobs[i].level = idx < 0 ? 0 : jobs[idx].level + 1;
+        jobs[i].err   = 0;
+        max_level = FFMAX(max_level, jobs[i].level);
+    }
+
+    /* Group the outputs by level; outputs of one level only depend on
+     * outputs of lower levels, so they are scaled concurrently. */
+    sorted = jobs + nb_dst;
+    for (int level = 0, n = 0; level <= max_level; level++)
+        for (int i = 0; i < nb_dst; i++)
+            if (jobs[i].level == level)
+                sorted[n++] = jobs[i];
+
+    if (c0->nb_threads > 1 && nb_dst > 1 && !c0->multi_thread) {
+        ret = avpriv_slicethread_create(&c0->multi_thread, c0, multi_worker,
+                                        NULL, FFMIN(c0->nb_threads, nb_dst));
+        if (ret < 0 && ret != AVERROR(ENOSYS))
+            return ret;
+    }
+
+    for (int first = 0; first < nb_dst;) {
+        int nb_jobs = 1;
+
+        while (first + nb_jobs < nb_dst &&
+               sorted[first + nb_jobs].level == sorted[first].level)
+            nb_jobs++;
+
+        c0->multi_first = nb_dst + first;
+        if (c0->multi_thread && nb_jobs > 1)
+            avpriv_slicethread_execute(c0->multi_thread, nb_jobs, 0);
+        else
+            for (int i = 0; i < nb_jobs; i++)
+                multi_worker(c0, i, 0, nb_jobs, 1);
+
+        for (int i = 0; i < nb_jobs; i++)
+            if (sorted[first + i].err < 0)
+                return sorted[first + i].err;
+        first += nb_jobs;
+    }
+
+    return 0;
+}
+
 /**
  * swscale wrapper, so we don't need to export the SwsContext.
  * Assumes planar YUV to be in YUV order instead of YVU.
@@ -267,6 +267,37 @@ int sws_scale(struct SwsContext *c, const uint8_t *const srcSlice[],
  */
 int sws_scale_frame(struct SwsContext *c, AVFrame *dst, const AVFrame *src);
 
+/**
+ * Scale one source frame into several destination frames, e.g. for the
+ * renditions of an adaptive bitrate ladder.
+ *
+ * This is equivalent to calling sws_scale_frame(c[i], dst[i], input) for
+ * each output in order, where input is src or, if src_idx[i] is not negative,
+ * the earlier destination frame dst[src_idx[i]]. The latter allows cascading
+ * outputs, e.g. scaling a 2160p source to 1080p and that result to 540p, or
+ * unpacking or range converting the source once with a same-size context
+ * and scaling all other outputs from its result.
+ *
+ * Outputs which do not depend on each other are scaled concurrently, using
+ * up to as many threads as the "threads" option of c[0] specifies. Each of
+ * them is then scaled on a single thread, the "threads" option of the other
+ * contexts only applies to outputs that are scaled on their own.
+ *
+ * @param c       array of nb_dst distinct scaling contexts; the source
+ *                dimensions and format of c[i] must match its input frame
+ * @param dst     array of nb_dst distinct destination frames, see
+ *                sws_frame_start() for details
+ * @param src_idx NULL, in which case all outputs are scaled from src, or an
+ *                array of nb_dst indices; src_idx[i] is -1 to scale output
+ *                i from src, or the index of an earlier output, lower than i
+ * @param nb_dst  number of outputs
+ * @param src     the source frame
+ *
+ * @return 0 on success, a negative AVERROR code on failure
+ */
+int sws_scale_frame_multi(struct SwsContext **c, AVFrame **dst,
+                          const int *src_idx, int nb_dst, const AVFrame *src);
+
 /**
  * Initialize the scaling process for a given pair of source/destination frames.
  * Must be called before any calls to sws_send_slice() and sws_receive_slice().
@@ -682,6 +682,12 @@ typedef struct SwsContext {
     atomic_int   data_unaligned_warned;
 
     Half2FloatTables *h2f_tables;
+
+    // state of sws_scale_frame_multi() calls using this as first context
+    AVSliceThread      *multi_thread;
+    struct SwsMultiJob *multi_jobs;
+    unsigned int        multi_jobs_size;
+    int                 multi_first;
 } SwsContext;
 //FIXME check init (where 0)
 
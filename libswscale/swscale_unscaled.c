@@ -365,6 +365,128 @@ static int planar8ToP01xleWrapper(SwsContext *c, const uint8_t *src[],
 
 #undef output_pixel
 
+/* semi-planar MSB-aligned (P01x/P21x/P41x) to planar YUV of the same depth
+ * and chroma subsampling, both in native endianness */
+static int p01xToPlanarWrapper(SwsContext *c, const uint8_t *src8[],
+                               int srcStride[], int srcSliceY,
+                               int srcSliceH, uint8_t *dstParam8[],
+                               int dstStride[])
+{
+    const AVPixFmtDescriptor *src_format = av_pix_fmt_desc_get(c->srcFormat);
+    const int vsub  = src_format->log2_chroma_h;
+    const int chrW  = AV_CEIL_RSHIFT(c->srcW, src_format->log2_chroma_w);
+    const int shift = src_format->comp[0].shift;
+    const uint16_t *srcY  = (const uint16_t *)src8[0];
+    const uint16_t *srcUV = (const uint16_t *)src8[1];
+    uint16_t *dstY = (uint16_t *)(dstParam8[0] + dstStride[0] * srcSliceY);
+    uint16_t *dstU = (uint16_t *)(dstParam8[1] + dstStride[1] * (srcSliceY >> vsub));
+    uint16_t *dstV = (uint16_t *)(dstParam8[2] + dstStride[2] * (srcSliceY >> vsub));
+
+    av_assert0(!(srcStride[0] % 2 || srcStride[1] % 2 ||
+                 dstStride[0] % 2 || dstStride[1] % 2 || dstStride[2] % 2));
+
+    for (int y = 0; y < srcSliceH; y++) {
+        for (int x = 0; x < c->srcW; x++)
+            dstY[x] = srcY[x] >> shift;
+        srcY += srcStride[0] / 2;
+        dstY += dstStride[0] / 2;
+
+        if (!(y & ((1 << vsub) - 1))) {
+            for (int x = 0; x < chrW; x++) {
+                dstU[x] = srcUV[2 * x    ] >> shift;
+                dstV[x] = srcUV[2 * x + 1] >> shift;
+            }
+            srcUV += srcStride[1] / 2;
+            dstU  += dstStride[1] / 2;
+            dstV  += dstStride[2] / 2;
+        }
+    }
+
+    return srcSliceH;
+}
+
+/* planar YUV 4:2:2 and 4:4:4 to P21x/P41x of the same depth */
+static int planarToP2x4xWrapper(SwsContext *c, const uint8_t *src8[],
+                                int srcStride[], int srcSliceY,
+                                int srcSliceH, uint8_t *dstParam8[],
+                                int dstStride[])
+{
+    const AVPixFmtDescriptor *dst_format = av_pix_fmt_desc_get(c->dstFormat);
+    const int chrW  = AV_CEIL_RSHIFT(c->srcW, dst_format->log2_chroma_w);
+    const int shift = dst_format->comp[0].shift;
+    const uint16_t *srcY = (const uint16_t *)src8[0];
+    const uint16_t *srcU = (const uint16_t *)src8[1];
+    const uint16_t *srcV = (const uint16_t *)src8[2];
+    uint16_t *dstY  = (uint16_t *)(dstParam8[0] + dstStride[0] * srcSliceY);
+    uint16_t *dstUV = (uint16_t *)(dstParam8[1] + dstStride[1] * srcSliceY);
+
+    av_assert0(!(srcStride[0] % 2 || srcStride[1] % 2 || srcStride[2] % 2 ||
+                 dstStride[0] % 2 || dstStride[1] % 2));
+
+    for (int y = 0; y < srcSliceH; y++) {
+        for (int x = 0; x < c->srcW; x++)
+            dstY[x] = srcY[x] << shift;
+        for (int x = 0; x < chrW; x++) {
+            dstUV[2 * x    ] = srcU[x] << shift;
+            dstUV[2 * x + 1] = srcV[x] << shift;
+        }
+        srcY  += srcStride[0] / 2;
+        srcU  += srcStride[1] / 2;
+        srcV  += srcStride[2] / 2;
+        dstY  += dstStride[0] / 2;
+        dstUV += dstStride[1] / 2;
+    }
+
+    return srcSliceH;
+}
+
+/* planar float RGB(A) to planar 16-bit RGB(A), both in native endianness */
+static int planarRgbf32ToRgb16Wrapper(SwsContext *c, const uint8_t *src[],
+                                      int srcStride[], int srcSliceY,
+                                      int srcSliceH, uint8_t *dst[],
+                                      int dstStride[])
+{
+    const int planes = isALPHA(c->srcFormat) ? 4 : 3;
+
+    for (int p = 0; p < planes; p++) {
+        const float *srcp = (const float *)src[p];
+        uint16_t *dstp = (uint16_t *)(dst[p] + dstStride[p] * srcSliceY);
+
+        for (int y = 0; y < srcSliceH; y++) {
+            for (int x = 0; x < c->srcW; x++)
+                dstp[x] = lrintf(av_clipf(65535.0f * srcp[x], 0.0f, 65535.0f));
+            srcp += srcStride[p] / 4;
+            dstp += dstStride[p] / 2;
+        }
+    }
+
+    return srcSliceH;
+}
+
+/* planar 16-bit RGB(A) to planar float RGB(A), both in native endianness */
+static int planarRgb16ToRgbf32Wrapper(SwsContext *c, const uint8_t *src[],
+                                      int srcStride[], int srcSliceY,
+                                      int srcSliceH, uint8_t *dst[],
+                                      int dstStride[])
+{
+    const int planes = isALPHA(c->srcFormat) ? 4 : 3;
+    const float float_mult = 1.0f / 65535.0f;
+
+    for (int p = 0; p < planes; p++) {
+        const uint16_t *srcp = (const uint16_t *)src[p];
+        float *dstp = (float *)(dst[p] + dstStride[p] * srcSliceY);
+
+        for (int y = 0; y < srcSliceH; y++) {
+            for (int x = 0; x < c->srcW; x++)
+                dstp[x] = float_mult * srcp[x];
+            srcp += srcStride[p] / 2;
+            dstp += dstStride[p] / 4;
+        }
+    }
+
+    return srcSliceH;
+}
+
 static int planarToYuy2Wrapper(SwsContext *c, const uint8_t *src[],
                                int srcStride[], int srcSliceY, int srcSliceH,
                                uint8_t *dstParam[], int dstStride[])
@@ -2061,6 +2183,43 @@ void ff_get_unscaled_swscale(SwsContext *c)
         (dstFormat == AV_PIX_FMT_P010 || dstFormat == AV_PIX_FMT_P016)) {
         c->convert_unscaled = planarToP01xWrapper;
     }
+    /* p01x_to_yuv4xxp1x */
+    if ((srcFormat == AV_PIX_FMT_P010 && dstFormat == AV_PIX_FMT_YUV420P10) ||
+        (srcFormat == AV_PIX_FMT_P012 && dstFormat == AV_PIX_FMT_YUV420P12) ||
+        (srcFormat == AV_PIX_FMT_P016 && dstFormat == AV_PIX_FMT_YUV420P16) ||
+        (srcFormat == AV_PIX_FMT_P210 && dstFormat == AV_PIX_FMT_YUV422P10) ||
+        (srcFormat == AV_PIX_FMT_P212 && dstFormat == AV_PIX_FMT_YUV422P12) ||
+        (srcFormat == AV_PIX_FMT_P216 && dstFormat == AV_PIX_FMT_YUV422P16) ||
+        (srcFormat == AV_PIX_FMT_P410 && dstFormat == AV_PIX_FMT_YUV444P10) ||
+        (srcFormat == AV_PIX_FMT_P412 && dstFormat == AV_PIX_FMT_YUV444P12) ||
+        (srcFormat == AV_PIX_FMT_P416 && dstFormat == AV_PIX_FMT_YUV444P16)) {
+        c->convert_unscaled = p01xToPlanarWrapper;
+    }
+    /* yuv4xxp1x_to_p2x4x */
+    if (((srcFormat == AV_PIX_FMT_YUV422P10 || srcFormat == AV_PIX_FMT_YUVA422P10) &&
+         dstFormat == AV_PIX_FMT_P210) ||
+        ((srcFormat == AV_PIX_FMT_YUV422P12 || srcFormat == AV_PIX_FMT_YUVA422P12) &&
+         dstFormat == AV_PIX_FMT_P212) ||
+        ((srcFormat == AV_PIX_FMT_YUV422P16 || srcFormat == AV_PIX_FMT_YUVA422P16) &&
+         dstFormat == AV_PIX_FMT_P216) ||
+        ((srcFormat == AV_PIX_FMT_YUV444P10 || srcFormat == AV_PIX_FMT_YUVA444P10) &&
+         dstFormat == AV_PIX_FMT_P410) ||
+        ((srcFormat == AV_PIX_FMT_YUV444P12 || srcFormat == AV_PIX_FMT_YUVA444P12) &&
+         dstFormat == AV_PIX_FMT_P412) ||
+        ((srcFormat == AV_PIX_FMT_YUV444P16 || srcFormat == AV_PIX_FMT_YUVA444P16) &&
+         dstFormat == AV_PIX_FMT_P416)) {
+        c->convert_unscaled = planarToP2x4xWrapper;
+    }
+    /* gbr(a)pf32_to_gbr(a)p16 */
+    if ((srcFormat == AV_PIX_FMT_GBRPF32  && dstFormat == AV_PIX_FMT_GBRP16) ||
+        (srcFormat == AV_PIX_FMT_GBRAPF32 && dstFormat == AV_PIX_FMT_GBRAP16)) {
+        c->convert_unscaled = planarRgbf32ToRgb16Wrapper;
+    }
+    /* gbr(a)p16_to_gbr(a)pf32 */
+    if ((srcFormat == AV_PIX_FMT_GBRP16  && dstFormat == AV_PIX_FMT_GBRPF32) ||
+        (srcFormat == AV_PIX_FMT_GBRAP16 && dstFormat == AV_PIX_FMT_GBRAPF32)) {
+        c->convert_unscaled = planarRgb16ToRgbf32Wrapper;
+    }
     /* yuv420p_to_p01xle */
     if ((srcFormat == AV_PIX_FMT_YUV420P || srcFormat == AV_PIX_FMT_YUVA420P) &&
         (dstFormat == AV_PIX_FMT_P010LE || dstFormat == AV_PIX_FMT_P016LE)) {
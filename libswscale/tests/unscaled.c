@@ -0,0 +1,261 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Check the unscaled semi-planar <-> planar YUV and float <-> 16-bit
+ * planar RGB converters against the expected component values.
+ */
+
+#include <math.h>
+#include <stdio.h>
+
+#include "libavutil/common.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/lfg.h"
+#include "libavutil/mem.h"
+#include "libavutil/pixdesc.h"
+
+#include "libswscale/swscale.h"
+#include "libswscale/swscale_internal.h"
+
+/* odd sizes to cover the rounded up chroma dimensions */
+#define W 37
+#define H 23
+/* the frame is converted in two slices, the second one starting here */
+#define SLICE_Y 8
+
+static const struct {
+    enum AVPixelFormat src, dst;
+} yuv_pairs[] = {
+    { AV_PIX_FMT_P010,       AV_PIX_FMT_YUV420P10 },
+    { AV_PIX_FMT_P012,       AV_PIX_FMT_YUV420P12 },
+    { AV_PIX_FMT_P016,       AV_PIX_FMT_YUV420P16 },
+    { AV_PIX_FMT_P210,       AV_PIX_FMT_YUV422P10 },
+    { AV_PIX_FMT_P212,       AV_PIX_FMT_YUV422P12 },
+    { AV_PIX_FMT_P216,       AV_PIX_FMT_YUV422P16 },
+    { AV_PIX_FMT_P410,       AV_PIX_FMT_YUV444P10 },
+    { AV_PIX_FMT_P412,       AV_PIX_FMT_YUV444P12 },
+    { AV_PIX_FMT_P416,       AV_PIX_FMT_YUV444P16 },
+    { AV_PIX_FMT_YUV422P10,  AV_PIX_FMT_P210 },
+    { AV_PIX_FMT_YUV422P12,  AV_PIX_FMT_P212 },
+    { AV_PIX_FMT_YUV422P16,  AV_PIX_FMT_P216 },
+    { AV_PIX_FMT_YUVA422P10, AV_PIX_FMT_P210 },
+    { AV_PIX_FMT_YUVA422P16, AV_PIX_FMT_P216 },
+    { AV_PIX_FMT_YUV444P10,  AV_PIX_FMT_P410 },
+    { AV_PIX_FMT_YUV444P12,  AV_PIX_FMT_P412 },
+    { AV_PIX_FMT_YUV444P16,  AV_PIX_FMT_P416 },
+    { AV_PIX_FMT_YUVA444P10, AV_PIX_FMT_P410 },
+    { AV_PIX_FMT_YUVA444P16, AV_PIX_FMT_P416 },
+};
+
+static const struct {
+    enum AVPixelFormat f32, u16;
+} rgb_pairs[] = {
+    { AV_PIX_FMT_GBRPF32,  AV_PIX_FMT_GBRP16 },
+    { AV_PIX_FMT_GBRAPF32, AV_PIX_FMT_GBRAP16 },
+};
+
+static AVLFG lfg;
+
+static int convert(enum AVPixelFormat src_fmt, uint8_t *src[4], int src_stride[4],
+                   enum AVPixelFormat dst_fmt, uint8_t *dst[4], int dst_stride[4])
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(src_fmt);
+    SwsContext *c = sws_getContext(W, H, src_fmt, W, H, dst_fmt,
+                                   SWS_POINT, NULL, NULL, NULL);
+    const uint8_t *slice[4];
+    int ret = 0;
+
+    if (!c)
+        return -1;
+    if (!c->convert_unscaled) {
+        fprintf(stderr, "%s -> %s: no unscaled converter\n",
+                av_get_pix_fmt_name(src_fmt), av_get_pix_fmt_name(dst_fmt));
+        ret = -1;
+        goto end;
+    }
+
+    for (int i = 0; i < 4; i++)
+        slice[i] = src[i];
+    sws_scale(c, slice, src_stride, 0, SLICE_Y, dst, dst_stride);
+
+    for (int i = 0; i < 4; i++) {
+        int vsub = (i == 1 || i == 2) ? desc->log2_chroma_h : 0;
+        slice[i] = src[i] ? src[i] + (SLICE_Y >> vsub) * src_stride[i] : NULL;
+    }
+    sws_scale(c, slice, src_stride, SLICE_Y, H - SLICE_Y, dst, dst_stride);
+
+end:
+    sws_freeContext(c);
+    return ret;
+}
+
+static int test_yuv(enum AVPixelFormat src_fmt, enum AVPixelFormat dst_fmt)
+{
+    const AVPixFmtDescriptor *src_desc = av_pix_fmt_desc_get(src_fmt);
+    const AVPixFmtDescriptor *dst_desc = av_pix_fmt_desc_get(dst_fmt);
+    uint8_t *src[4] = { NULL }, *dst[4] = { NULL };
+    int src_stride[4], dst_stride[4];
+    uint16_t line_src[W], line_dst[W];
+    int ret = -1;
+
+    if (av_image_alloc(src, src_stride, W, H, src_fmt, 16) < 0 ||
+        av_image_alloc(dst, dst_stride, W, H, dst_fmt, 16) < 0)
+        goto end;
+
+    for (int c = 0; c < src_desc->nb_components; c++) {
+        int chroma = c == 1 || c == 2;
+        int w = chroma ? AV_CEIL_RSHIFT(W, src_desc->log2_chroma_w) : W;
+        int h = chroma ? AV_CEIL_RSHIFT(H, src_desc->log2_chroma_h) : H;
+        int mask = (1 << src_desc->comp[c].depth) - 1;
+
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++)
+                line_src[x] = av_lfg_get(&lfg) & mask;
+            av_write_image_line2(line_src, src, src_stride, src_desc,
+                                 0, y, c, w, 2);
+        }
+    }
+
+    if (convert(src_fmt, src, src_stride, dst_fmt, dst, dst_stride) < 0)
+        goto end;
+
+    ret = 0;
+    for (int c = 0; c < dst_desc->nb_components; c++) {
+        int chroma = c == 1 || c == 2;
+        int w = chroma ? AV_CEIL_RSHIFT(W, dst_desc->log2_chroma_w) : W;
+        int h = chroma ? AV_CEIL_RSHIFT(H, dst_desc->log2_chroma_h) : H;
+
+        for (int y = 0; y < h; y++) {
+            av_read_image_line2(line_src, (const uint8_t **)src, src_stride,
+                                src_desc, 0, y, c, w, 0, 2);
+            av_read_image_line2(line_dst, (const uint8_t **)dst, dst_stride,
+                                dst_desc, 0, y, c, w, 0, 2);
+            for (int x = 0; x < w; x++) {
+                if (line_src[x] != line_dst[x]) {
+                    fprintf(stderr, "%s -> %s: component %d at %d,%d: %d != %d\n",
+                            src_desc->name, dst_desc->name, c, x, y,
+                            line_dst[x], line_src[x]);
+                    ret = -1;
+                    goto end;
+                }
+            }
+        }
+    }
+
+end:
+    av_freep(&src[0]);
+    av_freep(&dst[0]);
+    return ret;
+}
+
+static int test_rgb(enum AVPixelFormat f32_fmt, enum AVPixelFormat u16_fmt)
+{
+    const int planes = av_pix_fmt_count_planes(f32_fmt);
+    uint8_t *f32[4] = { NULL }, *u16[4] = { NULL }, *back[4] = { NULL };
+    int f32_stride[4], u16_stride[4], back_stride[4];
+    int ret = -1;
+
+    if (av_image_alloc(f32,  f32_stride,  W, H, f32_fmt, 16) < 0 ||
+        av_image_alloc(u16,  u16_stride,  W, H, u16_fmt, 16) < 0 ||
+        av_image_alloc(back, back_stride, W, H, u16_fmt, 16) < 0)
+        goto end;
+
+    /* float to 16-bit, including out of range values that must be clipped */
+    for (int p = 0; p < planes; p++) {
+        for (int y = 0; y < H; y++) {
+            float *line = (float *)(f32[p] + y * f32_stride[p]);
+            for (int x = 0; x < W; x++)
+                line[x] = (av_lfg_get(&lfg) % 140001) / 120000.0f - 0.1f;
+        }
+    }
+
+    if (convert(f32_fmt, f32, f32_stride, u16_fmt, u16, u16_stride) < 0)
+        goto end;
+
+    for (int p = 0; p < planes; p++) {
+        for (int y = 0; y < H; y++) {
+            const float *in = (const float *)(f32[p] + y * f32_stride[p]);
+            const uint16_t *out = (const uint16_t *)(u16[p] + y * u16_stride[p]);
+            for (int x = 0; x < W; x++) {
+                int expected = lrintf(av_clipf(65535.0f * in[x], 0.0f, 65535.0f));
+                if (out[x] != expected) {
+                    fprintf(stderr, "%s -> %s: plane %d at %d,%d: %d != %d (%f)\n",
+                            av_get_pix_fmt_name(f32_fmt), av_get_pix_fmt_name(u16_fmt),
+                            p, x, y, out[x], expected, in[x]);
+                    goto end;
+                }
+            }
+        }
+    }
+
+    /* 16-bit to float and back must be lossless */
+    for (int p = 0; p < planes; p++) {
+        for (int y = 0; y < H; y++) {
+            uint16_t *line = (uint16_t *)(u16[p] + y * u16_stride[p]);
+            for (int x = 0; x < W; x++)
+                line[x] = av_lfg_get(&lfg);
+            line[0] = 0;
+            line[1] = 65535;
+        }
+    }
+
+    if (convert(u16_fmt, u16, u16_stride, f32_fmt, f32, f32_stride) < 0 ||
+        convert(f32_fmt, f32, f32_stride, u16_fmt, back, back_stride) < 0)
+        goto end;
+
+    for (int p = 0; p < planes; p++) {
+        for (int y = 0; y < H; y++) {
+            const uint16_t *in  = (const uint16_t *)(u16[p]  + y * u16_stride[p]);
+            const float    *mid = (const float    *)(f32[p]  + y * f32_stride[p]);
+            const uint16_t *out = (const uint16_t *)(back[p] + y * back_stride[p]);
+            for (int x = 0; x < W; x++) {
+                if (fabs(mid[x] - in[x] / 65535.0) > 1e-6 || out[x] != in[x]) {
+                    fprintf(stderr, "%s -> %s -> %s: plane %d at %d,%d: %d -> %f -> %d\n",
+                            av_get_pix_fmt_name(u16_fmt), av_get_pix_fmt_name(f32_fmt),
+                            av_get_pix_fmt_name(u16_fmt), p, x, y, in[x], mid[x], out[x]);
+                    goto end;
+                }
+            }
+        }
+    }
+    ret = 0;
+
+end:
+    av_freep(&f32[0]);
+    av_freep(&u16[0]);
+    av_freep(&back[0]);
+    return ret;
+}
+
+int main(void)
+{
+    int ret = 0;
+
+    av_lfg_init(&lfg, 1);
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(yuv_pairs); i++)
+        if (test_yuv(yuv_pairs[i].src, yuv_pairs[i].dst) < 0)
+            ret = 1;
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(rgb_pairs); i++)
+        if (test_rgb(rgb_pairs[i].f32, rgb_pairs[i].u16) < 0)
+            ret = 1;
+
+    return ret;
+}
@@ -2441,6 +2441,8 @@ void sws_freeContext(SwsContext *c)
     av_freep(&c->slice_err);
 
     avpriv_slicethread_free(&c->slicethread);
+    avpriv_slicethread_free(&c->multi_thread);
+    av_freep(&c->multi_jobs);
 
     for (i = 0; i < 4; i++)
         av_freep(&c->dither_error[i]);
@@ -20,6 +20,7 @@
 
 #include <string.h>
 #include "checkasm.h"
+#include "libavcodec/defs.h"
 #include "libavcodec/h264dsp.h"
 #include "libavcodec/h264data.h"
 #include "libavcodec/h264_parse.h"
@@ -449,6 +450,40 @@ static void check_loop_filter_intra(void)
     }
 }
 
+static void check_startcode(void)
+{
+    LOCAL_ALIGNED_16(uint8_t, buf, [256 + AV_INPUT_BUFFER_PADDING_SIZE]);
+    H264DSPContext h;
+    int i, j;
+
+    declare_func(int, const uint8_t *buf, int size);
+
+    ff_h264dsp_init(&h, 8, 1);
+    if (check_func(h.startcode_find_candidate, "startcode_find_candidate")) {
+        for (i = 0; i < 64; i++) {
+            int size = rnd() % 257;
+            int ref, new;
+
+            for (j = 0; j < 256; j++)
+                buf[j] = rnd() | 1;
+            memset(buf + 256, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+            if (i & 1)
+                buf[rnd() % 256] = 0;
+
+            /* the C version may return any value >= size on failure */
+            ref = call_ref(buf, size);
+            new = call_new(buf, size);
+            if (FFMIN(ref, size) != FFMIN(new, size)) {
+                fprintf(stderr, "size %d: %d != %d\n", size, ref, new);
+                fail();
+            }
+        }
+        for (j = 0; j < 256; j++)
+            buf[j] = rnd() | 1;
+        bench_new(buf, 256);
+    }
+}
+
 void checkasm_check_h264dsp(void)
 {
     check_idct();
@@ -460,4 +495,7 @@ void checkasm_check_h264dsp(void)
 
     check_loop_filter_intra();
     report("loop_filter_intra");
+
+    check_startcode();
+    report("startcode");
 }
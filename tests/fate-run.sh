@@ -617,6 +617,25 @@ concat(){
     fi
 }
 
+background_write(){
+    # Run the muxer once as is and once with the options in $1 in place of
+    # %b, each writing into its own directory (%o), print the checksums of
+    # the files and fail unless both runs wrote the same files.
+    bg_opts=$1
+    shift
+    syncdir="${outdir}/${test}.sync"
+    bgdir="${outdir}/${test}.bg"
+    mkdir -p "$syncdir" "$bgdir"
+    ffmpeg -y $(echo "$@" | sed "s#%b##;s#%o/#$(target_path $syncdir)/#g") || return
+    ffmpeg -y $(echo "$@" | sed "s#%b#$bg_opts#;s#%o/#$(target_path $bgdir)/#g") || return
+    for f in $(ls "$syncdir"); do
+        test "$keep" -ge 1 || cleanfiles="$cleanfiles $syncdir/$f $bgdir/$f"
+        (cd "$syncdir" && do_md5sum $f)
+        cmp -s "$syncdir/$f" "$bgdir/$f" || { echo "$f differs with $bg_opts"; return 1; }
+    done
+    test "$(ls "$syncdir")" = "$(ls "$bgdir")" || { echo "$bg_opts wrote other files"; return 1; }
+}
+
 venc_data(){
     file=$1
     stream=$2
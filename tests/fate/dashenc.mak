@@ -0,0 +1,5 @@
+FATE_DASHENC_FFMPEG-$(call ENCMUX, MPEG4, DASH, MP4_MUXER TESTSRC2_FILTER LAVFI_INDEV FILE_PROTOCOL) += fate-dash-async-io
+fate-dash-async-io: CMD = background_write "-async_io 1" -f lavfi -i testsrc2=s=160x120:d=3:r=10 -c:v mpeg4 -g 5 -flags +bitexact -fflags +bitexact -f dash %b -seg_duration 1 %o/out.mpd
+
+FATE_FFMPEG += $(FATE_DASHENC_FFMPEG-yes)
+fate-dashenc: $(FATE_DASHENC_FFMPEG-yes)
@@ -128,6 +128,25 @@ FATE_FILTER-$(call FILTERFRAMECRC, MINTERPOLATE TESTSRC2) += fate-filter-minterp
 fate-filter-minterpolate-up: CMD = framecrc -lavfi testsrc2=r=2:d=10,minterpolate=fps=10 -t 1
 fate-filter-minterpolate-down: CMD = framecrc -lavfi testsrc2=r=2:d=10,minterpolate=fps=1 -t 1
 
+# the scale filter chains must give the same output as scale_multi
+SCALE_MULTI_FLAGS = flags=bicubic+accurate_rnd+bitexact
+FATE_FILTER-$(call FILTERFRAMECRC, SCALE_MULTI SCALE SPLIT TESTSRC2) += fate-filter-scale_multi fate-filter-scale_multi-chain
+fate-filter-scale_multi: CMD = framecrc -filter_complex "testsrc2=s=320x240:d=1:r=10,scale_multi=sizes=160x120|96x72|40x30:$(SCALE_MULTI_FLAGS)[a][b][c]" -map "[a]" -map "[b]" -map "[c]"
+fate-filter-scale_multi-chain: CMD = framecrc -filter_complex "testsrc2=s=320x240:d=1:r=10,split=3[i0][i1][i2];[i0]scale=160:120:$(SCALE_MULTI_FLAGS)[a];[i1]scale=96:72:$(SCALE_MULTI_FLAGS)[b];[i2]scale=40:30:$(SCALE_MULTI_FLAGS)[c]" -map "[a]" -map "[b]" -map "[c]"
+fate-filter-scale_multi-chain: REF = $(SRC_PATH)/tests/ref/fate/filter-scale_multi
+
+FATE_FILTER-$(call FILTERFRAMECRC, SCALE_MULTI SCALE SPLIT TESTSRC2) += fate-filter-scale_multi-cascade fate-filter-scale_multi-cascade-chain
+fate-filter-scale_multi-cascade: CMD = framecrc -filter_complex "testsrc2=s=320x240:d=1:r=10,scale_multi=sizes=160x120|96x72|40x30:cascade=1:$(SCALE_MULTI_FLAGS)[a][b][c]" -map "[a]" -map "[b]" -map "[c]"
+fate-filter-scale_multi-cascade-chain: CMD = framecrc -filter_complex "testsrc2=s=320x240:d=1:r=10,split=2[i0][i1];[i0]scale=160:120:$(SCALE_MULTI_FLAGS)[a];[i1]scale=96:72:$(SCALE_MULTI_FLAGS),split=2[b][t];[t]scale=40:30:$(SCALE_MULTI_FLAGS)[c]" -map "[a]" -map "[b]" -map "[c]"
+fate-filter-scale_multi-cascade-chain: REF = $(SRC_PATH)/tests/ref/fate/filter-scale_multi-cascade
+
+# the bitmap font gives the same glyphs with any FreeType version
+DRAWTEXT_GRAPH = testsrc2=s=320x240:d=1:r=10,format=yuv420p,drawtext=fontfile=$(SRC_PATH)/tests/vga16.bdf:text='Frame.%{frame_num}':x=10+t*37:y=20+t*13:fontcolor=yellow@0.8:box=1:boxcolor=black@0.5:boxborderw=5|9:shadowx=3:shadowy=2:shadowcolor=red@0.6,drawtext=fontfile=$(SRC_PATH)/tests/vga16.bdf:text='pts.%{pts}':x=w-tw+3-t*40:y=h-th+2:fontcolor=white:shadowx=-2:shadowy=-2
+FATE_FILTER-$(call FILTERFRAMECRC, DRAWTEXT FORMAT TESTSRC2) += fate-filter-drawtext fate-filter-drawtext-threads
+fate-filter-drawtext: CMD = framecrc -filter_threads 1 -lavfi "$(DRAWTEXT_GRAPH)"
+fate-filter-drawtext-threads: CMD = framecrc -filter_threads 4 -lavfi "$(DRAWTEXT_GRAPH)"
+fate-filter-drawtext-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-drawtext
+
 FATE_FILTER_VSYNTH_PGMYUV-$(CONFIG_BOXBLUR_FILTER) += fate-filter-boxblur
 fate-filter-boxblur: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf boxblur=2:1
 
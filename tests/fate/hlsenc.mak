@@ -109,6 +109,23 @@ FATE_HLSENC_PROBE-$(call ALLYES, HLS_DEMUXER EAC3_DEMUXER) += fate-hls-fmp4_ac3
 fate-hls-fmp4_ac3: tests/data/hls_fmp4_ac3.m3u8
 fate-hls-fmp4_ac3: CMD = probeaudiostream $(TARGET_PATH)/tests/data/now_ac3.mp4
 
+tests/data/hls_part_time.m3u8: TAG = GEN
+tests/data/hls_part_time.m3u8: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
+	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin \
+	-f lavfi -i "testsrc2=s=160x120:d=4:r=10" -c:v mpeg4 -g 5 -flags +bitexact -fflags +bitexact -map 0 \
+	-hls_segment_type fmp4 -hls_fmp4_init_filename hls_part_time_init.mp4 -hls_list_size 0 \
+	-hls_time 2 -hls_part_time 0.5 -hls_flags omit_endlist \
+	-hls_segment_filename $(TARGET_PATH)/tests/data/hls_part_time_%d.m4s \
+	$(TARGET_PATH)/tests/data/hls_part_time.m3u8 2>/dev/null
+
+FATE_HLSENC_FFMPEG-$(call ENCMUX, MPEG4, HLS, MP4_MUXER TESTSRC2_FILTER LAVFI_INDEV FILE_PROTOCOL) += fate-hls-part-time
+fate-hls-part-time: tests/data/hls_part_time.m3u8
+fate-hls-part-time: CMD = cat $(TARGET_PATH)/tests/data/hls_part_time.m3u8; for f in init.mp4 0.m4s 1.m4s; do do_md5sum tests/data/hls_part_time_$$f; done
+
+FATE_HLSENC_FFMPEG-$(call ENCMUX, MPEG4, HLS, MPEGTS_MUXER TESTSRC2_FILTER LAVFI_INDEV FILE_PROTOCOL) += fate-hls-async-io
+fate-hls-async-io: CMD = background_write "-async_io 1" -f lavfi -i testsrc2=s=160x120:d=3:r=10 -c:v mpeg4 -g 5 -flags +bitexact -fflags +bitexact -f hls %b -hls_time 1 -hls_list_size 0 -hls_flags +temp_file -hls_segment_filename %o/seg_%d.ts %o/out.m3u8
+
 FATE_SAMPLES_FFMPEG += $(FATE_HLSENC-yes)
 FATE_SAMPLES_FFMPEG_FFPROBE += $(FATE_HLSENC_PROBE-yes)
-fate-hlsenc: $(FATE_HLSENC-yes) $(FATE_HLSENC_PROBE-yes)
+FATE_FFMPEG += $(FATE_HLSENC_FFMPEG-yes)
+fate-hlsenc: $(FATE_HLSENC-yes) $(FATE_HLSENC_PROBE-yes) $(FATE_HLSENC_FFMPEG-yes)
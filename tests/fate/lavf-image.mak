@@ -100,3 +100,12 @@ fate-lavf-monow.xwd: CMD = lavf_image "-pix_fmt monow"
 
 FATE_AVCONV += $(FATE_LAVF_IMAGES)
 fate-lavf-images fate-lavf: $(FATE_LAVF_IMAGES)
+
+# background writing must produce the same files as synchronous writing
+FATE_IMAGE2_WRITER-$(call ENCMUX, PNG, IMAGE2, TESTSRC2_FILTER FORMAT_FILTER LAVFI_INDEV FILE_PROTOCOL) += fate-image2-writer-threads
+fate-image2-writer-threads: CMD = background_write "-writer_threads 2" -f lavfi -i testsrc2=s=64x64:d=1:r=10,format=rgb24 -c:v png -f image2 %b %o/%02d.png
+
+FATE_IMAGE2_WRITER-$(call ENCMUX, PNG, IMAGE2, TESTSRC2_FILTER FORMAT_FILTER LAVFI_INDEV FILE_PROTOCOL) += fate-image2-writer-threads-update
+fate-image2-writer-threads-update: CMD = background_write "-writer_threads 2" -f lavfi -i testsrc2=s=64x64:d=1:r=10,format=rgb24 -c:v png -f image2 %b -update 1 -atomic_writing 1 %o/last.png
+
+FATE_FFMPEG += $(FATE_IMAGE2_WRITER-yes)
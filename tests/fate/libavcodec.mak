@@ -104,6 +104,11 @@ fate-libavcodec-huffman: libavcodec/tests/mjpegenc_huffman$(EXESUF)
 fate-libavcodec-huffman: CMD = run libavcodec/tests/mjpegenc_huffman$(EXESUF)
 fate-libavcodec-huffman: CMP = null
 
+FATE_LIBAVCODEC-$(CONFIG_STARTCODE) += fate-startcode
+fate-startcode: libavcodec/tests/startcode$(EXESUF)
+fate-startcode: CMD = run libavcodec/tests/startcode$(EXESUF)
+fate-startcode: CMP = null
+
 FATE_LIBAVCODEC-yes += fate-libavcodec-htmlsubtitles
 fate-libavcodec-htmlsubtitles: libavcodec/tests/htmlsubtitles$(EXESUF)
 fate-libavcodec-htmlsubtitles: CMD = run libavcodec/tests/htmlsubtitles$(EXESUF)
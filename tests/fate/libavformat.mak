@@ -1,3 +1,7 @@
+FATE_LIBAVFORMAT += fate-aviobuf
+fate-aviobuf: libavformat/tests/aviobuf$(EXESUF)
+fate-aviobuf: CMD = run libavformat/tests/aviobuf$(EXESUF)
+
 #FATE_LIBAVFORMAT-$(HAVE_PTHREADS) += fate-async
 #fate-async: libavformat/tests/async$(EXESUF)
 #fate-async: CMD = run libavformat/tests/async
@@ -53,3 +53,14 @@ FATE_SEGMENT-$(call ALLYES, AAC_DEMUXER AAC_ADTSTOASC_BSF MATROSKA_MUXER MATROSK
 FATE_SAMPLES_FFMPEG += $(FATE_SEGMENT-yes)
 
 fate-segment: $(FATE_SEGMENT-yes)
+
+# background writing must produce the same files as synchronous writing
+FATE_SEGMENT_WRITER-$(call ENCMUX, MPEG4, SEGMENT, MPEGTS_MUXER TESTSRC2_FILTER LAVFI_INDEV FILE_PROTOCOL) += fate-segment-writer-threads-ts
+fate-segment-writer-threads-ts: CMD = background_write "-writer_threads 2" -f lavfi -i testsrc2=s=160x120:d=3:r=10 -c:v mpeg4 -g 5 -flags +bitexact -fflags +bitexact -f segment %b -segment_time 1 -segment_format mpegts -segment_list %o/list.m3u8 %o/%03d.ts
+
+# the mp4 muxer re-opens the segment to move the moov atom to the front
+FATE_SEGMENT_WRITER-$(call ENCMUX, MPEG4, SEGMENT, MP4_MUXER TESTSRC2_FILTER LAVFI_INDEV FILE_PROTOCOL) += fate-segment-writer-threads-mp4
+fate-segment-writer-threads-mp4: CMD = background_write "-writer_threads 2" -f lavfi -i testsrc2=s=160x120:d=3:r=10 -c:v mpeg4 -g 5 -flags +bitexact -fflags +bitexact -f segment %b -segment_time 1 -segment_format mp4 -segment_format_options movflags=+faststart -segment_list %o/list.csv %o/%03d.mp4
+
+FATE_FFMPEG += $(FATE_SEGMENT_WRITER-yes)
+fate-segment-writer-threads: $(FATE_SEGMENT_WRITER-yes)